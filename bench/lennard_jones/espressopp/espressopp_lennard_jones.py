@@ -52,6 +52,8 @@ rc = 2.5
 skin = 0.3
 nvt = False
 timestep = 0.005
+# keep particle arrays, which gives a compressed Verlet list
+particleArrays = True
 
 
 ######################################################################
@@ -69,7 +71,7 @@ system.skin = skin
 comm = MPI.COMM_WORLD
 nodeGrid = decomp.nodeGrid(comm.size)
 cellGrid = decomp.cellGrid(size, nodeGrid, rc, skin)
-system.storage = espressopp.storage.DomainDecomposition(system, nodeGrid, cellGrid)
+system.storage = espressopp.storage.DomainDecomposition(system, nodeGrid, cellGrid, particleArrays=particleArrays)
 
 # add particles to the system and then decompose
 props = ['id', 'type', 'mass', 'pos', 'v']
@@ -111,6 +113,7 @@ print 'rc =', rc
 print 'dt =', integrator.dt
 print 'skin =', system.skin
 print 'nvt =', nvt
+print 'particleArrays =', particleArrays
 print 'steps =', steps
 print 'NodeGrid = %s' % (nodeGrid,)
 print 'CellGrid = %s' % (cellGrid,)
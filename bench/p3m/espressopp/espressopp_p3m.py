@@ -0,0 +1,99 @@
+#!/usr/bin/env python
+
+###########################################################################
+#                                                                         #
+#  This Python script measures the throughput of the charge assignment    #
+#  and the force interpolation of P3M. The k-space part alone is timed    #
+#  for a fixed mesh and a growing number of random ions.                  #
+#                                                                         #
+###########################################################################
+
+import sys
+import time
+import random
+import espressopp
+import mpi4py.MPI as MPI
+from espressopp import Real3D, Int3D
+
+# benchmark parameters
+mesh = 64
+P = 5
+alpha = 1.0
+rspacecutoff = 3.0
+skin = 0.3
+density = 0.1
+ion_numbers = [10000, 20000, 40000, 80000]
+repetitions = 10
+
+
+######################################################################
+### IT SHOULD BE UNNECESSARY TO MAKE MODIFICATIONS BELOW THIS LINE ###
+######################################################################
+def run(num_particles):
+  L = (num_particles / density) ** (1.0 / 3.0)
+  box = (L, L, L)
+  system = espressopp.System()
+  system.rng = espressopp.esutil.RNG()
+  system.bc = espressopp.bc.OrthorhombicBC(system.rng, box)
+  system.skin = skin
+  nodeGrid = espressopp.tools.decomp.nodeGrid(MPI.COMM_WORLD.size)
+  cellGrid = espressopp.tools.decomp.cellGrid(box, nodeGrid, rspacecutoff, skin)
+  system.storage = espressopp.storage.DomainDecomposition(system, nodeGrid, cellGrid)
+
+  random.seed(4711)
+  props = ['id', 'pos', 'type', 'q']
+  new_particles = []
+  for i in range(num_particles):
+    pos = Real3D(random.uniform(0, L), random.uniform(0, L), random.uniform(0, L))
+    new_particles.append([i, pos, 0, 1.0 - 2.0 * (i % 2)])
+  system.storage.addParticles(new_particles, *props)
+  system.storage.decompose()
+
+  p3m_pot = espressopp.interaction.CoulombKSpaceP3M(system, 1.0, alpha, Int3D(mesh, mesh, mesh), P, rspacecutoff)
+  p3m_int = espressopp.interaction.CellListCoulombKSpaceP3M(system.storage, p3m_pot)
+  system.addInteraction(p3m_int)
+
+  integrator = espressopp.integrator.VelocityVerlet(system)
+  integrator.dt = 0.0
+
+  # the first evaluation sets up the FFT plans and the buffers
+  integrator.run(0)
+
+  start_time = time.time()
+  for i in range(repetitions):
+    integrator.run(0)
+  force_time = (time.time() - start_time) / repetitions
+
+  start_time = time.time()
+  for i in range(repetitions):
+    p3m_int.computeEnergy()
+  energy_time = (time.time() - start_time) / repetitions
+
+  return force_time, energy_time
+
+print 'mesh = %d^3, P = %d, CPUs = %d' % (mesh, P, MPI.COMM_WORLD.size)
+print ''
+sys.stdout.write('    ions   force [s]  energy [s]\n')
+results = []
+for n in ion_numbers:
+  force_time, energy_time = run(n)
+  results.append((n, force_time, energy_time))
+  sys.stdout.write('%8d %11.4f %11.4f\n' % (n, force_time, energy_time))
+
+# least squares line t = a + b * n for forces and energies
+def fit(k):
+  nn = [float(r[0]) for r in results]
+  tt = [r[k] for r in results]
+  m = len(nn)
+  mn = sum(nn) / m
+  mt = sum(tt) / m
+  b = sum((x - mn) * (t - mt) for x, t in zip(nn, tt)) / sum((x - mn) ** 2 for x in nn)
+  return mt - b * mn, b
+
+print ''
+for k, name in ((1, 'force'), (2, 'energy')):
+  a, b = fit(k)
+  if b > 0:
+    sys.stdout.write('%-6s: mesh part %.4f s, %.3g ions/s\n' % (name, a, 1.0 / b))
+  else:
+    sys.stdout.write('%-6s: mesh part %.4f s, ion part not resolved\n' % (name, a))
@@ -0,0 +1,79 @@
+#!/usr/bin/env python
+# -*- coding: iso-8859-1 -*-
+
+###########################################################################
+#                                                                         #
+#  ESPResSo++ Benchmark Python script for the Verlet list rebuild of a    #
+#  polymer melt with bonded exclusions                                    #
+#                                                                         #
+###########################################################################
+
+import sys
+import time
+import espressopp
+import mpi4py.MPI as MPI
+from espressopp import Real3D
+from espressopp.tools.convert import lammps
+from espressopp.tools import decomp, replicate
+
+# benchmark parameters
+rebuilds = 100
+rc = 1.12
+skin = 0.3
+# exclude the 1-2 (bond) and 1-3 (angle) pairs
+exclude13 = True
+particleArrays = False
+
+
+######################################################################
+### IT SHOULD BE UNNECESSARY TO MAKE MODIFICATIONS BELOW THIS LINE ###
+######################################################################
+sys.stdout.write('Setting up simulation ...\n')
+bonds, angles, x, y, z, Lx, Ly, Lz = lammps.read('espressopp_polymer_melt.start')
+bonds, angles, x, y, z, Lx, Ly, Lz = replicate(bonds, angles, x, y, z, Lx, Ly, Lz, xdim=1, ydim=1, zdim=1)
+num_particles = len(x)
+size = (Lx, Ly, Lz)
+system = espressopp.System()
+system.rng = espressopp.esutil.RNG()
+system.bc = espressopp.bc.OrthorhombicBC(system.rng, size)
+system.skin = skin
+comm = MPI.COMM_WORLD
+nodeGrid = decomp.nodeGrid(comm.size)
+cellGrid = decomp.cellGrid(size, nodeGrid, rc, skin)
+system.storage = espressopp.storage.DomainDecomposition(system, nodeGrid, cellGrid, particleArrays=particleArrays)
+
+props = ['id', 'type', 'mass', 'pos']
+new_particles = []
+for i in range(num_particles):
+  new_particles.append([i + 1, 0, 1.0, Real3D(x[i], y[i], z[i])])
+system.storage.addParticles(new_particles, *props)
+system.storage.decompose()
+
+exclusions = list(bonds)
+if exclude13:
+  exclusions += [(a[0], a[2]) for a in angles]
+
+setup_start = time.time()
+vl = espressopp.VerletList(system, cutoff=rc + system.skin, exclusionlist=exclusions)
+setup_time = time.time() - setup_start
+
+print ''
+print 'number of particles =', num_particles
+print 'number of exclusions =', len(exclusions)
+print 'rc =', rc
+print 'skin =', system.skin
+print 'particleArrays =', particleArrays
+print 'NodeGrid = %s' % (nodeGrid,)
+print 'CellGrid = %s' % (cellGrid,)
+print ''
+
+start_time = time.time()
+for i in range(rebuilds):
+  vl.rebuild()
+end_time = time.time()
+
+sys.stdout.write('Total # of neighbors = %d\n' % vl.totalSize())
+sys.stdout.write('Ave neighs/atom = %.1f\n' % (vl.totalSize() / float(num_particles)))
+sys.stdout.write('Setup of the list with exclusions = %.3f s\n' % setup_time)
+sys.stdout.write('Rebuilds = %d\n' % rebuilds)
+sys.stdout.write('Time per rebuild = %.4f s\n' % ((end_time - start_time) / rebuilds))
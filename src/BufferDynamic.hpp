@@ -30,6 +30,8 @@
 #include <vector>
 #include <boost/shared_ptr.hpp>
 #include <stdexcept>
+#include <sstream>
+#include <cstring>
 
 /** Initial buffer size for incoming and outgoing messages 
     should fit for smaller messages
@@ -72,6 +74,16 @@ namespace espressopp {
       pos      = 0;
     }
 
+    /** size in bytes of one particle written with the given extra data */
+    static int particleDataSize(int extradata)
+    {
+      int size = sizeof(ParticlePosition);
+      if (extradata & DATA_PROPERTIES) size += sizeof(ParticleProperties);
+      if (extradata & DATA_MOMENTUM) size += sizeof(ParticleMomentum);
+      if (extradata & DATA_LOCAL) size += sizeof(ParticleLocal);
+      return size;
+    }
+
   protected:
 
     static LOG4ESPP_DECL_LOGGER(logger);
@@ -93,7 +105,7 @@ namespace espressopp {
        // fprintf(stderr, "realloc buffer from %d to capacity %d, used size = %d\n", capacity, size, usedSize);
        capacity = size;
        char* newBuf = new char[capacity];
-       for (int i = 0; i < usedSize; i++) newBuf[i] = buf[i];
+       std::memcpy(newBuf, buf, usedSize);
        dynBuf.reset(newBuf);
        buf = dynBuf.get();
     }
@@ -119,9 +131,9 @@ namespace espressopp {
       pos += sizeof(T);
       //std::cout << comm.rank() << ": read pos: " << pos << ", usedSize: " << usedSize << "\n";
       if (pos > usedSize) {
-        fprintf(stderr, "%d: read at pos %d: size %d insufficient\n", comm.rank(), pos, usedSize);
-        exit(-1);
-        return;
+        std::ostringstream msg;
+        msg << comm.rank() << ": read at pos " << pos << ": size " << usedSize << " insufficient";
+        throw std::runtime_error(msg.str());
       }
       val = *tbuf; 
     }
@@ -203,6 +215,18 @@ namespace espressopp {
       // printf("%d: received size = %d from %d\n", comm.rank(), size, sender);
     }
 
+    /** receive a message whose size is known beforehand, so that
+        there is no need to probe for it */
+    void recv(longint sender, int tag, int msgSize) {
+      if (msgSize > capacity) {
+        allocate(msgSize);
+      }
+      mpi::status stat = comm.recv(sender, tag, buf, msgSize);
+      usedSize = msgSize;
+      pos      = 0;   // reset the buffer position
+      checkReceived(stat);
+    }
+
     mpi::request irecv(longint sender, int tag) {
       // blocking test for the incomming message
       mpi::status stat = comm.probe(sender, tag);
@@ -222,6 +246,25 @@ namespace espressopp {
       return req;
     }
 
+    /** nonblocking receive of a message whose size is known beforehand,
+        so that there is no need to probe for it */
+    mpi::request irecv(longint sender, int tag, int msgSize) {
+      if (msgSize > capacity) {
+        allocate(msgSize);
+      }
+      mpi::request req = comm.irecv(sender, tag, buf, msgSize);
+      usedSize = msgSize;
+      pos      = 0;   // reset the buffer position
+      return req;
+    }
+
+    /** check that a receive with known size got a message of that size */
+    void checkReceived(const mpi::status &stat) const {
+      if (*stat.count<char>() != usedSize) {
+        throw std::runtime_error("InBuffer: received message does not have the expected size");
+      }
+    }
+
   };
 
   class OutBuffer : public Buffer {
@@ -115,7 +115,7 @@ namespace espressopp {
     
     if(returnVal){
       // add the pair locally
-      this->add(p1, p2);
+      addLocal(p1, p2, pid1, pid2);
       // ADD THE GLOBAL PAIR
       // see whether the particle already has pairs
       std::pair<GlobalPairs::const_iterator,
@@ -222,13 +222,27 @@ namespace espressopp {
     LOG4ESPP_INFO(theLogger, "received fixed pair list after receive particles");
   }
 
+  void FixedPairList::addLocal(Particle *p1, Particle *p2, longint pid1, longint pid2) {
+    this->add(p1, p2);
+    LocalIds ids = { pid1, pid2, !p2 || p2->ghost() };
+    localIds.push_back(ids);
+  }
+
   void FixedPairList::onParticlesChanged() {
+    // after a decompose() only the changed particles have to be looked up
+    const boost::unordered_set<longint> *changed = storage->getChangedParticles();
+    if (changed && localIds.size() == PairList::size()) {
+      updateLocalPairs(*changed);
+      return;
+    }
+
     LOG4ESPP_INFO(theLogger, "rebuild local bond list from global\n");
 
     System& system = storage->getSystemRef();
     esutil::Error err(system.comm);
     
     this->clear();
+    localIds.clear();
     longint lastpid1 = -1;
     Particle *p1;
     Particle *p2;
@@ -250,13 +264,68 @@ namespace espressopp {
           //std::runtime_error(err.str());
           err.setException( msg.str() );
       }
-      this->add(p1, p2);
+      addLocal(p1, p2, it->first, it->second);
     }
     err.checkException();
     
     LOG4ESPP_INFO(theLogger, "regenerated local fixed pair list from global list");
   }
 
+  /* The pairs of unchanged real particles keep their first pointer, and
+     also the second one unless the partner has changed or is a ghost,
+     since all ghosts are recreated by decompose(). The pairs of changed
+     particles are dropped and taken again from globalPairs for those
+     that are real particles here now, which includes the received ones. */
+  void FixedPairList::updateLocalPairs(const boost::unordered_set<longint>& changed) {
+    LOG4ESPP_INFO(theLogger, "update local bond list for " << changed.size() << " changed particles");
+
+    System& system = storage->getSystemRef();
+    esutil::Error err(system.comm);
+
+    size_t n = 0;
+    for (size_t i = 0, end = localIds.size(); i < end; ++i) {
+      LocalIds ids = localIds[i];
+      if (changed.count(ids.pid1)) continue;
+
+      Particle *p2 = (*this)[i].second;
+      if (ids.ghost || changed.count(ids.pid2)) {
+        p2 = storage->lookupLocalParticle(ids.pid2);
+        if (p2 == NULL) {
+          std::stringstream msg;
+          msg << "onParticlesChanged error. Fixed Pair List particle p2 " << ids.pid2 << " does not exists here";
+          err.setException( msg.str() );
+        }
+        ids.ghost = !p2 || p2->ghost();
+      }
+      (*this)[n] = ParticlePair((*this)[i].first, p2);
+      localIds[n] = ids;
+      ++n;
+    }
+    PairList::resize(n);
+    localIds.resize(n);
+
+    for (boost::unordered_set<longint>::const_iterator cit = changed.begin(); cit != changed.end(); ++cit) {
+      Particle *p1 = storage->lookupRealParticle(*cit);
+      // sent away
+      if (p1 == NULL) continue;
+
+      std::pair<GlobalPairs::const_iterator,
+        GlobalPairs::const_iterator> equalRange = globalPairs.equal_range(*cit);
+      for (GlobalPairs::const_iterator it = equalRange.first; it != equalRange.second; ++it) {
+        Particle *p2 = storage->lookupLocalParticle(it->second);
+        if (p2 == NULL) {
+          std::stringstream msg;
+          msg << "onParticlesChanged error. Fixed Pair List particle p2 " << it->second << " does not exists here";
+          err.setException( msg.str() );
+        }
+        addLocal(p1, p2, it->first, it->second);
+      }
+    }
+    err.checkException();
+
+    LOG4ESPP_INFO(theLogger, "updated local fixed pair list, " << n << " pairs kept");
+  }
+
   /****************************************************
   ** REGISTRATION WITH PYTHON
   ****************************************************/
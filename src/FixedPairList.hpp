@@ -30,6 +30,7 @@
 #include "Particle.hpp"
 #include "esutil/ESPPIterator.hpp"
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 #include <boost/signals2.hpp>
 
 //#include "FixedListComm.hpp"
@@ -76,6 +77,14 @@ namespace espressopp {
 	    static void registerPython();
 
 	  private:
+		  /** ids of the local pairs, in the order of the PairList, and
+		      whether the second particle was looked up as a ghost */
+		  struct LocalIds { longint pid1, pid2; bool ghost; };
+		  std::vector<LocalIds> localIds;
+
+		  void addLocal(Particle *p1, Particle *p2, longint pid1, longint pid2);
+		  void updateLocalPairs(const boost::unordered_set<longint>& changed);
+
 		  static LOG4ESPP_DECL_LOGGER(theLogger);
 	};
 }
@@ -125,7 +125,7 @@ namespace espressopp {
     
     if(returnVal){
       // add the triple locally
-      this->add(p1, p2, p3);
+      addLocal(p1, p2, p3, pid1, pid2, pid3);
       //printf("me = %d: pid1 %d, pid2 %d, pid3 %d\n", mpiWorld->rank(), pid1, pid2, pid3);
 
       // ADD THE GLOBAL TRIPLET
@@ -239,14 +239,28 @@ namespace espressopp {
     LOG4ESPP_INFO(theLogger, "received fixed triple list after receive particles");
   }
 
+  void FixedTripleList::addLocal(Particle *p1, Particle *p2, Particle *p3,
+                                 longint pid1, longint pid2, longint pid3) {
+    this->add(p1, p2, p3);
+    LocalIds ids = { pid1, pid2, pid3, !p1 || p1->ghost(), !p3 || p3->ghost() };
+    localIds.push_back(ids);
+  }
+
   void FixedTripleList::onParticlesChanged() {
-    
+    // after a decompose() only the changed particles have to be looked up
+    const boost::unordered_set<longint> *changed = storage->getChangedParticles();
+    if (changed && localIds.size() == TripleList::size()) {
+      updateLocalTriples(*changed);
+      return;
+    }
+
     System& system = storage->getSystemRef();
     esutil::Error err(system.comm);
     
     // (re-)generate the local triple list from the global list
     //printf("FixedTripleList: rebuild local triple list from global\n");
     this->clear();
+    localIds.clear();
     longint lastpid2 = -1;
     Particle *p1;
     Particle *p2;
@@ -275,13 +289,71 @@ namespace espressopp {
         msg << "triple particle p3 " << it->second.second << " does not exists here";
         err.setException( msg.str() );
       }
-      this->add(p1, p2, p3);
+      addLocal(p1, p2, p3, it->second.first, it->first, it->second.second);
     }
     err.checkException();
     
     LOG4ESPP_INFO(theLogger, "regenerated local fixed triple list from global list");
   }
 
+  namespace {
+    Particle *lookupOuter(storage::Storage &storage, longint pid, const char *name, esutil::Error &err) {
+      Particle *p = storage.lookupLocalParticle(pid);
+      if (p == NULL) {
+        std::stringstream msg;
+        msg << "triple particle " << name << " " << pid << " does not exists here";
+        err.setException( msg.str() );
+      }
+      return p;
+    }
+  }
+
+  /* Same as FixedPairList::updateLocalPairs(), the triples are owned by
+     the middle particle. */
+  void FixedTripleList::updateLocalTriples(const boost::unordered_set<longint>& changed) {
+    System& system = storage->getSystemRef();
+    esutil::Error err(system.comm);
+
+    size_t n = 0;
+    for (size_t i = 0, end = localIds.size(); i < end; ++i) {
+      LocalIds ids = localIds[i];
+      if (changed.count(ids.pid2)) continue;
+
+      ParticleTriple t = (*this)[i];
+      if (ids.ghost1 || changed.count(ids.pid1)) {
+        t.first = lookupOuter(*storage, ids.pid1, "p1", err);
+        ids.ghost1 = !t.first || t.first->ghost();
+      }
+      if (ids.ghost3 || changed.count(ids.pid3)) {
+        t.third = lookupOuter(*storage, ids.pid3, "p3", err);
+        ids.ghost3 = !t.third || t.third->ghost();
+      }
+      (*this)[n] = t;
+      localIds[n] = ids;
+      ++n;
+    }
+    TripleList::resize(n);
+    localIds.resize(n);
+
+    for (boost::unordered_set<longint>::const_iterator cit = changed.begin(); cit != changed.end(); ++cit) {
+      Particle *p2 = storage->lookupRealParticle(*cit);
+      // sent away
+      if (p2 == NULL) continue;
+
+      std::pair<GlobalTriples::const_iterator,
+                GlobalTriples::const_iterator> equalRange = globalTriples.equal_range(*cit);
+      for (GlobalTriples::const_iterator it = equalRange.first; it != equalRange.second; ++it) {
+        Particle *p1 = lookupOuter(*storage, it->second.first, "p1", err);
+        Particle *p3 = lookupOuter(*storage, it->second.second, "p3", err);
+        addLocal(p1, p2, p3, it->second.first, it->first, it->second.second);
+      }
+    }
+    err.checkException();
+
+    LOG4ESPP_INFO(theLogger, "updated local fixed triple list for " << changed.size()
+                  << " changed particles, " << n << " triples kept");
+  }
+
   /****************************************************
   ** REGISTRATION WITH PYTHON
   ****************************************************/
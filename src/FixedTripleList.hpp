@@ -30,6 +30,7 @@
 #include "Particle.hpp"
 #include "esutil/ESPPIterator.hpp"
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 #include <boost/signals2.hpp>
 //#include "FixedListComm.hpp"
 
@@ -70,6 +71,15 @@ namespace espressopp {
 	
 
 	  private:
+		/** ids of the local triples, in the order of the TripleList, and
+		    whether the outer particles were looked up as ghosts */
+		struct LocalIds { longint pid1, pid2, pid3; bool ghost1, ghost3; };
+		std::vector<LocalIds> localIds;
+
+		void addLocal(Particle *p1, Particle *p2, Particle *p3,
+		              longint pid1, longint pid2, longint pid3);
+		void updateLocalTriples(const boost::unordered_set<longint>& changed);
+
 		static LOG4ESPP_DECL_LOGGER(theLogger);
 
 
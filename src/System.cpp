@@ -28,6 +28,7 @@
 #include "esutil/RNG.hpp"
 #include "mpi.hpp"
 #include "esutil/Error.hpp"
+#include "esutil/Threads.hpp"
 
 #include <limits>
 
@@ -47,6 +48,7 @@ namespace espressopp {
     CommunicatorIsInitialized = false;
     
     maxCutoff = 0.0;
+    numThreads = 1;
   }
 
   System::System(python::object _pyobj) {
@@ -71,27 +73,46 @@ namespace espressopp {
 
     comm = newcomm;
     maxCutoff = 0.0;
+    numThreads = 1;
   }
 
-  void System::setSkin(real _skin){
+  bool System::setSkin(real _skin){
     skin = _skin;
     if(storage){
-      // TODO !! It may give an error for decompositions different from 
-      // DomainDecomposition
-      // probably function getInt3DCellGrid() should be pure virtual in Storage
-      Int3D cellGr = storage->getInt3DCellGrid();
-      real cs = maxCutoff + skin;
-      if( cs > std::min( std::min( cellGr[0], cellGr[1]), cellGr[2] ) ){
+      // the cells have to be at least cutoff + skin wide on all nodes, and
+      // cellAdjust() is collective, so all nodes have to take the same decision
+      real minCellSize;
+      mpi::all_reduce(*comm, storage->getMinCellSize(), minCellSize, boost::mpi::minimum<real>());
+      if (maxCutoff + skin > minCellSize) {
         storage -> cellAdjust();
+        return true;
       }
     }
     //storage -> decompose();  // it's not nessesary because at the end of cellAdjust()
                                // the signal onParticlesChanged is sent
+    return false;
   }
   real System::getSkin(){
     return skin;
   }
 
+  void System::setNumThreads(int _numThreads){
+    esutil::Error err(comm);
+    if (_numThreads < 1) {
+      std::stringstream msg;
+      msg << "the number of threads has to be at least 1, not " << _numThreads;
+      err.setException( msg.str() );
+    }
+    err.checkException();
+
+    if (_numThreads > 1 && !esutil::haveThreads()) {
+      std::cout << "Warning! ESPResSo++ was compiled without OpenMP, "
+                << "the number of threads stays 1." << std::endl;
+      _numThreads = 1;
+    }
+    numThreads = _numThreads;
+  }
+
   void System::addInteraction(shared_ptr< interaction::Interaction > ia){
     shortRangeInteractions.push_back(ia);
     
@@ -196,6 +217,7 @@ namespace espressopp {
 
     class_< System > ("System", init<>())
       .add_property("skin", &System::getSkin, &System::setSkin)
+      .add_property("numThreads", &System::getNumThreads, &System::setNumThreads)
     
       .def(init< python::object >())
       .def_readwrite("storage", &System::storage)
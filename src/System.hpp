@@ -40,6 +40,7 @@ namespace espressopp {
   
   private:
     real skin;  //<! skin used for VerletList
+    int numThreads;  //<! threads per rank used by the force loops
     
   public:
 
@@ -62,8 +63,16 @@ namespace espressopp {
       return shared_from_this();
     }
     
-    void setSkin(real);
+    /** returns whether the cell grid was adjusted to the new skin, which
+        also redistributes the particles like Storage::decompose() */
+    bool setSkin(real);
     real getSkin();
+
+    /** Set the number of threads each rank uses in the force, energy
+        and virial loops of the interactions. Values above 1 require
+        that the code was compiled with OpenMP. */
+    void setNumThreads(int);
+    int getNumThreads() const { return numThreads; }
     
     void scaleVolume(real s, bool particleCoordinates);
     void scaleVolume(Real3D s, bool particleCoordinates);
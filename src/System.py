@@ -41,6 +41,9 @@ In detail the System class holds pointers to:
 * the boundary conditions `bc` for the system (e.g. OrthorhombicBC)
 * a random number generator `rng` which is for example used by a thermostat
 * the `skin` which is needed for the Verlet lists and the cell grid
+* `numThreads`, the number of threads each MPI rank uses in the force,
+  energy and virial loops of the interactions (default 1, values above 1
+  need a build with -DWITH_OPENMP=ON)
 * a list of short range interactions that apply to the system these
   interactions are added with the `addInteraction()` method of the System
 
@@ -220,7 +223,7 @@ if pmi.isController:
     __metaclass__ = pmi.Proxy
     pmiproxydefs = dict(
       cls = 'espressopp.SystemLocal',
-      pmiproperty = ['storage', 'bc', 'rng', 'skin', 'maxCutoff', 'integrator'],
+      pmiproperty = ['storage', 'bc', 'rng', 'skin', 'numThreads', 'maxCutoff', 'integrator'],
       pmicall = ['addInteraction','removeInteraction', 'removeInteractionByName',
             'getInteraction', 'getNumberOfInteractions','scaleVolume', 'setTrace',
             'getAllInteractions', 'getInteractionByName']
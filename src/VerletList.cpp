@@ -21,6 +21,7 @@
 */
 
 #include "python.hpp"
+#include <algorithm>
 #include "VerletList.hpp"
 #include "Real3D.hpp"
 #include "Particle.hpp"
@@ -51,6 +52,9 @@ namespace espressopp {
     cutVerlet = cut + system -> getSkin();
     cutsq = cutVerlet * cutVerlet;
     builds = 0;
+    compressed = false;
+    pairsValid = false;
+    layoutVersion = 0;
 
     if (rebuildVL) rebuild(); // not called if exclutions are provided
 
@@ -88,24 +92,153 @@ namespace espressopp {
     cutsq = cutVerlet * cutVerlet;
     
     vlPairs.clear();
+    nbOffset.clear();
+    nbGhost.clear();
+    nbIndex.clear();
+    pairsValid = false;
 
-    // add particles to adress zone
-    CellList cl = getSystem()->storage->getRealCells();
-    LOG4ESPP_DEBUG(theLogger, "local cell list size = " << cl.size());
-    for (CellListAllPairsIterator it(cl); it.isValid(); ++it) {
-      checkPair(*it->first, *it->second);
-      LOG4ESPP_DEBUG(theLogger, "checking particles " << it->first->id() << " and " << it->second->id());
+    compressed = getSystem()->storage->hasParticleArrays();
+    if (compressed) {
+      rebuildCompressed();
+    } else {
+      // add particles to adress zone
+      CellList cl = getSystem()->storage->getRealCells();
+      LOG4ESPP_DEBUG(theLogger, "local cell list size = " << cl.size());
+      // the first particle changes rarely, so look up its exclusions once
+      Particle *last = 0;
+      const Exclusions *ex = 0;
+      for (CellListAllPairsIterator it(cl); it.isValid(); ++it) {
+        if (it->first != last) {
+          last = it->first;
+          ex = getExclusions(last->id());
+        }
+        checkPair(*it->first, *it->second, ex);
+        LOG4ESPP_DEBUG(theLogger, "checking particles " << it->first->id() << " and " << it->second->id());
+      }
     }
     
     builds++;
     LOG4ESPP_DEBUG(theLogger, "rebuilt VerletList (count=" << builds << "), cutsq = " << cutsq
-                 << " local size = " << vlPairs.size());
+                 << " local size = " << localSize());
+  }
+
+  /*-------------------------------------------------------------*/
+
+  void VerletList::rebuildCompressed()
+  {
+    storage::Storage &storage = *getSystem()->storage;
+    storage::ParticleArrays &pa = storage.getParticleArrays();
+    const Cell *firstCell = storage.getFirstCell();
+    longint n = pa.size();
+
+    layoutVersion = pa.getLayoutVersion();
+    nbOffset.resize(n + 1);
+    nbGhost.resize(n + 1);
+    if (n == 0) {
+      nbOffset[0] = nbGhost[0] = 0;
+      return;
+    }
+
+    // visit the real cells in the order of the arrays, so that the
+    // offsets are ascending; ghosts get empty ranges
+    std::vector< std::pair< longint, Cell* > > real;
+    CellList &realCells = storage.getRealCells();
+    real.reserve(realCells.size());
+    for (CellList::Iterator it(realCells); it.isValid(); ++it) {
+      real.push_back(std::make_pair(longint(*it - firstCell), *it));
+    }
+    std::sort(real.begin(), real.end());
+
+    std::vector< char > ghostCell(storage.getLocalCells().size(), 0);
+    CellList &ghostCells = storage.getGhostCells();
+    for (CellList::Iterator it(ghostCells); it.isValid(); ++it) {
+      ghostCell[*it - firstCell] = 1;
+    }
+
+    const Real3D *pos = &pa.position[0];
+    longint next = 0;
+    for (size_t k = 0; k < real.size(); ++k) {
+      longint c = real[k].first;
+      Cell &cell = *real[k].second;
+      longint end = pa.cellEnd(c);
+
+      for (longint i = pa.cellBegin(c); i < end; ++i) {
+        while (next <= i) {
+          nbOffset[next] = nbGhost[next] = nbIndex.size();
+          ++next;
+        }
+
+        const Real3D pi = pos[i];
+        const Exclusions *ex = getExclusions(pa.particle[i]->id());
+
+        // same pairs as CellListAllPairsIterator
+        for (longint j = i + 1; j < end; ++j) {
+          if ((pi - pos[j]).sqr() > cutsq) continue;
+          if (ex && isExcluded(ex, pa.particle[j]->id())) continue;
+          nbIndex.push_back(j);
+        }
+
+        // neighbors in real cells first, so that the pairs with ghosts
+        // form the tail of the range
+        for (char ghost = 0; ghost < 2; ++ghost) {
+          if (ghost) nbGhost[i] = nbIndex.size();
+          for (NeighborCellList::Iterator ncit(cell.neighborCells); ncit.isValid(); ++ncit) {
+            if (ncit->useForAllPairs) continue;
+            longint nc = ncit->cell - firstCell;
+            if (ghostCell[nc] != ghost) continue;
+            for (longint j = pa.cellBegin(nc), nend = pa.cellEnd(nc); j < nend; ++j) {
+              if ((pi - pos[j]).sqr() > cutsq) continue;
+              if (ex && isExcluded(ex, pa.particle[j]->id())) continue;
+              nbIndex.push_back(j);
+            }
+          }
+        }
+      }
+    }
+    while (next <= n) {
+      nbOffset[next] = nbGhost[next] = nbIndex.size();
+      ++next;
+    }
+  }
+
+  /*-------------------------------------------------------------*/
+
+  bool VerletList::isCompressed()
+  {
+    if (compressed &&
+        layoutVersion != getSystem()->storage->getParticleArrays().getLayoutVersion()) {
+      LOG4ESPP_DEBUG(theLogger, "particle arrays have changed, rebuilding VerletList");
+      rebuild();
+    }
+    return compressed;
+  }
+
+  bool VerletList::isCompressedCurrent() const
+  {
+    return compressed &&
+      layoutVersion == getSystem()->storage->getParticleArrays().getLayoutVersion();
+  }
+
+  PairList& VerletList::getPairs()
+  {
+    if (isCompressed() && !pairsValid) {
+      storage::ParticleArrays &pa = getSystem()->storage->getParticleArrays();
+      vlPairs.clear();
+      vlPairs.reserve(nbIndex.size());
+      for (longint i = 0, n = nbOffset.size() - 1; i < n; ++i) {
+        for (longint k = nbOffset[i]; k < nbOffset[i + 1]; ++k) {
+          vlPairs.add(pa.particle[i], pa.particle[nbIndex[k]]);
+        }
+      }
+      pairsValid = true;
+    }
+    return vlPairs;
   }
   
 
   /*-------------------------------------------------------------*/
   
-  void VerletList::checkPair(Particle& pt1, Particle& pt2)
+  void VerletList::checkPair(Particle& pt1, Particle& pt2, const Exclusions *ex1)
   {
 
     Real3D d = pt1.position() - pt2.position();
@@ -118,12 +251,33 @@ namespace espressopp {
 
     if (distsq > cutsq) return;
 
-    // see if it's in the exclusion list (both directions)
-    if (exList.count(std::make_pair(pt1.id(), pt2.id())) == 1) return;
-    if (exList.count(std::make_pair(pt2.id(), pt1.id())) == 1) return;
+    // see if it's in the exclusion list (stored in both directions)
+    if (ex1 && isExcluded(ex1, pt2.id())) return;
 
     vlPairs.add(pt1, pt2); // add pair to Verlet List
   }
+
+  const VerletList::Exclusions *VerletList::getExclusions(longint pid) const
+  {
+    if (exList.empty()) return 0;
+    boost::unordered_map< longint, Exclusions >::const_iterator it = exList.find(pid);
+    return it == exList.end() ? 0 : &it->second;
+  }
+
+  bool VerletList::isExcluded(const Exclusions *ex, longint pid)
+  {
+    const longint *e = &(*ex)[0];
+    size_t n = ex->size();
+    if (n > 16) {
+      return std::binary_search(e, e + n, pid);
+    }
+    // bonded neighbours are few, a scan without early exit is cheapest
+    bool found = false;
+    for (size_t k = 0; k < n; ++k) {
+      found |= (e[k] == pid);
+    }
+    return found;
+  }
   
   /*-------------------------------------------------------------*/
   
@@ -139,11 +293,12 @@ namespace espressopp {
 
   int VerletList::localSize() const
   {
-    System& system = getSystemRef();
+    if (compressed) return nbIndex.size();
     return vlPairs.size();
   }
 
   python::tuple VerletList::getPair(int i) {
+	  PairList &vlPairs = getPairs();
 	  if (i <= 0 || i > vlPairs.size()) {
 	    std::cout << "ERROR VerletList pair " << i << " does not exists" << std::endl;
 	    return python::make_tuple();
@@ -155,7 +310,13 @@ namespace espressopp {
 
   bool VerletList::exclude(longint pid1, longint pid2) {
 
-      exList.insert(std::make_pair(pid1, pid2));
+      Exclusions &ex1 = exList[pid1];
+      Exclusions::iterator it = std::lower_bound(ex1.begin(), ex1.end(), pid2);
+      if (it == ex1.end() || *it != pid2) ex1.insert(it, pid2);
+
+      Exclusions &ex2 = exList[pid2];
+      it = std::lower_bound(ex2.begin(), ex2.end(), pid1);
+      if (it == ex2.end() || *it != pid1) ex2.insert(it, pid1);
 
       return true;
   }
@@ -30,7 +30,8 @@
 #include "Particle.hpp"
 #include "SystemAccess.hpp"
 #include "boost/signals2.hpp"
-#include "boost/unordered_set.hpp"
+#include "boost/unordered_map.hpp"
+#include <vector>
 
 namespace espressopp {
 
@@ -56,7 +57,29 @@ namespace espressopp {
 
     ~VerletList();
 
-    PairList& getPairs() { return vlPairs; }
+    /** Get the list of pairs. If the list is kept in the compressed
+        layout, the pairs are created from it on first access. */
+    PairList& getPairs();
+
+    /** Whether the list is kept in the compressed (CSR) layout, which is
+        the case if the storage provides particle arrays. Then the
+        neighbors of local index i are
+        getNeighborIndices()[getNeighborOffsets()[i] .. getNeighborOffsets()[i+1]),
+        each pair stored once. A list built for an outdated layout of
+        the particle arrays is rebuilt first. */
+    bool isCompressed();
+
+    /** Whether the list is in the compressed layout and up to date with
+        the particle arrays, i.e. isCompressed() would not rebuild it. */
+    bool isCompressedCurrent() const;
+
+    const std::vector< longint >& getNeighborOffsets() const { return nbOffset; }
+
+    /** In the compressed layout, the neighbors of i that are ghosts come
+        last, starting at getGhostNeighborOffsets()[i]. */
+    const std::vector< longint >& getGhostNeighborOffsets() const { return nbGhost; }
+
+    const std::vector< int >& getNeighborIndices() const { return nbIndex; }
 
     python::tuple getPair(int i);
     
@@ -88,9 +111,28 @@ namespace espressopp {
 
   protected:
 
-    void checkPair(Particle &pt1, Particle &pt2);
+    typedef std::vector< longint > Exclusions;
+
+    void checkPair(Particle &pt1, Particle &pt2, const Exclusions *ex1);
+    /** excluded partners of a particle, 0 if it has none */
+    const Exclusions *getExclusions(longint pid) const;
+    static bool isExcluded(const Exclusions *ex, longint pid);
+    void rebuildCompressed();
+
     PairList vlPairs;
-    boost::unordered_set<std::pair<longint, longint> > exList; // exclusion list
+    // exclusion list: sorted partners per particle id, in both directions.
+    // As it is keyed by the global ids, it stays valid when particles move
+    // between cells or nodes.
+    boost::unordered_map< longint, Exclusions > exList;
+
+    // compressed layout: per local index an offset into the 32 bit
+    // neighbor indices
+    bool compressed;
+    bool pairsValid;    // vlPairs was created from the compressed layout
+    int layoutVersion;  // of the particle arrays the list was built for
+    std::vector< longint > nbOffset;
+    std::vector< longint > nbGhost;
+    std::vector< int > nbIndex;
     
     real cutsq;
     real cut;
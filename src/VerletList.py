@@ -34,6 +34,11 @@ r"""
 		:type cutoff: 
 		:type exclusionlist: 
 
+		If the storage keeps particle arrays (see
+		:class:`espressopp.storage.DomainDecomposition`), the list is stored
+		in a compressed layout: per particle the 32 bit indices of its
+		neighbors in the particle arrays.
+
 .. function:: espressopp.VerletList.exclude(exclusionlist)
 
 		:param exclusionlist: 
@@ -116,6 +121,6 @@ if pmi.isController:
     pmiproxydefs = dict(
       cls = 'espressopp.VerletListLocal',
       pmiproperty = [ 'builds' ],
-      pmicall = [ 'totalSize', 'exclude', 'connect', 'disconnect', 'getVerletCutoff' ],
+      pmicall = [ 'totalSize', 'exclude', 'rebuild', 'connect', 'disconnect', 'getVerletCutoff' ],
       pmiinvoke = [ 'getAllPairs' ]
     )
@@ -47,21 +47,15 @@ namespace espressopp {
       if (!system->storage) {
          throw std::runtime_error("system has no storage");
       }
-      skin = system->getSkin();
-      cutverlet = cut + skin;
-      cutsq = cutverlet * cutverlet;
+      this->cut = cut;
+      this->adrCut = adrCut;
       builds = 0;
 
       // AdResS stuff
-      //skin = system->getSkin();
       dEx = _dEx;
       dHy = _dHy;
       adrCenterSet = false;
-      real adressSize = dEx + dHy + skin; // adress region size
-      if (dEx + dHy == 0) adressSize = 0; // 0 should be 0
-      adrsq = adressSize * adressSize;
-      adrCutverlet = adrCut + skin;
-      adrcutsq = adrCutverlet*adrCutverlet;
+      setSkin(system->getSkin());
 
       //std::cout << getSystem()->comm->rank() << ": " << "------constructor----- \n";
       if (rebuildVL) rebuild(); // not called if exclutions are provided
@@ -92,8 +86,23 @@ namespace espressopp {
        }
     }*/
 
+    void VerletListAdress::setSkin(real _skin)
+    {
+      skin = _skin;
+      cutverlet = cut + skin;
+      cutsq = cutverlet * cutverlet;
+      real adressSize = dEx + dHy + skin; // adress region size
+      if (dEx + dHy == 0) adressSize = 0; // 0 should be 0
+      adrsq = adressSize * adressSize;
+      adrCutverlet = adrCut + skin;
+      adrcutsq = adrCutverlet*adrCutverlet;
+    }
+
     void VerletListAdress::rebuild()
     {
+      // the skin may have been changed since the last build
+      setSkin(getSystemRef().getSkin());
+
       vlPairs.clear();
       adrZone.clear(); // particles in adress zone
       cgZone.clear(); // particles in CG zone
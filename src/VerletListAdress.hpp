@@ -106,6 +106,7 @@ namespace espressopp {
     real dEx, dHy; // size of the expicit and hybrid zone
     real adrsq, adrcutsq, adrCutverlet, cutverlet;
     real skin;
+    real cut, adrCut; // cutoffs without the skin
     Real3D adrCenter; // center of adress zone, if set (either adrCenter or adrList should be set)
     bool adrCenterSet; // tells if adrCenter is set
     bool sphereAdr; // true: adress region is spherical centered on point x,y,z or particle pid; false: adress region is slab centered on point x or particle pid
@@ -114,6 +115,9 @@ namespace espressopp {
     //void isPairInAdrZone(Particle &pt1, Particle &pt2); // not used anymore
 
 
+    /** derive the Verlet cutoffs and the AdResS zone from the skin */
+    void setSkin(real _skin);
+
     void checkPair(Particle &pt1, Particle &pt2);
     PairList vlPairs;
     boost::unordered_set<std::pair<longint, longint> > exList; // exclusion list
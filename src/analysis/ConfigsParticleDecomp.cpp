@@ -89,13 +89,20 @@ namespace espressopp {
         }
       }
 
-      ConfigurationPtr config = make_shared<Configuration> ();
+      // every cpu keeps the particles it is responsible for
+      vector<size_t> myIds;
+      vector<Real3D> myProps;
       for (int rank_i=0; rank_i<nprocs; rank_i++) {
-        map< size_t, Real3D > conf;
+        int numLocPart = (rank_i == myrank) ? localN : 0;
+        boost::mpi::broadcast(*system.comm, numLocPart, rank_i);
+
+        vector<size_t> ids(numLocPart);
+        vector<Real3D> props(numLocPart);
         if (rank_i == myrank) {
+          int i = 0;
           CellList realCells = system.storage->getRealCells();
-          for(CellListIterator cit(realCells); !cit.isDone(); ++cit) {
-            int id = cit->id();
+          for(CellListIterator cit(realCells); !cit.isDone(); ++cit, ++i) {
+            ids[i] = cit->id();
             Real3D property = Real3D(0,0,0);
             if(key=="position")
               property = cit->position();
@@ -105,7 +112,7 @@ namespace espressopp {
               Real3D& pos = cit->position();
               Int3D& img = cit->image();
               Real3D Li = system.bc->getBoxL();
-              for (int i = 0; i < 3; ++i) property[i] = pos[i] + img[i] * Li[i];
+              for (int k = 0; k < 3; ++k) property[k] = pos[k] + img[k] * Li[k];
             }
             else{
               stringstream msg;
@@ -114,19 +121,26 @@ namespace espressopp {
               err.setException( msg.str() );
             }
             
-            conf[id] = property;
+            props[i] = property;
           }
     	}
 
-        boost::mpi::broadcast(*system.comm, conf, rank_i);
+        if (numLocPart > 0) {
+          boost::mpi::broadcast(*system.comm, &ids[0], numLocPart, rank_i);
+          boost::mpi::broadcast(*system.comm, &props[0], numLocPart, rank_i);
+        }
 
-        for (map<size_t,Real3D>::iterator itr=conf.begin(); itr != conf.end(); ++itr) {
-          size_t id = itr->first;
-          Real3D p = itr->second;
-          if(idToCpu[id]==myrank) config->set(id, p[0], p[1], p[2]);
+        for (int i = 0; i < numLocPart; i++) {
+          if(idToCpu[ids[i]]==myrank) {
+            myIds.push_back(ids[i]);
+            myProps.push_back(props[i]);
+          }
         }
       }
 
+      ConfigurationPtr config = make_shared<Configuration> ();
+      config->assign(myIds.size(), myIds.empty() ? 0 : &myIds[0],
+                     myProps.empty() ? 0 : &myProps[0], 0, 0, 0);
       pushConfig(config);
     }
     
@@ -24,6 +24,7 @@
 #include "Configuration.hpp"
 #include <cmath>
 #include <stdexcept>
+#include <algorithm>
 #include "Real3D.hpp"
 
 using namespace espressopp;
@@ -50,9 +51,60 @@ namespace espressopp {
     {
     }
 
+    size_t Configuration::find(size_t id) const {
+      size_t n = ids.size();
+      if (n == 0) return 0;
+      if (ids[n-1] - ids[0] + 1 == n) {
+        // contiguous ids, the index follows from the id
+        return (id >= ids[0] && id <= ids[n-1]) ? id - ids[0] : n;
+      }
+      std::vector<size_t>::const_iterator it =
+        std::lower_bound(ids.begin(), ids.end(), id);
+      return (it != ids.end() && *it == id) ? it - ids.begin() : n;
+    }
+
+    size_t Configuration::slot(size_t id) {
+      size_t n = ids.size();
+      // particles are usually set in ascending order, i.e. appended
+      size_t i = (n == 0 || id > ids[n-1]) ? n :
+        std::lower_bound(ids.begin(), ids.end(), id) - ids.begin();
+      if (i < n && ids[i] == id) return i;
+
+      ids.insert(ids.begin() + i, id);
+      if (gatherPos)    coordinates.insert(coordinates.begin() + i, Real3D(0.0));
+      if (gatherVel)    velocities.insert(velocities.begin() + i, Real3D(0.0));
+      if (gatherForce)  forces.insert(forces.begin() + i, Real3D(0.0));
+      if (gatherRadius) radii.insert(radii.begin() + i, 0.0);
+      return i;
+    }
+
+    void Configuration::assign(size_t n, const size_t* _ids, const Real3D* _pos,
+                               const Real3D* _vel, const Real3D* _force,
+                               const real* _radius) {
+      // sort (id, source index) pairs, then copy in that order
+      std::vector< std::pair<size_t, size_t> > order(n);
+      for (size_t i = 0; i < n; i++) order[i] = std::make_pair(_ids[i], i);
+      std::sort(order.begin(), order.end());
+
+      ids.resize(n);
+      coordinates.resize(gatherPos ? n : 0);
+      velocities.resize(gatherVel ? n : 0);
+      forces.resize(gatherForce ? n : 0);
+      radii.resize(gatherRadius ? n : 0);
+
+      for (size_t i = 0; i < n; i++) {
+        size_t j = order[i].second;
+        ids[i] = order[i].first;
+        if (gatherPos)    coordinates[i] = _pos[j];
+        if (gatherVel)    velocities[i]  = _vel[j];
+        if (gatherForce)  forces[i]      = _force[j];
+        if (gatherRadius) radii[i]       = _radius[j];
+      }
+    }
+
     void Configuration::set(size_t index, real x, real y, real z) {
       if (gatherPos)
-        coordinates[index] = Real3D(x, y, z);
+        coordinates[slot(index)] = Real3D(x, y, z);
       else {
     	  std::cout << "Error: This configuration does not store coordinates" << std::endl;
       }
@@ -60,7 +112,7 @@ namespace espressopp {
 
     void Configuration::setCoordinates(size_t index, Real3D _pos) {
       if (gatherPos)
-        coordinates[index] = _pos;
+        coordinates[slot(index)] = _pos;
       else {
     	  std::cout << "Error: This configuration does not store coordinates" << std::endl;
       }
@@ -68,7 +120,7 @@ namespace espressopp {
 
     void Configuration::setVelocities(size_t index, Real3D _vel) {
       if (gatherVel)
-        velocities[index] = _vel;
+        velocities[slot(index)] = _vel;
       else {
     	  std::cout << "Error: This configuration does not store velocities" << std::endl;
       }
@@ -76,7 +128,7 @@ namespace espressopp {
 
     void Configuration::setForces(size_t index, Real3D _forces) {
       if (gatherForce)
-        forces[index] = _forces;
+        forces[slot(index)] = _forces;
       else {
     	  std::cout << "Error: This configuration does not store forces" << std::endl;
       }
@@ -84,15 +136,17 @@ namespace espressopp {
 
     void Configuration::setRadius(size_t index, real _radius) {
       if (gatherRadius)
-        radii[index] = _radius;
+        radii[slot(index)] = _radius;
       else {
     	  std::cout << "Error: This configuration does not store radii" << std::endl;
       }
     }
 
     Real3D Configuration::getCoordinates(size_t index) {
-      if (gatherPos)
-        return coordinates[index];
+      if (gatherPos) {
+        size_t i = find(index);
+        return i < ids.size() ? coordinates[i] : Real3D(0,0,0);
+      }
       else {
     	  std::cout << "Error: This configuration has no information about coordinates" << std::endl;
     	  return Real3D(0,0,0);
@@ -100,8 +154,10 @@ namespace espressopp {
     }
 
     Real3D Configuration::getVelocities(size_t index) {
-      if (gatherVel)
-        return velocities[index];
+      if (gatherVel) {
+        size_t i = find(index);
+        return i < ids.size() ? velocities[i] : Real3D(0,0,0);
+      }
       else {
     	  std::cout << "Error: This configuration has no information about velocities" << std::endl;
     	  return Real3D(0,0,0);
@@ -109,8 +165,10 @@ namespace espressopp {
     }
 
     Real3D Configuration::getForces(size_t index) {
-      if (gatherForce)
-        return forces[index];
+      if (gatherForce) {
+        size_t i = find(index);
+        return i < ids.size() ? forces[i] : Real3D(0,0,0);
+      }
       else {
     	  std::cout << "Error: This configuration has no information about forces" << std::endl;
     	  return Real3D(0,0,0);
@@ -118,8 +176,10 @@ namespace espressopp {
     }
 
     real Configuration::getRadius(size_t index) {
-      if (gatherRadius)
-        return radii[index];
+      if (gatherRadius) {
+        size_t i = find(index);
+        return i < ids.size() ? radii[i] : 0;
+      }
       else {
     	  std::cout << "Error: This configuration has no information about radii" << std::endl;
     	  return 0;
@@ -127,17 +187,7 @@ namespace espressopp {
     }
 
     size_t Configuration::getSize() {
-      size_t sizePos    = coordinates.size();
-      size_t sizeVel    = velocities.size();
-      size_t sizeForce  = forces.size();
-      size_t sizeRadius = radii.size();
-
-      if (sizePos    > 0) return sizePos;
-      if (sizeVel    > 0) return sizeVel;
-      if (sizeForce  > 0) return sizeForce;
-      if (sizeRadius > 0) return sizeRadius;
-
-      return 0;
+      return ids.size();
     }
 
 /*
@@ -26,7 +26,7 @@
 
 #include "types.hpp"
 #include "SystemAccess.hpp"
-#include <map>
+#include <vector>
 
 namespace espressopp {
   namespace analysis {
@@ -49,7 +49,14 @@ namespace espressopp {
     };
     */
 
-    /** Class that stores particle positions for later analysis. */
+    /** Class that stores particle positions for later analysis.
+
+        The data is kept in contiguous arrays ordered by ascending
+        particle id, so that analyses that visit all particles of one or
+        several snapshots can loop over the arrays directly. Lookup by id
+        is a direct index if the ids are contiguous and a binary search
+        otherwise.
+    */
     class Configuration {
     public:
       Configuration();
@@ -65,14 +72,35 @@ namespace espressopp {
       void setVelocities(size_t id, Real3D _vel);
       void setForces(size_t id, Real3D _forces);
       void setRadius(size_t id, real _rad);
+
+      /** Replaces the stored particles by the n particles with ids
+          _ids, given in any order. Arrays of quantities that this
+          configuration does not store are ignored and may be 0. */
+      void assign(size_t n, const size_t* _ids, const Real3D* _pos,
+                  const Real3D* _vel, const Real3D* _force, const real* _radius);
+
+      /** ids of the stored particles in ascending order; entry i of the
+          arrays below belongs to the particle with id getIds()[i]. */
+      const std::vector<size_t>& getIds() const { return ids; }
+      const std::vector<Real3D>& getCoordinatesArray() const { return coordinates; }
+      const std::vector<Real3D>& getVelocitiesArray() const { return velocities; }
+      const std::vector<Real3D>& getForcesArray() const { return forces; }
+      const std::vector<real>& getRadiiArray() const { return radii; }
+
       static void registerPython();
       // class ConfigurationIterator getIterator();
     private:
       bool gatherPos, gatherVel, gatherForce, gatherRadius;
-      std::map<size_t, Real3D> coordinates;
-      std::map<size_t, Real3D> velocities;
-      std::map<size_t, Real3D> forces;
-      std::map<size_t, real> radii;
+      std::vector<size_t> ids;
+      std::vector<Real3D> coordinates;
+      std::vector<Real3D> velocities;
+      std::vector<Real3D> forces;
+      std::vector<real> radii;
+
+      // index of id in the arrays, getSize() if it is not stored
+      size_t find(size_t id) const;
+      // index of id, a new zero entry is inserted if it is not stored
+      size_t slot(size_t id);
     };
   }
 }
@@ -24,6 +24,7 @@
 #include "ConfigurationExt.hpp"
 #include <cmath>
 #include <stdexcept>
+#include <algorithm>
 #include "Real3D.hpp"
 
 using namespace espressopp;
@@ -34,100 +35,97 @@ using namespace boost::python;
 namespace espressopp {
   namespace analysis {
 
-    ConfigurationExt::ConfigurationExt()  //int nParticles
+    ConfigurationExt::ConfigurationExt() : dimension(0) //int nParticles
     {
-      //this->nParticles = nParticles;
     }
 
     ConfigurationExt::~ConfigurationExt()
     {
     }
 
-    //FIXME
-    //passing std::vector by value is very slow and should be avoided
-    //however, passing reference is dangerous, since the original object might not survive until the end of this class
-    //how should I use const here?
     void ConfigurationExt::set(size_t index, RealND vec)
     {
-      particleProperties[index].setDimension(vec.getDimension());
-      particleProperties[index] = vec;
-      //coordinates[index] = Real3D(x, y, z);
-      //velocities[index] = Real3D(vx, vy, vz);
-    }
-
-    RealND ConfigurationExt::getProperties(size_t index)
-    {
-      return particleProperties[index];
-    }
-    /*
-    Real3D ConfigurationExt::getCoordinates(size_t index)
-    {
-      return coordinates[index];
+      int dim = vec.getDimension();
+      if (ids.empty()) dimension = dim;
+      else if (dim != dimension)
+        throw std::runtime_error("ConfigurationExt: all particles need properties of the same dimension");
+
+      // particles are usually set in ascending order, i.e. appended
+      size_t n = ids.size();
+      size_t i = (n == 0 || index > ids[n-1]) ? n :
+        std::lower_bound(ids.begin(), ids.end(), index) - ids.begin();
+      if (i == n || ids[i] != index) {
+        ids.insert(ids.begin() + i, index);
+        properties.insert(properties.begin() + i * dimension, dimension, 0.0);
+      }
+      if (dimension)
+        std::copy(vec.get(), vec.get() + dimension, properties.begin() + i * dimension);
     }
 
-    Real3D ConfigurationExt::getVelocities(size_t index)
+    void ConfigurationExt::assign(size_t n, int dim, const size_t* _ids, const real* _props)
     {
-      return velocities[index];
+      std::vector< std::pair<size_t, size_t> > order(n);
+      for (size_t i = 0; i < n; i++) order[i] = std::make_pair(_ids[i], i);
+      std::sort(order.begin(), order.end());
+
+      dimension = dim;
+      ids.resize(n);
+      properties.resize(n * dim);
+      for (size_t i = 0; i < n; i++) {
+        ids[i] = order[i].first;
+        const real* src = _props + order[i].second * dim;
+        std::copy(src, src + dim, properties.begin() + i * dim);
+      }
     }
 
-    size_t ConfigurationExt::getSize()
+    RealND ConfigurationExt::getProperties(size_t index)
     {
-      return coordinates.size();
+      size_t n = ids.size();
+      size_t i;
+      if (n && ids[n-1] - ids[0] + 1 == n) {
+        // contiguous ids, the index follows from the id
+        i = (index >= ids[0] && index <= ids[n-1]) ? index - ids[0] : n;
+      } else {
+        i = std::lower_bound(ids.begin(), ids.end(), index) - ids.begin();
+        if (i < n && ids[i] != index) i = n;
+      }
+      if (i == n) return RealND(dimension, 0.0);
+      return RealND(dimension, &properties[i * dimension]);
     }
-    */
 
     ConfigurationExtIterator ConfigurationExt::getIterator()
     {
-      return ConfigurationExtIterator(particleProperties);
-      //return ConfigurationExtIterator(coordinates);
+      return ConfigurationExtIterator(*this);
     }
 
-    //ConfigurationExtIterator::ConfigurationExtIterator(std::map<size_t, Real3D>& coordinates)
-    ConfigurationExtIterator::ConfigurationExtIterator(std::map<size_t, RealND >& particleProperties)
+    ConfigurationExtIterator::ConfigurationExtIterator(ConfigurationExt& _config)
+      : config(_config), it(0)
     {
-      it = particleProperties.begin();
-      end = particleProperties.end();
-      //it = coordinates.begin();
-      //end = coordinates.end();
     }
 
     int ConfigurationExtIterator::nextId()
     {
-      if (it == end) {
+      if (it == config.ids.size()) {
         PyErr_SetString(PyExc_StopIteration, "No more data.");
         boost::python::throw_error_already_set();
       }
 
-      int id = (*it).first;
+      int id = config.ids[it];
       it++;
       return id;
     }
     
-    //bad performance - or the compiler is smart
     const RealND ConfigurationExtIterator::nextProperties()
     {
-      if (it == end) {
+      if (it == config.ids.size()) {
         PyErr_SetString(PyExc_StopIteration, "No more data.");
         boost::python::throw_error_already_set();
       }
 
-     RealND props = (*it).second;
+      RealND props(config.dimension, &config.properties[it * config.dimension]);
       it++;
       return props;
     }
-    /*
-    Real3D ConfigurationExtIterator::nextCoordinates()
-    {
-      if (it == end) {
-        PyErr_SetString(PyExc_StopIteration, "No more data.");
-        boost::python::throw_error_already_set();
-      }
-
-      Real3D coords = (*it).second;
-      it++;
-      return coords;
-    }
-    */
 
     inline object pass_through(object const& o) { return o; }
 
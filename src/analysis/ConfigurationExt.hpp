@@ -26,7 +26,7 @@
 
 #include "SystemAccess.hpp"
 #include "RealND.hpp"
-#include <map>
+#include <vector>
 
 namespace espressopp {
   namespace analysis {
@@ -39,25 +39,24 @@ namespace espressopp {
 
      public:
 
-      ConfigurationExtIterator(std::map<size_t, RealND >& coordinates);
-      //ConfigurationExtIterator(std::map<size_t, Real3D>& coordinates);
+      ConfigurationExtIterator(class ConfigurationExt& config);
 
       /** Get next particle id for which properties are available */
 
       int nextId();
       const RealND nextProperties();
-      //Real3D nextCoordinates();
-      //Real3D nextVelocities();
 
      private:
 
-      std::map<size_t, RealND >::iterator it;
-      std::map<size_t, RealND >::iterator end;
-      //std::map<size_t, Real3D>::iterator it;
-      //std::map<size_t, Real3D>::iterator end;
+      ConfigurationExt& config;
+      size_t it;
     };
 
-    /** Class that stores particle positions for later analysis. */
+    /** Class that stores particle positions for later analysis.
+
+        The properties of all particles have the same dimension and are
+        kept in one contiguous array ordered by ascending particle id.
+    */
 
     class ConfigurationExt {
 
@@ -68,16 +67,23 @@ namespace espressopp {
       ~ConfigurationExt();
 
       RealND getProperties(size_t id);
-      //Real3D getCoordinates(size_t id);
-      //Real3D getVelocities(size_t id);
 
-      inline size_t getSize(){return particleProperties.size();}
-      //size_t getSize();
+      inline size_t getSize(){return ids.size();}
 
       void set(size_t id, RealND vec) ;
-      //void set(size_t id, real x, real y, real z, real vx, real vy, real vz);
 
-      //int nParticles;     // number of particles of the configuration
+      /** Replaces the stored particles by the n particles with ids
+          _ids, given in any order. The properties of particle _ids[i]
+          are _props[i*dim] ... _props[i*dim + dim - 1]. */
+      void assign(size_t n, int dim, const size_t* _ids, const real* _props);
+
+      /** ids of the stored particles in ascending order */
+      const std::vector<size_t>& getIds() const { return ids; }
+
+      /** properties of the particle getIds()[i] start at i*getDimension() */
+      const std::vector<real>& getPropertiesArray() const { return properties; }
+
+      int getDimension() const { return dimension; }
 
       static void registerPython();
 
@@ -85,9 +91,11 @@ namespace espressopp {
 
      private:
 
-      std::map<size_t, RealND > particleProperties;
-//      std::map<size_t, Real3D> coordinates;
-//      std::map<size_t, Real3D> velocities;
+      friend class ConfigurationExtIterator;
+
+      int dimension;
+      std::vector<size_t> ids;
+      std::vector<real> properties;
     };
 
   }
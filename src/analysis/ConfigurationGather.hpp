@@ -0,0 +1,71 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _ANALYSIS_CONFIGURATIONGATHER_HPP
+#define _ANALYSIS_CONFIGURATIONGATHER_HPP
+
+#include "mpi.hpp"
+#include "mpi.h"
+#include <vector>
+
+namespace espressopp {
+  namespace analysis {
+
+    /** Gathers the arrays of a snapshot on rank 0 with a single
+        MPI_Gatherv. Every CPU contributes n entries of width values of
+        type T each, counts holds the n of all CPUs on rank 0 (see
+        gatherCounts()). On rank 0 all is resized to hold the entries of
+        all CPUs in the order of the ranks, elsewhere it is not touched.
+    */
+    template< typename T >
+    inline void gatherArray(boost::mpi::communicator& comm, const T* local,
+                            int n, int width, const std::vector<int>& counts,
+                            std::vector<T>& all) {
+      MPI_Datatype type = boost::mpi::get_mpi_datatype<T>(T());
+      T dummy;
+      if (comm.rank() == 0) {
+        int nproc = comm.size();
+        std::vector<int> recvCounts(nproc), displs(nproc);
+        int total = 0;
+        for (int i = 0; i < nproc; i++) {
+          recvCounts[i] = width * counts[i];
+          displs[i] = total;
+          total += recvCounts[i];
+        }
+        all.resize(total);
+        MPI_Gatherv(const_cast< T* >(n ? local : &dummy), width * n, type,
+                    total ? &all[0] : &dummy, &recvCounts[0], &displs[0], type,
+                    0, static_cast< MPI_Comm >(comm));
+      } else {
+        MPI_Gatherv(const_cast< T* >(n ? local : &dummy), width * n, type,
+                    0, 0, 0, type, 0, static_cast< MPI_Comm >(comm));
+      }
+    }
+
+    /** number of entries every CPU contributes, on rank 0 only */
+    inline std::vector<int> gatherCounts(boost::mpi::communicator& comm, int n) {
+      std::vector<int> counts;
+      boost::mpi::gather(comm, n, counts, 0);
+      return counts;
+    }
+  }
+}
+
+#endif
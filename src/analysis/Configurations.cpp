@@ -26,8 +26,10 @@
 #include "storage/Storage.hpp"
 #include "iterator/CellListIterator.hpp"
 #include "bc/BC.hpp"
+#include "ConfigurationGather.hpp"
 #include "mpi.h"
 #include <cmath>
+#include <boost/static_assert.hpp>
 
 using namespace espressopp;
 
@@ -38,6 +40,9 @@ namespace espressopp {
 
     using namespace iterator;
 
+    // Real3D arrays are gathered as arrays of reals
+    BOOST_STATIC_ASSERT(sizeof(Real3D) == 3 * sizeof(real));
+
     LOG4ESPP_LOGGER(Configurations::logger, "Configurations");
 
     void Configurations::setCapacity(int max) 
@@ -123,25 +128,14 @@ namespace espressopp {
       // determine number of local particles and total particles
 
       int myN = system.storage->getNRealParticles();
-      int maxN;   // maximal number of particles one processor has
-      int totalN; // totlal number of particles all processors have
-
-      boost::mpi::all_reduce(*system.comm, myN, maxN, boost::mpi::maximum<int>());
-      boost::mpi::all_reduce(*system.comm, myN, totalN, std::plus<int>());
 
-      LOG4ESPP_INFO(logger, "#Partices: me = " << myN << ", max = " << maxN
-                            << ", totalN = " << totalN);
+      LOG4ESPP_INFO(logger, "#Partices: me = " << myN);
 
-      int*  ids         = new int [maxN];  // buffer for gather
-      Real3D* coordinates;
-      Real3D* velocities;
-      Real3D* forces;
-      real* radii;
-
-      if (gatherPos)    coordinates = new Real3D [maxN];  // buffer for gather
-      if (gatherVel)    velocities  = new Real3D [maxN];  // buffer for gather
-      if (gatherForce)  forces      = new Real3D [maxN];  // buffer for gather
-      if (gatherRadius) radii       = new real [maxN];  // buffer for gather
+      std::vector<size_t> ids(myN);
+      std::vector<Real3D> coordinates(gatherPos ? myN : 0);
+      std::vector<Real3D> velocities(gatherVel ? myN : 0);
+      std::vector<Real3D> forces(gatherForce ? myN : 0);
+      std::vector<real> radii(gatherRadius ? myN : 0);
 
       // fill the buffer with my values
 
@@ -169,132 +163,42 @@ namespace espressopp {
         LOG4ESPP_ERROR(logger, "mismatch for number of local particles");
       }
 
-      // each proc sends its data to master process
+      // collect the arrays of all procs on the master process, Real3D
+      // is sent as 3 reals
 
-      if (system.comm->rank() == 0) {
+      std::vector<int> counts = gatherCounts(*system.comm, myN);
+      std::vector<size_t> allIds;
+      std::vector<real> allPos, allVel, allForce, allRadii;
 
-         ConfigurationPtr config = make_shared<Configuration> (); //totalN
-
-         // root process collects data from all processors and sets it
-
-         int nproc = system.comm->size();
-
-         for (int iproc = 0; iproc < nproc; iproc++) {
-           int nother;
-           if (iproc) {
-              int nIds, nVals;   // number of received values
-              int tmp;
-              boost::mpi::request req;
-              boost::mpi::status  stat;
-              LOG4ESPP_DEBUG(logger, "receive tags from " << iproc);
-              req = system.comm->irecv<int>(iproc, DEFAULT_TAG, ids, maxN);
-              system.comm->send(iproc, DEFAULT_TAG, 0);
-              stat = req.wait();
-              nIds = *stat.count<int>();
-              if (gatherPos) {
-                req = system.comm->irecv<Real3D>(iproc, DEFAULT_TAG, coordinates, maxN);
-                system.comm->send(iproc, DEFAULT_TAG, 0);
-                stat = req.wait();
-                nVals = *stat.count<Real3D>();
-                if (nVals != nIds) {
-                  LOG4ESPP_ERROR(logger, "serious error collecting data, got " <<
-                                nIds << " ids, but " << nVals << " coordinates");
-                }
-              }
-              if (gatherVel) {
-                req = system.comm->irecv<Real3D>(iproc, DEFAULT_TAG, velocities, maxN);
-                system.comm->send(iproc, DEFAULT_TAG, 0);
-                stat = req.wait();
-                nVals = *stat.count<Real3D>();
-                if (nVals != nIds) {
-                  LOG4ESPP_ERROR(logger, "serious error collecting data, got " <<
-                                nIds << " ids, but " << nVals << " velocities");
-                }
-              }
-              if (gatherForce) {
-                req = system.comm->irecv<Real3D>(iproc, DEFAULT_TAG, forces, maxN);
-                system.comm->send(iproc, DEFAULT_TAG, 0);
-                stat = req.wait();
-                nVals = *stat.count<Real3D>();
-                if (nVals != nIds) {
-                  LOG4ESPP_ERROR(logger, "serious error collecting data, got " <<
-                                nIds << " ids, but " << nVals << " forces");
-                }
-              }
-              if (gatherRadius) {
-                req = system.comm->irecv<real>(iproc, DEFAULT_TAG, radii, maxN);
-                system.comm->send(iproc, DEFAULT_TAG, 0);
-                stat = req.wait();
-                nVals = *stat.count<real>();
-                if (nVals != nIds) {
-                  LOG4ESPP_ERROR(logger, "serious error collecting data, got " <<
-                                nIds << " ids, but " << nVals << " radii");
-                }
-              }
-              nother = nIds;
-           } else {
-             nother = myN;
-           }
-   
-           LOG4ESPP_INFO(logger, "add " << nother << " coordinates of proc " << iproc);
-
-           for (int i = 0; i < nother; i++) {
-             //LOG4ESPP_DEBUG(logger, "set coordinates of particle with id = " << index <<
-             //                       ": " << coordinates[3*i] << " " <<  coordinates[3*i+1] << " " << coordinates[3*i+2]);
-             int index = ids[i];
-             if (gatherPos)    config->setCoordinates(index, coordinates[i]);
-             if (gatherVel)    config->setVelocities(index, velocities[i]);
-             if (gatherForce)  config->setForces(index, forces[i]);
-             if (gatherRadius) config->setRadius(index, radii[i]);
-           }
-        }
+      gatherArray(*system.comm, ids.empty() ? 0 : &ids[0], myN, 1, counts, allIds);
+      if (gatherPos)
+        gatherArray(*system.comm, myN ? coordinates[0].get() : 0, myN, 3, counts, allPos);
+      if (gatherVel)
+        gatherArray(*system.comm, myN ? velocities[0].get() : 0, myN, 3, counts, allVel);
+      if (gatherForce)
+        gatherArray(*system.comm, myN ? forces[0].get() : 0, myN, 3, counts, allForce);
+      if (gatherRadius)
+        gatherArray(*system.comm, radii.empty() ? 0 : &radii[0], myN, 1, counts, allRadii);
 
-        LOG4ESPP_INFO(logger, "save the latest configuration");
+      if (system.comm->rank() == 0) {
 
-        pushConfig(config);
+        ConfigurationPtr config = make_shared<Configuration>
+          (gatherPos, gatherVel, gatherForce, gatherRadius);
 
-      } else {
+        size_t totalN = allIds.size();
 
-       LOG4ESPP_INFO(logger, "proc " << system.comm->rank() << " sends data " 
-                      << " of " << myN << " particles");
-
-       // not master process, send data to master process
-
-       int tmp;
-
-       boost::mpi::status stat;
-
-       // wait for a signal (empty message) before sending
-
-       system.comm->irecv<int>(0, DEFAULT_TAG, tmp);
-       system.comm->send<int>(0, DEFAULT_TAG, ids, myN);
-       if (gatherPos) {
-         system.comm->irecv<int>(0, DEFAULT_TAG, tmp);
-         system.comm->send<Real3D>(0, DEFAULT_TAG, coordinates, myN);
-       }
-       if (gatherVel) {
-         system.comm->irecv<int>(0, DEFAULT_TAG, tmp);
-         system.comm->send<Real3D>(0, DEFAULT_TAG, velocities, myN);
-       }
-       if (gatherForce) {
-         system.comm->irecv<int>(0, DEFAULT_TAG, tmp);
-         system.comm->send<Real3D>(0, DEFAULT_TAG, forces, myN);
-       }
-       if (gatherRadius) {
-         system.comm->irecv<int>(0, DEFAULT_TAG, tmp);
-         system.comm->send<real>(0, DEFAULT_TAG, radii, myN);
-       }
-      }
+        LOG4ESPP_INFO(logger, "sort " << totalN << " particles by id");
 
-      // ToDo: remove first configuration if capacity is exhausted
+        config->assign(totalN, totalN ? &allIds[0] : 0,
+                       allPos.empty() ? 0 : reinterpret_cast<Real3D*>(&allPos[0]),
+                       allVel.empty() ? 0 : reinterpret_cast<Real3D*>(&allVel[0]),
+                       allForce.empty() ? 0 : reinterpret_cast<Real3D*>(&allForce[0]),
+                       allRadii.empty() ? 0 : &allRadii[0]);
 
-      // master process saves the configuration
+        LOG4ESPP_INFO(logger, "save the latest configuration");
 
-      if (gatherRadius) delete [] radii;
-      if (gatherForce)  delete [] forces;
-      if (gatherVel)    delete [] velocities;
-      if (gatherPos)    delete [] coordinates;
-      delete [] ids;
+        pushConfig(config);
+      }
     }
 
     // Python wrapping
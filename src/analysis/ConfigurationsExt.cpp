@@ -26,6 +26,7 @@
 #include "storage/Storage.hpp"
 #include "iterator/CellListIterator.hpp"
 #include "bc/BC.hpp"
+#include "ConfigurationGather.hpp"
 #include "mpi.h"
 #include <cmath>
 
@@ -124,184 +125,69 @@ namespace espressopp {
       // determine number of local particles and total particles
 
       int myN = system.storage->getNRealParticles();
-      int maxN;   // maximal number of particles one processor has
-      int totalN; // totlal number of particles all processors have
 
-      boost::mpi::all_reduce(*system.comm, myN, maxN, boost::mpi::maximum<int>());
-      boost::mpi::all_reduce(*system.comm, myN, totalN, std::plus<int>());
+      LOG4ESPP_INFO(logger, "#Partices: me = " << myN);
 
-      LOG4ESPP_INFO(logger, "#Partices: me = " << myN << ", max = " << maxN
-                            << ", totalN = " << totalN);
-
-      real* coordinates = new real [3 * maxN];  // buffer for gather
-      real* velocities  = new real [3 * maxN];  // buffer for gather
-      int*  ids         = new int [maxN];  // buffer for gather
+      // coordinates and velocities of a particle are stored together
+      std::vector<size_t> ids(myN);
+      std::vector<real> properties(6 * myN);
 
       // fill the buffer with my values
 
       CellList realCells = system.storage->getRealCells();
+      Real3D L = system.bc->getBoxL();
 
       int i = 0; 
+      for(CellListIterator cit(realCells); !cit.isDone(); ++cit) {
 
-      if( unfolded ){
-        for(CellListIterator cit(realCells); !cit.isDone(); ++cit) {
+        ids[i] = cit->id();
 
-          ids[i] = cit->id();
+        Real3D& pos = cit->position();
+        Real3D& vel = cit->velocity();
 
-          Real3D& pos = cit->position();
-          Real3D& vel = cit->velocity();
+        if( unfolded ){
           Int3D& img = cit->image();
-          Real3D L = system.bc->getBoxL();
-
-          coordinates[3*i]   = pos[0] + img[0] * L[0];
-          coordinates[3*i+1] = pos[1] + img[1] * L[1];
-          coordinates[3*i+2] = pos[2] + img[2] * L[2];
-
-          velocities[3*i]   = vel[0];
-          velocities[3*i+1] = vel[1];
-          velocities[3*i+2] = vel[2];
-
-          i++;
+          for (int k = 0; k < 3; k++)
+            properties[6*i + k] = pos[k] + img[k] * L[k];
         }
-      }
-      else{
-        for(CellListIterator cit(realCells); !cit.isDone(); ++cit) {
-
-          ids[i] = cit->id();
-
-          Real3D& pos = cit->position();
-          Real3D& vel = cit->velocity();
-
-          coordinates[3*i]   = pos[0];
-          coordinates[3*i+1] = pos[1];
-          coordinates[3*i+2] = pos[2];
-
-          velocities[3*i]   = vel[0];
-          velocities[3*i+1] = vel[1];
-          velocities[3*i+2] = vel[2];
-
-          i++;
+        else{
+          for (int k = 0; k < 3; k++)
+            properties[6*i + k] = pos[k];
         }
+        for (int k = 0; k < 3; k++)
+          properties[6*i + 3 + k] = vel[k];
+
+        i++;
       }
 
       if (i != myN) {
         LOG4ESPP_ERROR(logger, "mismatch for number of local particles");
       }
 
-      // each proc sends its data to master process
-
-      if (system.comm->rank() == 0) {
-
-         ConfigurationExtPtr config = make_shared<ConfigurationExt> (); //totalN
-
-         // root process collects data from all processors and sets it
-
-         int nproc = system.comm->size();
-
-         for (int iproc = 0; iproc < nproc; iproc++) {
-
-           int nother;
+      // collect the arrays of all procs on the master process
 
-           if (iproc) {
-   
-              int nIds, nCoords, nVelocs;   // number of received values
-              //int tmp;
-
-              boost::mpi::request req;
-              boost::mpi::status  stat;
-
-              LOG4ESPP_DEBUG(logger, "receive tags from " << iproc);
-
-              req = system.comm->irecv<int>(iproc, DEFAULT_TAG, ids, maxN);
-              system.comm->send(iproc, DEFAULT_TAG, 0);
-              stat = req.wait();
-              nIds = *stat.count<int>();
-
-              req = system.comm->irecv<real>(iproc, DEFAULT_TAG, coordinates, 3*maxN);
-              system.comm->send(iproc, DEFAULT_TAG, 0);
-              stat = req.wait();
-              nCoords = *stat.count<real>();
-  
-              // make sure to have 3 coordinate values for each id
+      std::vector<int> counts = gatherCounts(*system.comm, myN);
+      std::vector<size_t> allIds;
+      std::vector<real> allProperties;
 
-              if (nCoords != 3 * nIds) {
-                LOG4ESPP_ERROR(logger, "serious error collecting data, got " << 
-                              nIds << " ids, but " << nCoords << " coordinates");
-              }
+      gatherArray(*system.comm, myN ? &ids[0] : 0, myN, 1, counts, allIds);
+      gatherArray(*system.comm, myN ? &properties[0] : 0, myN, 6, counts, allProperties);
 
+      if (system.comm->rank() == 0) {
 
-              req = system.comm->irecv<real>(iproc, DEFAULT_TAG, velocities, 3*maxN);
-              system.comm->send(iproc, DEFAULT_TAG, 0);
-              stat = req.wait();
-              nVelocs = *stat.count<real>();
-
-              // make sure to have 3 velocities values for each id
-
-              if (nVelocs != 3 * nIds) {
-                LOG4ESPP_ERROR(logger, "serious error collecting data, got " << 
-                              nIds << " ids, but " << nVelocs << " velocities");
-              }
-
-
-              nother = nIds;
-
-           } else {
-             nother = myN;
-           }
-   
-
-           LOG4ESPP_INFO(logger, "add " << nother << " coordinates of proc " << iproc);
-
-           for (int i = 0; i < nother; i++) {
-
-             int index = ids[i];
-
-             LOG4ESPP_INFO(logger, "set coordianates of particle with id = " << index <<
-                                   ": " << coordinates[3*i] << " " <<  coordinates[3*i+1] << " " << coordinates[3*i+2] << 
-                                   "and velocities: " <<  velocities[3*i] << " " <<  velocities[3*i+1] << " " << velocities[3*i+2]);
-
-
-             RealND _vec(6);
-             for (int k=0; k<3; k++)
-               _vec.setItem(k, coordinates[3*i + k]);
-
-             for (int k=0; k<3; k++)
-               _vec.setItem(k+3, velocities[3*i + k]);
-             config->set(index, _vec);
-           }
-        }
-
-        LOG4ESPP_INFO(logger, "save the latest configuration");
-
-        pushConfig(config);
-
-      } else {
-
-       LOG4ESPP_INFO(logger, "proc " << system.comm->rank() << " sends data " 
-                      << " of " << myN << " particles");
+         ConfigurationExtPtr config = make_shared<ConfigurationExt> ();
 
-       // not master process, send data to master process
+         size_t totalN = allIds.size();
 
-       int tmp;
+         LOG4ESPP_INFO(logger, "sort " << totalN << " particles by id");
 
-       boost::mpi::status stat;
+         config->assign(totalN, 6, totalN ? &allIds[0] : 0,
+                        totalN ? &allProperties[0] : 0);
 
-       // wait for a signal (empty message) before sending
+         LOG4ESPP_INFO(logger, "save the latest configuration");
 
-       system.comm->irecv<int>(0, DEFAULT_TAG, tmp);
-       system.comm->send<int>(0, DEFAULT_TAG, ids, myN);
-       system.comm->irecv<int>(0, DEFAULT_TAG, tmp);
-       system.comm->send<real>(0, DEFAULT_TAG, coordinates, 3*myN);
-       system.comm->send<real>(0, DEFAULT_TAG, velocities, 3*myN);
+         pushConfig(config);
       }
-
-      // ToDo: remove first configuration if capacity is exhausted
-
-      // master process saves the configuration
-
-      delete [] coordinates;
-      delete [] velocities;
-      delete [] ids;
     }
 
     // Python wrapping
@@ -50,16 +50,6 @@ namespace espressopp {
       
       System& system = getSystemRef();
       
-      //creating vector which stores particleIDs for each CPU
-      vector<longint> localIDs; 
-      for (map<size_t,int>::const_iterator itr=idToCpu.begin(); itr!=idToCpu.end(); ++itr) {
-        size_t i = itr->first;
-        int whichCPU = itr->second;
-        if(system.comm->rank()==whichCPU){
-          localIDs.push_back(i);
-        }
-      }
-      
       // COM calculation
       vector<Real3D> centerOfMassList;
       for(int m=0; m<M; m++){
@@ -68,10 +58,10 @@ namespace espressopp {
         Real3D posCOM_sum = Real3D(0.0,0.0,0.0);
         real mass_sum = 0.0;
 
-        for (vector<longint>::iterator itr=localIDs.begin(); itr!=localIDs.end(); ++itr) {
-            size_t i = *itr;
-            Real3D pos = getConf(m)->getCoordinates(i);
-            posCOM += pos;
+        // the configurations hold exactly the localIDs, sorted by id
+        const vector<Real3D>& pos = getConf(m)->getCoordinatesArray();
+        for (size_t k = 0; k < pos.size(); k++) {
+            posCOM += pos[k];
             mass += 1;          
         }
 
@@ -89,12 +79,11 @@ namespace espressopp {
         totZ[m] = 0.0;
         Z[m] = 0.0;
         for(int n=0; n<M-m; n++){
-          for (vector<longint>::iterator itr=localIDs.begin(); itr!=localIDs.end(); ++itr) {
-            size_t i = *itr;
-            
-            Real3D pos1 = getConf(n + m)->getCoordinates(i); // - centerOfMassList[n+m];
-            Real3D pos2 = getConf(n)->getCoordinates(i); //     - centerOfMassList[n];
-            Real3D delta = pos2 - pos1;
+          const vector<Real3D>& pos1 = getConf(n + m)->getCoordinatesArray(); // - centerOfMassList[n+m];
+          const vector<Real3D>& pos2 = getConf(n)->getCoordinatesArray(); //     - centerOfMassList[n];
+          size_t nLocal = pos2.size();
+          for (size_t k = 0; k < nLocal; k++) {
+            Real3D delta = pos2[k] - pos1[k];
             Z[m] += delta.sqr();
           }
         }
@@ -23,6 +23,7 @@
 #include "python.hpp"
 #include "storage/DomainDecomposition.hpp"
 #include "iterator/CellListIterator.hpp"
+#include "iterator/CellListAllPairsIterator.hpp"
 //#include "Configuration.hpp"
 #include "RDFatomistic.hpp"
 #include "esutil/Error.hpp"
@@ -45,6 +46,8 @@ namespace espressopp {
     // rdfN is a level of discretisation of rdf (how many elements it contains)
     python::list RDFatomistic::computeArray(int rdfN) const {
 
+      if (rmax > 0.0) return computeArrayLocal(rdfN);
+
       System& system = getSystemRef();
       esutil::Error err(system.comm);
       Real3D Li = system.bc->getBoxL();
@@ -201,6 +204,159 @@ namespace espressopp {
       return pyli;
     }
 
+    /* Visits the atoms of all coarse-grained pairs within the local cells
+       and their neighbors. These cover all coarse-grained pairs closer
+       than the cell size minus the skin, as no particle has moved by more
+       than half the skin since the last decomposition. An atom pair can be
+       farther apart than its coarse-grained centers by up to twice the
+       molecule extent, so rmax plus that must not exceed this bound.
+       Every ordered pair of atoms of different
+       molecules whose first atom lies in the slab is counted, so the
+       number of pairs follows from the atom counts alone. */
+    python::list RDFatomistic::computeArrayLocal(int rdfN) const {
+
+      System& system = getSystemRef();
+      esutil::Error err(system.comm);
+      Real3D Li = system.bc->getBoxL();
+      Real3D Li_half = Li / 2.;
+
+      // the ghosts have to be at the current positions
+      system.storage->updateGhosts();
+
+      shared_ptr<FixedTupleListAdress> fixedtupleList = system.storage->getFixedTuples();
+      CellList realCells = system.storage->getRealCells();
+
+      // largest distance of an atom from its coarse-grained particle
+      real myExtent = 0.0;
+      for(CellListIterator cit(realCells); !cit.isDone(); ++cit) {
+        FixedTupleListAdress::iterator it2 = fixedtupleList->find(&(*cit));
+        if (it2 == fixedtupleList->end()) continue;
+        std::vector<Particle*>& atList = it2->second;
+        for (std::vector<Particle*>::iterator it3 = atList.begin(); it3 != atList.end(); ++it3) {
+          Real3D d = (*it3)->position() - cit->position();
+          for(int ii=0; ii<3; ii++){
+            if( d[ii] < -Li_half[ii] ) d[ii] += Li[ii];
+            if( d[ii] >  Li_half[ii] ) d[ii] -= Li[ii];
+          }
+          myExtent = std::max(myExtent, d.abs());
+        }
+      }
+      real extent;
+      boost::mpi::all_reduce(*system.comm, myExtent, extent, boost::mpi::maximum<real>());
+
+      // the particles may have left their cells by up to skin/2 each
+      real cellSize = system.storage->getMinCellSize();
+      real skin = system.getSkin();
+      if (rmax + 2.0 * extent > cellSize - skin) {
+        stringstream msg;
+        msg << "RDFatomistic: rmax = " << rmax << " plus twice the molecule extent "
+            << extent << " is larger than the cell size " << cellSize
+            << " minus the skin " << skin
+            << ", use a smaller rmax or rmax = 0 for the full range";
+        err.setException(msg.str());
+      }
+      err.checkException();
+
+      // [0], [1]: atoms of target1, target2; [2], [3]: those in the slab;
+      // [4]: partners of slab atoms within their own molecule
+      real counts[5] = { 0.0, 0.0, 0.0, 0.0, 0.0 };
+
+      for(CellListIterator cit(realCells); !cit.isDone(); ++cit) {
+        FixedTupleListAdress::iterator it2 = fixedtupleList->find(&(*cit));
+        if (it2 == fixedtupleList->end()) {
+          err.setException("RDFatomistic: no atomistic AdResS particle found");
+          continue;
+        }
+        std::vector<Particle*>& atList = it2->second;
+        real n1 = 0.0, n2 = 0.0;
+        for (std::vector<Particle*>::iterator it3 = atList.begin(); it3 != atList.end(); ++it3) {
+          int type = (*it3)->type();
+          if (type == target1) n1 += 1.0;
+          else if (type == target2) n2 += 1.0;
+        }
+        counts[0] += n1;
+        counts[1] += n2;
+        for (std::vector<Particle*>::iterator it3 = atList.begin(); it3 != atList.end(); ++it3) {
+          real x = (*it3)->position()[0] - floor((*it3)->position()[0] / Li[0]) * Li[0];
+          if ((x < Li_half[0]+span) && (x > Li_half[0]-span)) {
+            int type = (*it3)->type();
+            if (type == target1) {
+              counts[2] += 1.0;
+              counts[4] += (target1 == target2) ? n1 : n2;
+            } else if (type == target2) {
+              counts[3] += 1.0;
+              counts[4] += n1;
+            }
+          }
+        }
+      }
+      err.checkException();
+
+      vector<real> histogram(rdfN, 0.0);
+      real dr = rmax / (real)rdfN;
+      real rmaxSqr = rmax * rmax;
+
+      for (CellListAllPairsIterator it(realCells); it.isValid(); ++it) {
+        FixedTupleListAdress::iterator it3 = fixedtupleList->find(it->first);
+        FixedTupleListAdress::iterator it4 = fixedtupleList->find(it->second);
+        if (it3 == fixedtupleList->end() || it4 == fixedtupleList->end()) continue;
+
+        std::vector<Particle*>& atList1 = it3->second;
+        std::vector<Particle*>& atList2 = it4->second;
+        for (std::vector<Particle*>::iterator itv = atList1.begin(); itv != atList1.end(); ++itv) {
+          Particle &p1 = **itv;
+          int typeP1 = p1.type();
+          for (std::vector<Particle*>::iterator itv2 = atList2.begin(); itv2 != atList2.end(); ++itv2) {
+            Particle &p2 = **itv2;
+            int typeP2 = p2.type();
+            if( !( (typeP1 == target1) && (typeP2 == target2) ) &&
+                !( (typeP1 == target2) && (typeP2 == target1) ) ) continue;
+
+            Real3D distVector = p1.position() - p2.position();
+            for(int ii=0; ii<3; ii++){
+              if( distVector[ii] < -Li_half[ii] ) distVector[ii] += Li[ii];
+              if( distVector[ii] >  Li_half[ii] ) distVector[ii] -= Li[ii];
+            }
+            real distSqr = distVector.sqr();
+            if (distSqr >= rmaxSqr) continue;
+
+            // atoms of ghosts are periodic images, fold x back for the slab
+            real x1 = p1.position()[0] - floor(p1.position()[0] / Li[0]) * Li[0];
+            real x2 = p2.position()[0] - floor(p2.position()[0] / Li[0]) * Li[0];
+            real weight = 0.0;
+            if ((x1 < Li_half[0]+span) && (x1 > Li_half[0]-span)) weight += 1.0;
+            if ((x2 < Li_half[0]+span) && (x2 > Li_half[0]-span)) weight += 1.0;
+
+            int bin = (int)(sqrt(distSqr) / dr);
+            if (bin < rdfN) histogram[bin] += weight;
+          }
+        }
+      }
+
+      real totCounts[5];
+      boost::mpi::all_reduce(*system.comm, counts, 5, totCounts, plus<real>());
+      vector<real> totHistogram(rdfN, 0.0);
+      if (rdfN > 0)
+        boost::mpi::all_reduce(*system.comm, &histogram[0], rdfN, &totHistogram[0], plus<real>());
+
+      real tot_num_pairs;
+      if (target1 == target2)
+        tot_num_pairs = totCounts[2] * totCounts[0] - totCounts[4];
+      else
+        tot_num_pairs = totCounts[2] * totCounts[1] + totCounts[3] * totCounts[0] - totCounts[4];
+
+      // normalizing, as in computeArray
+      real rho = (real)1.0 / (Li[0]*Li[1]*Li[2]);
+      real factor = 4.0 * M_PIl * dr * rho * tot_num_pairs;
+
+      python::list pyli;
+      for(int i=0; i < rdfN; i++){
+        real radius = (i + 0.5) * dr;
+        pyli.append( totHistogram[i] / (factor * (radius*radius + dr*dr / 12.0)) );
+      }
+      return pyli;
+    }
+
     // TODO: this dummy routine is still needed as we have not yet ObservableVector
     real RDFatomistic::compute() const {
       return -1.0;
@@ -210,6 +366,7 @@ namespace espressopp {
       using namespace espressopp::python;
       class_<RDFatomistic, bases< Observable > >
         ("analysis_RDFatomistic", init< shared_ptr< System >, int, int, real >())
+        .add_property("rmax", &RDFatomistic::getRmax, &RDFatomistic::setRmax)
         .def("compute", &RDFatomistic::computeArray)
       ;
     }
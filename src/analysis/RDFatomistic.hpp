@@ -31,14 +31,24 @@
 
 namespace espressopp {
   namespace analysis {
-    /** Class to compute the radial distribution function of the system. */
+    /** Class to compute the radial distribution function of the system.
+
+        If rmax is set, only the atoms of the coarse-grained pairs known
+        to the domain decomposition are visited and the RDF is computed
+        up to rmax, see RadialDistrF. rmax plus twice the largest distance
+        of an atom from its coarse-grained particle must not exceed the
+        cell size minus the skin.
+    */
     class RDFatomistic : public Observable {
     public:
-      RDFatomistic(shared_ptr< System > system, int type1, int type2, real _span) : Observable(system), target1(type1), target2(type2), span(_span) {}
+      RDFatomistic(shared_ptr< System > system, int type1, int type2, real _span) : Observable(system), target1(type1), target2(type2), span(_span), rmax(0.0) {}
       ~RDFatomistic() {}
       virtual real compute() const;
       virtual python::list computeArray(int) const;
 
+      void setRmax(real _rmax){ rmax = _rmax; }
+      real getRmax(){return rmax;}
+
       static void registerPython();
       
       class data {
@@ -57,7 +67,10 @@ namespace espressopp {
       int target1;
       int target2;
       real span;
-      
+      real rmax;  // 0 means half the box, from all pairs
+
+    private:
+      python::list computeArrayLocal(int rdfN) const;
     };
   }
 }
@@ -25,6 +25,13 @@ r"""
 ************************************
 
 
+If the property `rmax` is set to a value > 0, the RDF is computed up to rmax
+from the atoms of the coarse-grained pairs that the domain decomposition knows
+locally instead of collecting all atoms on every CPU, see RadialDistrF. rmax
+plus twice the largest distance of an atom from its coarse-grained particle
+must not exceed the cell size minus the skin, since atoms of coarse-grained
+particles in non-neighboring cells are not visited.
+
 .. function:: espressopp.analysis.RDFatomistic(system, type1, type2, _span)
 
 		:param system: 
@@ -61,6 +68,7 @@ if pmi.isController :
   class RDFatomistic(Observable):
     __metaclass__ = pmi.Proxy
     pmiproxydefs = dict(
+      pmiproperty = [ 'rmax' ],
       pmicall = [ "compute" ],
       cls = 'espressopp.analysis.RDFatomisticLocal'
     )
@@ -23,6 +23,7 @@
 #include "python.hpp"
 #include "storage/DomainDecomposition.hpp"
 #include "iterator/CellListIterator.hpp"
+#include "iterator/CellListAllPairsIterator.hpp"
 #include "Configuration.hpp"
 #include "RadialDistrF.hpp"
 #include "esutil/Error.hpp"
@@ -45,6 +46,8 @@ namespace espressopp {
     // rdfN is a level of discretisation of rdf (how many elements it contains)
     python::list RadialDistrF::computeArray(int rdfN) const {
 
+      if (rmax > 0.0) return computeArrayLocal(rdfN);
+
       System& system = getSystemRef();
       esutil::Error err(system.comm);
       Real3D Li = system.bc->getBoxL();
@@ -147,6 +150,65 @@ namespace espressopp {
       return pyli;
     }
 
+    // only the pairs within the local cells and their neighbors are
+    // visited. No particle has moved by more than half the skin since the
+    // last decomposition, so these cover all pairs closer than the cell
+    // size minus the skin.
+    python::list RadialDistrF::computeArrayLocal(int rdfN) const {
+
+      System& system = getSystemRef();
+      esutil::Error err(system.comm);
+      Real3D Li = system.bc->getBoxL();
+
+      real cellSize = system.storage->getMinCellSize();
+      real skin = system.getSkin();
+      if (rmax > cellSize - skin) {
+        stringstream msg;
+        msg << "RadialDistrF: rmax = " << rmax << " is larger than the cell size "
+            << cellSize << " minus the skin " << skin
+            << ", use a smaller rmax or rmax = 0 for the full range";
+        err.setException(msg.str());
+      }
+      err.checkException();
+
+      // the ghosts have to be at the current positions
+      system.storage->updateGhosts();
+
+      vector<real> histogram(rdfN, 0.0);
+      real dr = rmax / (real)rdfN;
+      real rmaxSqr = rmax * rmax;
+
+      CellList realCells = system.storage->getRealCells();
+      for (CellListAllPairsIterator it(realCells); it.isValid(); ++it) {
+        // ghosts are periodic images, the plain difference is the minimum image
+        Real3D distVector = it->first->position() - it->second->position();
+        real distSqr = distVector.sqr();
+        if (distSqr < rmaxSqr) {
+          int bin = (int)(sqrt(distSqr) / dr);
+          if (bin < rdfN) histogram[bin] += 1.0;
+        }
+      }
+
+      int myN = system.storage->getNRealParticles();
+      int num_part = 0;
+      boost::mpi::all_reduce(*system.comm, myN, num_part, plus<int>());
+
+      vector<real> totHistogram(rdfN, 0.0);
+      if (rdfN > 0)
+        boost::mpi::all_reduce(*system.comm, &histogram[0], rdfN, &totHistogram[0], plus<real>());
+
+      // normalizing, as in computeArray
+      real rho = (real)num_part / (Li[0]*Li[1]*Li[2]);
+      real factor = 2.0 * M_PIl * dr * rho * (real)num_part;
+
+      python::list pyli;
+      for(int i=0; i < rdfN; i++){
+        real radius = (i + 0.5) * dr;
+        pyli.append( totHistogram[i] / (factor * (radius*radius + dr*dr / 12.0)) );
+      }
+      return pyli;
+    }
+
     // TODO: this dummy routine is still needed as we have not yet ObservableVector
     real RadialDistrF::compute() const {
       return -1.0;
@@ -157,6 +219,7 @@ namespace espressopp {
       class_<RadialDistrF, bases< Observable > >
         ("analysis_RadialDistrF", init< shared_ptr< System > >())
         .add_property("print_progress", &RadialDistrF::getPrint_progress, &RadialDistrF::setPrint_progress)
+        .add_property("rmax", &RadialDistrF::getRmax, &RadialDistrF::setRmax)
         .def("compute", &RadialDistrF::computeArray)
       ;
     }
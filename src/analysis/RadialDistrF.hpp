@@ -31,10 +31,19 @@
 
 namespace espressopp {
   namespace analysis {
-    /** Class to compute the radial distribution function of the system. */
+    /** Class to compute the radial distribution function of the system.
+
+        By default all particles are collected on every CPU and the RDF is
+        computed up to half the box length. If rmax is set, the RDF is only
+        computed up to rmax from the local pairs of the domain
+        decomposition, i.e. real particles and ghosts in neighboring cells,
+        which requires rmax not to exceed the cell size minus the skin, as
+        the particles may have moved by half the skin since the last
+        decomposition.
+    */
     class RadialDistrF : public Observable {
     public:
-      RadialDistrF(shared_ptr< System > system) : Observable(system) {
+      RadialDistrF(shared_ptr< System > system) : Observable(system), rmax(0.0) {
         // by default 
         setPrint_progress(true);
       }
@@ -47,10 +56,16 @@ namespace espressopp {
       }
       bool getPrint_progress(){return print_progress;}
 
+      void setRmax(real _rmax){ rmax = _rmax; }
+      real getRmax(){return rmax;}
+
       static void registerPython();
       
     private:
       bool print_progress;
+      real rmax;  // 0 means half the box, from all pairs
+
+      python::list computeArrayLocal(int rdfN) const;
     };
   }
 }
@@ -25,6 +25,18 @@ r"""
 ************************************
 
 
+By default all particles are collected on every CPU and the RDF is computed
+from all pairs up to half the box length. If the property `rmax` is set to a
+value > 0, the RDF is computed up to rmax from the pairs that the domain
+decomposition knows locally (real particles and ghosts of neighboring cells),
+so that no CPU needs the whole system. rmax must not exceed the cell size
+minus the skin, i.e. roughly the interaction cutoff, since the particles may
+have moved by half the skin since they were last sorted into the cells.
+
+>>> rdf = espressopp.analysis.RadialDistrF(system)
+>>> rdf.rmax = 2.5
+>>> g = rdf.compute(100)
+
 .. function:: espressopp.analysis.RadialDistrF(system)
 
 		:param system: 
@@ -55,7 +67,7 @@ if pmi.isController :
   class RadialDistrF(Observable):
     __metaclass__ = pmi.Proxy
     pmiproxydefs = dict(
-      pmiproperty = [ 'print_progress' ],
+      pmiproperty = [ 'print_progress', 'rmax' ],
       pmicall = [ "compute" ],
       cls = 'espressopp.analysis.RadialDistrFLocal'
     )
@@ -23,17 +23,16 @@
 #include "python.hpp"
 #include "storage/DomainDecomposition.hpp"
 #include "iterator/CellListIterator.hpp"
-#include "Configuration.hpp"
 #include "StaticStructF.hpp"
 #include "esutil/Error.hpp"
 #include "bc/BC.hpp"
 
-#include <boost/serialization/map.hpp>
+#include <boost/serialization/vector.hpp>
 
 #include <math.h>       // cos and ceil and sqrt
+#include <complex>
 #include <algorithm>    // std::min
 #include <functional>   // std::plus
-#include <time.h>       // time_t, for particle-distribution-to-cpu time
 
 #ifndef M_PIl
 #define M_PIl 3.1415926535897932384626433832795029L
@@ -45,7 +44,104 @@ using namespace std;
 
 namespace espressopp {
     namespace analysis {
-        // currently only works for particles numbered like 0, 1, 2,...
+
+        namespace {
+            typedef complex<real> dcomplex;
+
+            /* Sums of the phase factors exp(i q.r) for all q vectors
+               q = (hx*dqx, hy*dqy, hz*dqz) with |hx| <= nqx, |hy| <= nqy and
+               0 <= hz <= nqz, hz running fastest. As in CoulombKSpaceEwald
+               the factors of a particle are built by recurrence from
+               exp(i dq x), so only three sin/cos pairs per particle are
+               needed. */
+            class PhaseSums {
+            public:
+                PhaseSums(int nqx, int nqy, int nqz, const real dqs[3])
+                : eikx(nqx + 1), eiky(nqy + 1), eikz(nqz + 1) {
+                    nq[0] = nqx;
+                    nq[1] = nqy;
+                    nq[2] = nqz;
+                    for (int i = 0; i < 3; i++) dq[i] = dqs[i];
+                }
+
+                int size() const {
+                    return (2 * nq[0] + 1) * (2 * nq[1] + 1) * (nq[2] + 1);
+                }
+
+                // adds the phase factors of the particle at r to sum[0..size()-1]
+                void add(const Real3D& r, dcomplex* sum) {
+                    phases(r[0] * dq[0], eikx);
+                    phases(r[1] * dq[1], eiky);
+                    phases(r[2] * dq[2], eikz);
+
+                    int nqz = nq[2];
+                    for (int hx = -nq[0]; hx <= nq[0]; hx++) {
+                        dcomplex ex = (hx >= 0) ? eikx[hx] : conj(eikx[-hx]);
+                        for (int hy = -nq[1]; hy <= nq[1]; hy++) {
+                            dcomplex exy = ex * ((hy >= 0) ? eiky[hy] : conj(eiky[-hy]));
+                            for (int hz = 0; hz <= nqz; hz++) {
+                                sum[hz] += exy * eikz[hz];
+                            }
+                            sum += nqz + 1;
+                        }
+                    }
+                }
+
+            private:
+                int nq[3];
+                real dq[3];
+                vector<dcomplex> eikx, eiky, eikz;
+
+                static void phases(real phi, vector<dcomplex>& eik) {
+                    eik[0] = dcomplex(1.0, 0.0);
+                    if (eik.size() > 1) eik[1] = dcomplex(cos(phi), sin(phi));
+                    for (size_t k = 2; k < eik.size(); k++) eik[k] = eik[k - 1] * eik[1];
+                }
+            };
+
+            /* Averages sq (one value per q vector, ordered as in PhaseSums)
+               over shells of width bin_factor * min(dqx, dqy, dqz) and returns
+               the (q, S(q)) pairs, leaving out q = 0. */
+            python::list binSq(const vector<real>& sq, int nqx, int nqy, int nqz,
+                    const real dqs[3], real bin_factor, real norm) {
+                real bin_size = bin_factor * min(dqs[0], min(dqs[1], dqs[2]));
+                real q_sqr_max = nqx * nqx * dqs[0] * dqs[0]
+                        + nqy * nqy * dqs[1] * dqs[1]
+                        + nqz * nqz * dqs[2] * dqs[2];
+                real q_max = sqrt(q_sqr_max);
+                int num_bins = (int) floor(q_max / bin_size) + 1;
+                vector<real> sq_bin(num_bins, 0.0);
+                vector<real> q_bin(num_bins, 0.0);
+                vector<int> count_bin(num_bins, 0);
+
+                cout << "bin size \t" << bin_size << "\n"
+                        << "q_max    \t" << q_max << "\n";
+
+                int idx = 0;
+                for (int hx = -nqx; hx <= nqx; hx++) {
+                    for (int hy = -nqy; hy <= nqy; hy++) {
+                        for (int hz = 0; hz <= nqz; hz++, idx++) {
+                            Real3D q(hx * dqs[0], hy * dqs[1], hz * dqs[2]);
+                            real q_abs = q.abs();
+                            int bin_i = min((int) floor(q_abs / bin_size), num_bins - 1);
+                            q_bin[bin_i] += q_abs;
+                            count_bin[bin_i] += 1;
+                            sq_bin[bin_i] += sq[idx];
+                        }
+                    }
+                }
+
+                python::list pyli;
+                //starting with bin_i = 1 will leave out the value for q=0, otherwise start with bin_i=0
+                for (int bin_i = 1; bin_i < num_bins; bin_i++) {
+                    real c = (count_bin[bin_i]) ? 1 / (real) count_bin[bin_i] : 0;
+                    python::tuple q_Sq_pair;
+                    q_Sq_pair = python::make_tuple(q_bin[bin_i] * c, norm * sq_bin[bin_i] * c);
+                    pyli.append(q_Sq_pair);
+                }
+                return pyli;
+            }
+        }
 
         // nqx is a number which corresponds to the different x-values of the
         // diffraction vector q. greater nqx produces more different x-values  
@@ -57,204 +153,117 @@ namespace espressopp {
         // longest side of the box. dq = min(dqx, dqy, dqz)
         // dqx, dqy, dqz are the cell length of the grid of possible q-vectors
         // dqx = 2*PI/Lx, dqy = 2*PI/Ly, dqz = 2*PI/Lz
+        //
+        // Every CPU sums the phase factors of its own particles for all q
+        // vectors, the sums are combined by a single reduction.
 
         python::list StaticStructF::computeArray(int nqx, int nqy, int nqz,
                 real bin_factor) const {
-            time_t start;
-            time(&start);
-            cout << "collective calc starts " << ctime(&start) << "\n";
-            //fist the system coords are saved at each CPU
             System& system = getSystemRef();
-            esutil::Error err(system.comm);
             Real3D Li = system.bc->getBoxL(); //Box size (Lx, Ly, Lz)
 
-            int nprocs = system.comm->size(); // number of CPUs
             int myrank = system.comm->rank(); // current CPU's number
 
-            if (myrank == 0) {
-                cout << "collective calc starts " << ctime(&start) << "\n";
-            }
-
-            int num_part = 0;
-            ConfigurationPtr config = make_shared<Configuration > ();
-            // loop over all CPU-numbers - to give all CPUs all particle coords
-            for (int rank_i = 0; rank_i < nprocs; rank_i++) {
-                map< size_t, Real3D > conf;
-                if (rank_i == myrank) {
-                    CellList realCells = system.storage->getRealCells();
-                    for (CellListIterator cit(realCells); !cit.isDone(); ++cit) {
-                        int id = cit->id();
-                        conf[id] = cit->position();
-                    }
-                }
-                boost::mpi::broadcast(*system.comm, conf, rank_i);
-
-                // for simplicity we will number the particles from 0
-                for (map<size_t, Real3D>::iterator itr = conf.begin(); itr != conf.end(); ++itr) {
-                    size_t id = itr->first;
-                    Real3D p = itr->second;
-                    config->set(id, p[0], p[1], p[2]);
-                    //config->set(num_part, p[0], p[1], p[2]);
-                    num_part++;
-                }
-            }
-            if (myrank == 0) {
-                time_t distributed;
-                time(&distributed);
-                cout << "particles on all CPUs " << ctime(&distributed) << "\n";
-                cout << "distribution to CPUs took "
-                        << difftime(distributed, start) << " seconds \n";
-            }
-            // now all CPUs have all particle coords and num_part is the total number
-            // of particles
-
-            // use all CPUs
-            // TODO it could be a problem if   n_nodes > num_part
-
-            // here starts calculation of the static structure factor
-
             //step size for qx, qy, qz
             real dqs[3];
             dqs[0] = 2. * M_PIl / Li[0];
             dqs[1] = 2. * M_PIl / Li[1];
             dqs[2] = 2. * M_PIl / Li[2];
 
-            Real3D q;
-
-            //calculations for binning
-            real bin_size = bin_factor * min(dqs[0], (dqs[1], dqs[2]));
-            real q_sqr_max = nqx * nqx * dqs[0] * dqs[0]
-                    + nqy * nqy * dqs[1] * dqs[1]
-                    + nqz * nqz * dqs[2] * dqs[2];
-            real q_max = sqrt(q_sqr_max);
-            int num_bins = (int) ceil(q_max / bin_size);
-            vector<real> sq_bin;
-            vector<real> q_bin;
-            vector<int> count_bin;
-            sq_bin.resize(num_bins);
-            q_bin.resize(num_bins);
-            count_bin.resize(num_bins);
+            //combinations with negative hz are left out, because the 
+            //vectors q and -q give the same result in S(q)
+            PhaseSums phaseSums(nqx, nqy, nqz, dqs);
+            int nq = phaseSums.size();
+            vector<dcomplex> sum(nq, dcomplex(0.0, 0.0));
 
-            if (myrank == 0) {
-                cout << nprocs << " CPUs\n\n"
-                        << "bin size \t" << bin_size << "\n"
-                        << "q_max    \t" << q_max << "\n";
+            CellList realCells = system.storage->getRealCells();
+            for (CellListIterator cit(realCells); !cit.isDone(); ++cit) {
+                phaseSums.add(cit->position(), &sum[0]);
             }
 
-            real n_reci = 1. / num_part;
-            real scos_local = 0; //will store cos-sum on each CPU
-            real ssin_local = 0; //will store sin-sum on each CPU
-            int ppp = (int) ceil((double) num_part / nprocs); //particles per proc
+            int myN = system.storage->getNRealParticles();
+            int num_part = 0;
+            boost::mpi::all_reduce(*system.comm, myN, num_part, plus<int>());
 
-            Real3D coordP;
+            // complex numbers are reduced as pairs of reals
+            vector<dcomplex> totSum(nq);
+            if (myrank == 0) {
+                boost::mpi::reduce(*system.comm, reinterpret_cast<real*>(&sum[0]), 2 * nq,
+                        reinterpret_cast<real*>(&totSum[0]), plus<real>(), 0);
+            } else {
+                boost::mpi::reduce(*system.comm, reinterpret_cast<real*>(&sum[0]), 2 * nq,
+                        plus<real>(), 0);
+            }
 
             python::list pyli;
-
-            //loop over different q values
-            //starting from zero because combinations with negative components 
-            //will give the same result in S(q). so S(q) is the same for
-            //the 8 vectors q=(x,y,z),(-x,y,z), (x,-y,z),(x,y,-z),(-x,-y,z),...
-            for (int hx = -nqx; hx <= nqx; hx++) {
-                for (int hy = -nqy; hy <= nqy; hy++) {
-                    for (int hz = 0; hz <= nqz; hz++) {
-
-                        //values of q-vector
-                        q[0] = hx * dqs[0];
-                        q[1] = hy * dqs[1];
-                        q[2] = hz * dqs[2];
-                        real q_abs = q.abs();
-
-                        //determining the bin number
-                        int bin_i = (int) floor(q_abs / bin_size);
-                        q_bin[bin_i] += q_abs;
-                        count_bin[bin_i] += 1;
-
-                        //resetting the variables that store the local sum on each proc
-                        scos_local = 0;
-                        ssin_local = 0;
-
-                        //loop over particles
-                        for (int k = myrank * ppp; k < (1 + myrank) * ppp && k < num_part;
-                                k++) {
-                            coordP = config->getCoordinates(k);
-                            scos_local += cos(q * coordP);
-                            ssin_local += sin(q * coordP);
-                        }
-                        if (myrank != 0) {
-                            boost::mpi::reduce(*system.comm, scos_local, plus<real > (), 0);
-                            boost::mpi::reduce(*system.comm, ssin_local, plus<real > (), 0);
-                        }
-
-                        if (myrank == 0) {
-                            real scos = 0;
-                            real ssin = 0;
-                            boost::mpi::reduce(*system.comm, scos_local, scos, plus<real > (), 0);
-                            boost::mpi::reduce(*system.comm, ssin_local, ssin, plus<real > (), 0);
-                            sq_bin[bin_i] += scos * scos + ssin * ssin;
-                        }
-                    }
-                }
-            }
             //creates the python list with the results            
             if (myrank == 0) {
-                //starting with bin_i = 1 will leave out the value for q=0, otherwise start with bin_i=0
-                for (int bin_i = 1; bin_i < num_bins; bin_i++) {
-                    real c = (count_bin[bin_i]) ? 1 / (real) count_bin[bin_i] : 0;
-                    sq_bin[bin_i] = n_reci * sq_bin[bin_i] * c;
-                    q_bin[bin_i] = q_bin[bin_i] * c;
-
-                    python::tuple q_Sq_pair;
-                    q_Sq_pair = python::make_tuple(q_bin[bin_i], sq_bin[bin_i]);
-                    pyli.append(q_Sq_pair);
-                }
+                vector<real> sq(nq);
+                for (int i = 0; i < nq; i++) sq[i] = norm(totSum[i]);
+                pyli = binSq(sq, nqx, nqy, nqz, dqs, bin_factor, 1. / num_part);
             }
             return pyli;
         }
 
         // this routine is for ordered configurations, e.g. particle 0 to 9 
         // belong to chain 1, particle 10 to 19 to chain 2 etc.        
+        //
+        // The particles are sent to the CPU that handles their chain with
+        // one all-to-all exchange, then every CPU sums the phase factors of
+        // its chains and the squared sums are combined by a single reduction.
 
         python::list StaticStructF::computeArraySingleChain(int nqx, int nqy, int nqz,
                 real bin_factor, int chainlength) const {
-            //fist the system coords are saved at each CPU
             System& system = getSystemRef();
-            esutil::Error err(system.comm);
             Real3D Li = system.bc->getBoxL(); //Box size (Lx, Ly, Lz)
 
             int nprocs = system.comm->size(); // number of CPUs
             int myrank = system.comm->rank(); // current CPU's number
 
+            int myN = system.storage->getNRealParticles();
             int num_part = 0;
-            ConfigurationPtr config = make_shared<Configuration > ();
-            // loop over all CPU-numbers - to give all CPUs all particle coords
-            for (int rank_i = 0; rank_i < nprocs; rank_i++) {
-                map< size_t, Real3D > conf;
-                if (rank_i == myrank) {
-                    CellList realCells = system.storage->getRealCells();
-                    for (CellListIterator cit(realCells); !cit.isDone(); ++cit) {
-                        int id = cit->id();
-                        conf[id] = cit->position();
-                    }
-                }
-                boost::mpi::broadcast(*system.comm, conf, rank_i);
-
-                // for simplicity we will number the particles from 0
-                for (map<size_t, Real3D>::iterator itr = conf.begin(); itr != conf.end(); ++itr) {
-                    size_t id = itr->first;
-                    Real3D p = itr->second;
-                    config->set(id, p[0], p[1], p[2]);
-                    //config->set(num_part, p[0], p[1], p[2]);
-                    num_part++;
+            boost::mpi::all_reduce(*system.comm, myN, num_part, plus<int>());
+
+            python::list pyli;
+
+            //calculations for parallelizing (over chains)
+            if (num_part % chainlength != 0) {
+                if (myrank == 0) {
+                    cout << "ERROR: chainlenght does not match total number of "
+                            << "particles. num_part % chainlenght is unequal 0. \n"
+                            << "Calculation of SingleChain_StaticStructF aborted\n";
                 }
+                return pyli;
             }
-            cout << "particles are given to each CPU!\n";
-            // now all CPUs have all particle coords and num_part is the total number
-            // of particles   
+            int num_chains = num_part / chainlength;
+            int cpp = (int) ceil((double) num_chains / nprocs); //chains per proc
 
-            // use all CPUs
-            // TODO it could be a problem if   n_nodes > num_part
+            // send every particle to the CPU of its chain, the id goes along
+            // as the fourth value so that the chain is known on arrival
+            vector< vector<real> > sendBuf(nprocs), recvBuf(nprocs);
+            CellList realCells = system.storage->getRealCells();
+            for (CellListIterator cit(realCells); !cit.isDone(); ++cit) {
+                size_t id = cit->id();
+                int cpu = min((int) (id / chainlength) / cpp, nprocs - 1);
+                const Real3D& pos = cit->position();
+                sendBuf[cpu].push_back(pos[0]);
+                sendBuf[cpu].push_back(pos[1]);
+                sendBuf[cpu].push_back(pos[2]);
+                sendBuf[cpu].push_back((real) id);
+            }
+            boost::mpi::all_to_all(*system.comm, sendBuf, recvBuf);
 
-            // here starts calculation of the static structure factor
+            int firstChain = myrank * cpp;
+            int myChains = max(0, min(cpp, num_chains - firstChain));
+            vector< vector<Real3D> > chains(myChains);
+            for (int rank_i = 0; rank_i < nprocs; rank_i++) {
+                vector<real>& buf = recvBuf[rank_i];
+                for (size_t i = 0; i + 3 < buf.size(); i += 4) {
+                    int cid = (int) ((size_t) buf[i + 3] / chainlength) - firstChain;
+                    if (cid >= 0 && cid < myChains)
+                        chains[cid].push_back(Real3D(buf[i], buf[i + 1], buf[i + 2]));
+                }
+            }
 
             //step size for qx, qy, qz
             real dqs[3];
@@ -262,117 +271,32 @@ namespace espressopp {
             dqs[1] = 2. * M_PIl / Li[1];
             dqs[2] = 2. * M_PIl / Li[2];
 
-            Real3D q;
-
-            //calculations for binning
-            real bin_size = bin_factor * min(dqs[0], (dqs[1], dqs[2]));
-            real q_sqr_max = nqx * nqx * dqs[0] * dqs[0]
-                    + nqy * nqy * dqs[1] * dqs[1]
-                    + nqz * nqz * dqs[2] * dqs[2];
-            real q_max = sqrt(q_sqr_max);
-            int num_bins = (int) ceil(q_max / bin_size);
-            vector<real> sq_bin;
-            vector<real> q_bin;
-            vector<int> count_bin;
-            sq_bin.resize(num_bins);
-            q_bin.resize(num_bins);
-            count_bin.resize(num_bins);
-
-            if (myrank == 0) {
-                cout << nprocs << " CPUs\n\n"
-                        << "bin size \t" << bin_size << "\n"
-                        << "q_max    \t" << q_max << "\n";
-            }
-
-            real n_reci = 1. / num_part;
-            real chainlength_reci = 1. / chainlength;
-            real scos_local = 0; //will store cos-sum on each CPU
-            real ssin_local = 0; //will store sin-sum on each CPU   
+            PhaseSums phaseSums(nqx, nqy, nqz, dqs);
+            int nq = phaseSums.size();
+            vector<dcomplex> chainSum(nq);
             //will store the summation of the the single chain structure factor
-            real singleChain_localSum = 0;
-            Real3D coordP;
-            python::list pyli;
+            vector<real> sq(nq, 0.0);
 
-            //calculations for parallelizing (over chains)
-            int num_chains;
-            if (num_part % chainlength == 0)
-                num_chains = num_part / chainlength;
-            else {
-                cout << "ERROR: chainlenght does not match total number of "
-                        << "particles. num_part % chainlenght is unequal 0. \n"
-                        << "Calculation of SingleChain_StaticStructF aborted\n";
-                return pyli;
+            for (int cid = 0; cid < myChains; cid++) {
+                fill(chainSum.begin(), chainSum.end(), dcomplex(0.0, 0.0));
+                for (size_t k = 0; k < chains[cid].size(); k++) {
+                    phaseSums.add(chains[cid][k], &chainSum[0]);
+                }
+                for (int i = 0; i < nq; i++) sq[i] += norm(chainSum[i]);
             }
-            int cpp = (int) ceil((double) num_chains / nprocs); //chains per proc
-            cout << "chains per proc\t" << cpp << "\n";
-
-
-            //loop over different q values
-            //starting from zero because combinations with negative components 
-            //will give the same result in S(q). so S(q) is the same for
-            //the 8 vectors q=(x,y,z),(-x,y,z), (x,-y,z),(x,y,-z),(-x,-y,z),...
-            for (int hx = -nqx; hx <= nqx; hx++) {
-                for (int hy = -nqy; hy <= nqy; hy++) {
-                    for (int hz = 0; hz <= nqz; hz++) {
-
-                        //values of q-vector
-                        q[0] = hx * dqs[0];
-                        q[1] = hy * dqs[1];
-                        q[2] = hz * dqs[2];
-                        real q_abs = q.abs();
-
-                        //determining the bin number
-                        int bin_i = (int) floor(q_abs / bin_size);
-                        q_bin[bin_i] += q_abs;
-                        count_bin[bin_i] += 1;
-
-                        //resetting the variable that stores the sum for each q-vector
-                        singleChain_localSum = 0;
-
-                        //loop over chains (cid is chain_id)
-                        for (int cid = myrank * cpp; cid < (1 + myrank) * cpp
-                                && cid < num_chains; cid++) {
-                            scos_local = 0; //resetting the cos sum for the each chain
-                            ssin_local = 0; //resetting the sin sum for the each chain
-                            //loop over particles
-                            for (int k = cid * chainlength; k < (1 + cid) * chainlength && k < num_part;
-                                    k++) {
-                                coordP = config->getCoordinates(k);
-                                scos_local += cos(q * coordP);
-                                ssin_local += sin(q * coordP);
-                            }
-                            //the (summation part of the) single chain structure 
-                            // factors are summed up for the averaging at the 
-                            // end (over the chains)
-                            singleChain_localSum += scos_local * scos_local
-                                    + ssin_local * ssin_local;
-                        }
-
-
-                        if (myrank != 0) {
-                            boost::mpi::reduce(*system.comm, singleChain_localSum, plus<real > (), 0);
-                        }
 
-                        if (myrank == 0) {
-                            real singleChainSum = 0;
-                            boost::mpi::reduce(*system.comm, singleChain_localSum, singleChainSum, plus<real > (), 0);
-                            sq_bin[bin_i] += singleChainSum;
-                        }
-                    }
-                }
+            vector<real> totSq(nq);
+            if (myrank == 0) {
+                boost::mpi::reduce(*system.comm, &sq[0], nq, &totSq[0], plus<real>(), 0);
+            } else {
+                boost::mpi::reduce(*system.comm, &sq[0], nq, plus<real>(), 0);
             }
+
             //creates the python list with the results            
             if (myrank == 0) {
-                //starting with bin_i = 1 will leave out the value for q=0, otherwise start with bin_i=0
-                for (int bin_i = 1; bin_i < num_bins; bin_i++) {
-                    real c = (count_bin[bin_i]) ? 1 / (real) count_bin[bin_i] : 0;
-                    sq_bin[bin_i] = n_reci * chainlength_reci * sq_bin[bin_i] * c;
-                    q_bin[bin_i] = q_bin[bin_i] * c;
-
-                    python::tuple q_Sq_pair;
-                    q_Sq_pair = python::make_tuple(q_bin[bin_i], sq_bin[bin_i]);
-                    pyli.append(q_Sq_pair);
-                }
+                real n_reci = 1. / num_part;
+                real chainlength_reci = 1. / chainlength;
+                pyli = binSq(totSq, nqx, nqy, nqz, dqs, bin_factor, n_reci * chainlength_reci);
             }
             return pyli;
         }
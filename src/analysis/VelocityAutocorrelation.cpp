@@ -43,14 +43,6 @@ namespace espressopp {
       
       System& system = getSystemRef();
       
-      vector<longint> localIDs;
-      for (map<size_t,int>::const_iterator itr=idToCpu.begin(); itr!=idToCpu.end(); ++itr) {
-        size_t i = itr->first;
-        int whichCPU = itr->second;
-        if(system.comm->rank()==whichCPU){
-          localIDs.push_back(i);
-        }
-      }
  
       int perc=0;
       real denom = 100.0 / (real)M;
@@ -58,11 +50,12 @@ namespace espressopp {
         totZ[m] = 0.0;
         Z[m] = 0.0;
         for(int n=0; n<M-m; n++){
-          for (vector<longint>::iterator itr=localIDs.begin(); itr!=localIDs.end(); ++itr) {
-            size_t i = *itr;
-            Real3D vel1 = getConf(n + m)->getCoordinates(i);
-            Real3D vel2 = getConf(n)->getCoordinates(i);
-            Z[m] += vel1 * vel2;
+          // the configurations hold exactly the localIDs, sorted by id
+          const vector<Real3D>& vel1 = getConf(n + m)->getCoordinatesArray();
+          const vector<Real3D>& vel2 = getConf(n)->getCoordinatesArray();
+          size_t nLocal = vel2.size();
+          for (size_t k = 0; k < nLocal; k++) {
+            Z[m] += vel1[k] * vel2[k];
           }
         }
         /*
@@ -0,0 +1,123 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "CounterRNG.hpp"
+#include <cmath>
+#include <boost/random.hpp>
+
+using namespace boost;
+
+namespace espressopp {
+  namespace esutil {
+
+    namespace {
+      const uint32_t PHILOX_M0 = 0xD2511F53u;
+      const uint32_t PHILOX_M1 = 0xCD9E8D57u;
+      const uint32_t PHILOX_W0 = 0x9E3779B9u;
+      const uint32_t PHILOX_W1 = 0xBB67AE85u;
+      const int PHILOX_ROUNDS = 10;
+
+      inline void mulhilo(uint32_t a, uint32_t b, uint32_t &hi, uint32_t &lo) {
+	uint64_t p = uint64_t(a) * b;
+	hi = uint32_t(p >> 32);
+	lo = uint32_t(p);
+      }
+    }
+
+    /* The first counter word holds the block number in its lower and the
+       upper bits of the step in its upper 16 bits. */
+    CounterRNG::CounterRNG(long seed, unsigned int stream,
+			   long long step, longint id, longint partner)
+      : used(4)
+    {
+      key[0] = uint32_t(seed);
+      key[1] = uint32_t(stream);
+      ctr[0] = uint32_t(uint64_t(step) >> 32) << 16;
+      ctr[1] = uint32_t(id);
+      ctr[2] = uint32_t(partner);
+      ctr[3] = uint32_t(step);
+    }
+
+    void CounterRNG::philox(const result_type _ctr[4], const result_type _key[2],
+			    result_type out[4]) {
+      uint32_t c0 = _ctr[0], c1 = _ctr[1], c2 = _ctr[2], c3 = _ctr[3];
+      uint32_t k0 = _key[0], k1 = _key[1];
+      for (int r = 0; r < PHILOX_ROUNDS; ++r) {
+	uint32_t hi0, lo0, hi1, lo1;
+	mulhilo(PHILOX_M0, c0, hi0, lo0);
+	mulhilo(PHILOX_M1, c2, hi1, lo1);
+	c0 = hi1 ^ c1 ^ k0;
+	c1 = lo1;
+	c2 = hi0 ^ c3 ^ k1;
+	c3 = lo0;
+	k0 += PHILOX_W0;
+	k1 += PHILOX_W1;
+      }
+      out[0] = c0;
+      out[1] = c1;
+      out[2] = c2;
+      out[3] = c3;
+    }
+
+    void CounterRNG::nextBlock() {
+      philox(ctr, key, block);
+      // the block number wraps within its 16 bits
+      ctr[0] = (ctr[0] & 0xFFFF0000u) | ((ctr[0] + 1) & 0xFFFFu);
+      used = 0;
+    }
+
+    CounterRNG::result_type CounterRNG::operator()() {
+      if (used == 4) nextBlock();
+      return block[used++];
+    }
+
+    real CounterRNG::uniform() {
+      // never 0 or 1, so that the result can go into a logarithm
+      return (real((*this)()) + 0.5) * (1.0 / 4294967296.0);
+    }
+
+    void CounterRNG::uniform(real *out, int n) {
+      for (int i = 0; i < n; ++i) out[i] = uniform();
+    }
+
+    real CounterRNG::normal() {
+      real u1 = uniform();
+      real u2 = uniform();
+      return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+    }
+
+    void CounterRNG::normal(real *out, int n) {
+      int i = 0;
+      for (; i + 1 < n; i += 2) {
+	real r = sqrt(-2.0 * log(uniform()));
+	real phi = 2.0 * M_PI * uniform();
+	out[i] = r * cos(phi);
+	out[i + 1] = r * sin(phi);
+      }
+      if (i < n) out[i] = normal();
+    }
+
+    real CounterRNG::gamma(unsigned int alpha) {
+      gamma_distribution< real > gamma_dist(alpha, 1.0); //scale parameter \beta=1.0
+      variate_generator< CounterRNG&, gamma_distribution< real > > gamma_var(*this, gamma_dist);
+      return gamma_var();
+    }
+  }
+}
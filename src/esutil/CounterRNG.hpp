@@ -0,0 +1,102 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// ESPP_CLASS
+#ifndef _ESUTIL_COUNTERRNG_HPP
+#define _ESUTIL_COUNTERRNG_HPP
+#include <boost/cstdint.hpp>
+#include "types.hpp"
+
+namespace espressopp {
+  namespace esutil {
+
+    /** Counter-based random number generator (Philox-4x32-10, Salmon et
+	al., SC'11).
+
+	The numbers are a function of the key (seed, stream) and of the
+	counter (step, id, partner) only. Unlike the stateful RNG they
+	neither depend on the number of CPUs nor on the order in which the
+	particles are visited, so every particle (or pair) can draw its
+	noise independently, e.g. from different threads, and a restarted
+	run reproduces the noise bitwise. Successive draws run through
+	consecutive counter blocks, 65536 blocks of 4 numbers per counter.
+
+	Different users of the same seed have to use different streams,
+	otherwise they draw the same numbers. The class models the boost
+	UniformRandomNumberGenerator concept, so that boost distributions
+	can be used on top of it.
+    */
+    class CounterRNG {
+
+    public:
+      typedef boost::uint32_t result_type;
+      static const bool has_fixed_range = false;
+
+      /** streams of the thermostats */
+      enum Stream {
+	STREAM_LANGEVIN = 1,
+	STREAM_DPD = 2,
+	STREAM_TDPD = 3,
+	STREAM_SVR = 4
+      };
+
+      CounterRNG(long seed, unsigned int stream,
+		 long long step, longint id, longint partner = 0);
+
+      /** returns the next 32 bit random integer */
+      result_type operator()();
+
+      result_type min() const { return 0; }
+      result_type max() const { return 0xFFFFFFFFu; }
+
+      /** returns a uniformly distributed random number in (0, 1). */
+      real uniform();
+
+      /** fills out[0..n-1] with uniformly distributed random numbers
+	  in (0, 1). */
+      void uniform(real *out, int n);
+
+      /** returns a normal distributed random number, with mean of 0.0
+	  and sigma of 1.0. */
+      real normal();
+
+      /** fills out[0..n-1] with normal distributed random numbers,
+	  with mean of 0.0 and sigma of 1.0 (Box-Muller). */
+      void normal(real *out, int n);
+
+      /** returns a gamma distributed random number with shape parameter
+       \alpha and scale parameter 1.  */
+      real gamma(unsigned int alpha = 1);
+
+      /** the Philox-4x32-10 bijection of ctr under key */
+      static void philox(const result_type ctr[4], const result_type key[2],
+			 result_type out[4]);
+
+    private:
+      result_type key[2];
+      result_type ctr[4];
+      result_type block[4];  //!< numbers of the current counter block
+      int used;              //!< numbers of block already handed out
+
+      void nextBlock();
+    };
+  }
+}
+#endif
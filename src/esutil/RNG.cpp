@@ -73,6 +73,11 @@ namespace espressopp {
       return uniformOnSphereVariate();
     }
 
+    CounterRNG RNG::counter(unsigned int stream, long long step,
+			    longint id, longint partner) const {
+      return CounterRNG(seed_, stream, step, id, partner);
+    }
+
     shared_ptr< RNGType > RNG::getBoostRNG() {
       return boostRNG;
     }
@@ -25,6 +25,7 @@
 #define _ESUTIL_RNG_HPP
 #include <boost/random.hpp>
 #include "Real3D.hpp"
+#include "CounterRNG.hpp"
 #include <vector>
 
 
@@ -71,6 +72,12 @@ namespace espressopp {
       /** returns a random 3D vector that is uniformly distributed on a sphere. */
       Real3D uniformOnSphere();
 
+      /** returns the counter-based generator for the given stream and
+	  counter. It is keyed on the seed without the CPU rank, so it
+	  gives the same numbers on every CPU, see CounterRNG. */
+      CounterRNG counter(unsigned int stream, long long step,
+			 longint id, longint partner = 0) const;
+
       shared_ptr< RNGType > getBoostRNG();
 
       static void registerPython();
@@ -0,0 +1,194 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "SlabFFT.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace espressopp {
+  namespace esutil {
+
+    SlabFFT::SlabFFT(const mpi::communicator &_comm, const Int3D &_M)
+      : comm(_comm), M(_M), rank(_comm.rank()),
+        planYZForward(0), planYZBackward(0), planXForward(0), planXBackward(0)
+    {
+      if (M[0] <= 0 || M[1] <= 0 || M[2] <= 0) {
+        throw std::runtime_error("SlabFFT: mesh size must be positive");
+      }
+
+      // with more nodes than planes, the last nodes own empty slabs
+      int nNodes = comm.size();
+      xStart.resize(nNodes + 1);
+      yStart.resize(nNodes + 1);
+      for (int r = 0; r <= nNodes; ++r) {
+        xStart[r] = int(longint(r) * M[0] / nNodes);
+        yStart[r] = int(longint(r) * M[1] / nNodes);
+      }
+
+      sendCounts.resize(nNodes);
+      sendDispls.resize(nNodes);
+      recvCounts.resize(nNodes);
+      recvDispls.resize(nNodes);
+
+      // fftw_malloc does not like zero sizes
+      realSpace = static_cast< fftw_complex* >(fftw_malloc(sizeof(fftw_complex) * std::max(realSpaceSize(), longint(1))));
+      kSpace = static_cast< fftw_complex* >(fftw_malloc(sizeof(fftw_complex) * std::max(kSpaceSize(), longint(1))));
+
+      int nx = getXEnd() - getXBegin();
+      if (nx > 0) {
+        fftw_iodim dims[2] = { { M[1], M[2], M[2] }, { M[2], 1, 1 } };
+        fftw_iodim howmany[1] = { { nx, M[1] * M[2], M[1] * M[2] } };
+        planYZForward = fftw_plan_guru_dft(2, dims, 1, howmany, realSpace, realSpace,
+                                           FFTW_FORWARD, FFTW_ESTIMATE);
+        planYZBackward = fftw_plan_guru_dft(2, dims, 1, howmany, realSpace, realSpace,
+                                            FFTW_BACKWARD, FFTW_ESTIMATE);
+      }
+
+      int ny = getYEnd() - getYBegin();
+      if (ny > 0) {
+        fftw_iodim dims[1] = { { M[0], M[2], M[2] } };
+        fftw_iodim howmany[2] = { { ny, M[0] * M[2], M[0] * M[2] }, { M[2], 1, 1 } };
+        planXForward = fftw_plan_guru_dft(1, dims, 2, howmany, kSpace, kSpace,
+                                          FFTW_FORWARD, FFTW_ESTIMATE);
+        planXBackward = fftw_plan_guru_dft(1, dims, 2, howmany, kSpace, kSpace,
+                                           FFTW_BACKWARD, FFTW_ESTIMATE);
+      }
+    }
+
+    SlabFFT::~SlabFFT() {
+      if (planYZForward) fftw_destroy_plan(planYZForward);
+      if (planYZBackward) fftw_destroy_plan(planYZBackward);
+      if (planXForward) fftw_destroy_plan(planXForward);
+      if (planXBackward) fftw_destroy_plan(planXBackward);
+      fftw_free(realSpace);
+      fftw_free(kSpace);
+    }
+
+    int SlabFFT::getXOwner(int x) const {
+      // first node whose slab ends behind x; empty slabs are skipped
+      return int(std::upper_bound(xStart.begin(), xStart.end(), x) - xStart.begin()) - 1;
+    }
+
+    void SlabFFT::forward() {
+      if (planYZForward) fftw_execute(planYZForward);
+      transposeToK();
+      if (planXForward) fftw_execute(planXForward);
+    }
+
+    void SlabFFT::backward() {
+      if (planXBackward) fftw_execute(planXBackward);
+      transposeToReal();
+      if (planYZBackward) fftw_execute(planYZBackward);
+    }
+
+    /* The block exchanged between the nodes r and s consists of the
+       x planes of r and the y planes of s, ordered as (x, y, z) in both
+       directions. Counts are in reals, two per complex number. */
+    void SlabFFT::setCounts(bool toK) {
+      int nNodes = comm.size();
+      int sendTotal = 0, recvTotal = 0;
+      for (int s = 0; s < nNodes; ++s) {
+        int mine, theirs;
+        if (toK) {
+          mine = (getXEnd() - getXBegin()) * (yStart[s + 1] - yStart[s]);
+          theirs = (xStart[s + 1] - xStart[s]) * (getYEnd() - getYBegin());
+        } else {
+          mine = (xStart[s + 1] - xStart[s]) * (getYEnd() - getYBegin());
+          theirs = (getXEnd() - getXBegin()) * (yStart[s + 1] - yStart[s]);
+        }
+        sendCounts[s] = 2 * mine * M[2];
+        recvCounts[s] = 2 * theirs * M[2];
+        sendDispls[s] = sendTotal;
+        recvDispls[s] = recvTotal;
+        sendTotal += sendCounts[s];
+        recvTotal += recvCounts[s];
+      }
+      sendBuf.resize(std::max(sendTotal / 2, 1));
+      recvBuf.resize(std::max(recvTotal / 2, 1));
+    }
+
+    void SlabFFT::transposeToK() {
+      int nNodes = comm.size();
+      setCounts(true);
+
+      const Complex *rs = getRealSpace();
+      Complex *b = &sendBuf[0];
+      int nx = getXEnd() - getXBegin();
+      for (int s = 0; s < nNodes; ++s) {
+        for (int xl = 0; xl < nx; ++xl) {
+          for (int y = yStart[s]; y < yStart[s + 1]; ++y) {
+            const Complex *row = rs + (longint(xl) * M[1] + y) * M[2];
+            b = std::copy(row, row + M[2], b);
+          }
+        }
+      }
+
+      // real is double, see the FFTW types
+      MPI_Alltoallv(&sendBuf[0], &sendCounts[0], &sendDispls[0], MPI_DOUBLE,
+                    &recvBuf[0], &recvCounts[0], &recvDispls[0], MPI_DOUBLE,
+                    static_cast< MPI_Comm >(comm));
+
+      Complex *ks = getKSpace();
+      const Complex *rb = &recvBuf[0];
+      int ny = getYEnd() - getYBegin();
+      for (int r = 0; r < nNodes; ++r) {
+        for (int x = xStart[r]; x < xStart[r + 1]; ++x) {
+          for (int yl = 0; yl < ny; ++yl) {
+            std::copy(rb, rb + M[2], ks + (longint(yl) * M[0] + x) * M[2]);
+            rb += M[2];
+          }
+        }
+      }
+    }
+
+    void SlabFFT::transposeToReal() {
+      int nNodes = comm.size();
+      setCounts(false);
+
+      const Complex *ks = getKSpace();
+      Complex *b = &sendBuf[0];
+      int ny = getYEnd() - getYBegin();
+      for (int s = 0; s < nNodes; ++s) {
+        for (int x = xStart[s]; x < xStart[s + 1]; ++x) {
+          for (int yl = 0; yl < ny; ++yl) {
+            const Complex *row = ks + (longint(yl) * M[0] + x) * M[2];
+            b = std::copy(row, row + M[2], b);
+          }
+        }
+      }
+
+      MPI_Alltoallv(&sendBuf[0], &sendCounts[0], &sendDispls[0], MPI_DOUBLE,
+                    &recvBuf[0], &recvCounts[0], &recvDispls[0], MPI_DOUBLE,
+                    static_cast< MPI_Comm >(comm));
+
+      Complex *rs = getRealSpace();
+      const Complex *rb = &recvBuf[0];
+      int nx = getXEnd() - getXBegin();
+      for (int r = 0; r < nNodes; ++r) {
+        for (int xl = 0; xl < nx; ++xl) {
+          for (int y = yStart[r]; y < yStart[r + 1]; ++y) {
+            std::copy(rb, rb + M[2], rs + (longint(xl) * M[1] + y) * M[2]);
+            rb += M[2];
+          }
+        }
+      }
+    }
+  }
+}
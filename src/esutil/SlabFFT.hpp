@@ -0,0 +1,99 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _ESUTIL_SLABFFT_HPP
+#define _ESUTIL_SLABFFT_HPP
+
+#include <complex>
+#include <vector>
+#include <boost/noncopyable.hpp>
+#include <fftw3.h>
+#include "mpi.hpp"
+#include "types.hpp"
+#include "Int3D.hpp"
+
+namespace espressopp {
+  namespace esutil {
+
+    /** Distributed complex 3D FFT of an M[0] x M[1] x M[2] mesh.
+
+        In real space, every node owns the planes x in
+        [getXBegin(), getXEnd()), element (x, y, z) at
+        ((x - getXBegin()) * M[1] + y) * M[2] + z of getRealSpace().
+        In k space, every node owns the planes ky in
+        [getYBegin(), getYEnd()), element (kx, ky, kz) at
+        ((ky - getYBegin()) * M[0] + kx) * M[2] + kz of getKSpace().
+
+        The forward transform does the 2D FFTs of the local x planes,
+        transposes the mesh to the y planes by one all-to-all
+        communication and does the 1D FFTs along x; the backward
+        transform runs the other way round. As in FFTW, the transforms
+        are not normalized. The function is SPMD, all nodes of the
+        communicator have to call the transforms together.
+    */
+    class SlabFFT : boost::noncopyable {
+    public:
+      typedef std::complex< real > Complex;
+
+      SlabFFT(const mpi::communicator &comm, const Int3D &M);
+      ~SlabFFT();
+
+      const Int3D &getMesh() const { return M; }
+
+      int getXBegin() const { return xStart[rank]; }
+      int getXEnd() const { return xStart[rank + 1]; }
+      int getYBegin() const { return yStart[rank]; }
+      int getYEnd() const { return yStart[rank + 1]; }
+
+      /** node owning the real space plane x */
+      int getXOwner(int x) const;
+
+      Complex *getRealSpace() { return reinterpret_cast< Complex* >(realSpace); }
+      Complex *getKSpace() { return reinterpret_cast< Complex* >(kSpace); }
+
+      /** number of local mesh points in real and in k space */
+      longint realSpaceSize() const { return longint(getXEnd() - getXBegin()) * M[1] * M[2]; }
+      longint kSpaceSize() const { return longint(getYEnd() - getYBegin()) * M[0] * M[2]; }
+
+      /** transform the real space mesh, which is overwritten, to k space */
+      void forward();
+
+      /** transform the k space mesh, which is overwritten, to real space */
+      void backward();
+
+    private:
+      const mpi::communicator &comm;
+      Int3D M;
+      int rank;
+      std::vector< int > xStart, yStart;
+
+      fftw_complex *realSpace, *kSpace;
+      fftw_plan planYZForward, planYZBackward, planXForward, planXBackward;
+
+      std::vector< Complex > sendBuf, recvBuf;
+      std::vector< int > sendCounts, sendDispls, recvCounts, recvDispls;
+
+      void transposeToK();
+      void transposeToReal();
+      void setCounts(bool toK);
+    };
+  }
+}
+#endif
@@ -132,3 +132,74 @@ BOOST_AUTO_TEST_CASE(uniformOnSphere)
   }
 }
 
+
+// Check that the counter-based RNG depends on the counter only
+BOOST_AUTO_TEST_CASE(counter_reproducible)
+{
+  RNG rng(54321);
+  RNG rng2;
+  rng2.seed(54321);
+
+  for (int i = 0; i < 1000; i++) rng();
+
+  real u[8], u2[8];
+  rng.counter(CounterRNG::STREAM_LANGEVIN, 17, 42).uniform(u, 8);
+  rng2.counter(CounterRNG::STREAM_LANGEVIN, 17, 42).uniform(u2, 8);
+  for (int i = 0; i < 8; i++) {
+    BOOST_CHECK_EQUAL(u[i], u2[i]);
+    BOOST_CHECK_GT(u[i], 0.0);
+    BOOST_CHECK_LT(u[i], 1.0);
+  }
+
+  // other step, particle and stream give other numbers
+  BOOST_CHECK_NE(u[0], rng.counter(CounterRNG::STREAM_LANGEVIN, 18, 42).uniform());
+  BOOST_CHECK_NE(u[0], rng.counter(CounterRNG::STREAM_LANGEVIN, 17, 43).uniform());
+  BOOST_CHECK_NE(u[0], rng.counter(CounterRNG::STREAM_DPD, 17, 42).uniform());
+
+  // and all tasks get the same numbers
+  real r = u[0];
+  if (mpiWorld->rank() != 0) {
+    boost::mpi::gather(*mpiWorld, r, 0);
+  } else {
+    std::vector< real > rs;
+    boost::mpi::gather(*mpiWorld, r, rs, 0);
+    for (size_t i = 1; i < rs.size(); i++)
+      BOOST_CHECK_EQUAL(rs[0], rs[i]);
+  }
+}
+
+// Check the Philox-4x32-10 known answers of Random123
+BOOST_AUTO_TEST_CASE(counter_philox)
+{
+  CounterRNG::result_type ctr[4] = { 0, 0, 0, 0 };
+  CounterRNG::result_type key[2] = { 0, 0 };
+  CounterRNG::result_type out[4];
+
+  CounterRNG::philox(ctr, key, out);
+  BOOST_CHECK_EQUAL(out[0], 0x6627e8d5u);
+  BOOST_CHECK_EQUAL(out[1], 0xe169c58du);
+  BOOST_CHECK_EQUAL(out[2], 0xbc57ac4cu);
+  BOOST_CHECK_EQUAL(out[3], 0x9b00dbd8u);
+}
+
+// Test whether the batched counter-based normal numbers are normal
+BOOST_AUTO_TEST_CASE(counter_normal)
+{
+  RNG rng;
+
+  const int N = 100000;
+  std::vector< real > r(N);
+  rng.counter(CounterRNG::STREAM_SVR, 1, 0).normal(&r[0], N);
+
+  real sum = 0.0;
+  real sqrsum = 0.0;
+  for (int i = 0; i < N; i++) {
+    sum += r[i];
+    sqrsum += r[i]*r[i];
+  }
+  real mean = sum / N;
+  real sigma = sqrt(std::abs(mean*mean - sqrsum/N));
+
+  BOOST_CHECK_SMALL(mean, 0.01);
+  BOOST_CHECK_CLOSE(sigma, static_cast<real>(1.0), 1.0);
+}
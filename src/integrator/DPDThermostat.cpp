@@ -28,6 +28,8 @@
 #include "storage/Storage.hpp"
 #include "iterator/CellListIterator.hpp"
 #include "esutil/RNG.hpp"
+#include "esutil/Error.hpp"
+#include <algorithm>
 
 namespace espressopp {
 
@@ -45,6 +47,10 @@ namespace espressopp {
       gamma  = 0.0;
       temperature = 0.0;
 
+      counterRNG = false;
+      recalc = false;
+      noiseStep = 0;
+
       current_cutoff = verletList->getVerletCutoff() - system->getSkin();
       current_cutoff_sqr = current_cutoff*current_cutoff;
       
@@ -85,6 +91,49 @@ namespace espressopp {
       return temperature;
     }
 
+    void DPDThermostat::setCounterRNG(bool _counterRNG)
+    {
+      counterRNG = _counterRNG;
+    }
+
+    bool DPDThermostat::getCounterRNG()
+    {
+      return counterRNG;
+    }
+
+    namespace {
+      // the interaction refers to the thermostat without owning it,
+      // disconnect() takes the reference back
+      struct NoDelete { void operator()(const void *) const {} };
+    }
+
+    void DPDThermostat::fuseWith(shared_ptr< interaction::Interaction > interaction)
+    {
+      if (interaction) {
+        // the pairs of another list would silently replace the own ones
+        esutil::Error err(getSystem()->comm);
+        shared_ptr< VerletList > list = interaction->getPairExtensionList();
+        if (!list) {
+          err.setException("DPDThermostat: the interaction does not support pair extensions");
+        } else if (list != verletList) {
+          err.setException("DPDThermostat: the interaction does not use the Verlet list of the thermostat");
+        }
+        err.checkException();
+      }
+
+      if (fusedInteraction && _thermalize.connected()) {
+        fusedInteraction->setPairExtension(shared_ptr< interaction::PairExtension >());
+      }
+      fusedInteraction = interaction;
+      if (fusedInteraction && _thermalize.connected()) {
+        if (!fusedInteraction->setPairExtension(shared_ptr< interaction::PairExtension >(
+                static_cast< interaction::PairExtension* >(this), NoDelete()))) {
+          fusedInteraction.reset();
+          throw std::runtime_error("DPDThermostat: the interaction does not support pair extensions");
+        }
+      }
+    }
+
     DPDThermostat::~DPDThermostat() {
         disconnect();
     }
@@ -96,6 +145,10 @@ namespace espressopp {
         _heatUp.disconnect();
         _coolDown.disconnect();
         _thermalize.disconnect();
+
+        if (fusedInteraction) {
+          fusedInteraction->setPairExtension(shared_ptr< interaction::PairExtension >());
+        }
     }
 
     void DPDThermostat::connect() {
@@ -110,8 +163,11 @@ namespace espressopp {
         _coolDown = integrator->recalc2.connect(
                 boost::bind(&DPDThermostat::coolDown, this));
 
-        _thermalize = integrator->aftInitF.connect(
+        // the pair loop needs the ghosts
+        _thermalize = integrator->aftInitG.connect(
                 boost::bind(&DPDThermostat::thermalize, this));
+
+        if (fusedInteraction) fuseWith(fusedInteraction);
     }
 
 
@@ -121,6 +177,12 @@ namespace espressopp {
         System& system = getSystemRef();
         system.storage->updateGhostsV();
 
+        // forces computed inside the step loop belong to the next step
+        noiseStep = integrator->getStep() + (recalc ? 0 : 1);
+
+        // the interaction does the pairs, the ghost velocities are all it needs
+        if (fusedInteraction) return;
+
         // loop over VL pairs
         for (PairList::Iterator it(verletList->getPairs()); it.isValid(); ++it) {
             Particle &p1 = *it->first;
@@ -131,8 +193,24 @@ namespace espressopp {
     }
 
 
+    void DPDThermostat::beginPairs() {
+        // with the ghost update overlapped, the interior pairs come before thermalize()
+        noiseStep = integrator->getStep() + (recalc ? 0 : 1);
+    }
+
+    void DPDThermostat::addPairForce(Real3D& force, const Particle &p1,
+                                     const Particle &p2, const Real3D& dist) {
+        addForceDPD(force, p1, p2, dist);
+    }
+
     void DPDThermostat::frictionThermoDPD(Particle& p1, Particle& p2) {
-      Real3D r = p1.position() - p2.position();
+      Real3D f(0.0, 0.0, 0.0);
+      addForceDPD(f, p1, p2, p1.position() - p2.position());
+      p1.force() += f;
+      p2.force() -= f;
+    }
+
+    void DPDThermostat::addForceDPD(Real3D& f, const Particle& p1, const Particle& p2, const Real3D& r) {
       real dist2 = r.sqr();
       if(dist2 < current_cutoff_sqr && gamma > 0.0){
         real dist = sqrt(dist2);
@@ -143,11 +221,11 @@ namespace espressopp {
         // standard DPD part
         real veldiff = (p1.velocity() - p2.velocity()) * r;
         real friction = pref1 * omega2 * veldiff;
-        real noise = pref2 * omega * ((*rng)() - 0.5);
+        real ranval = counterRNG ? pairRNG(esutil::CounterRNG::STREAM_DPD, p1, p2).uniform()
+                                 : (*rng)();
+        real noise = pref2 * omega * (ranval - 0.5);
 
-        Real3D f = (noise - friction) * r;
-        p1.force() += f;
-        p2.force() -= f;
+        f += (noise - friction) * r;
       }
     }
 
@@ -162,7 +240,14 @@ namespace espressopp {
 		if (tgamma > 0.0) {
 		  real distinv = omega;
 
-		  Real3D noisevec((*rng)() - 0.5, (*rng)() - 0.5, (*rng)() - 0.5);
+		  Real3D noisevec;
+		  if (counterRNG) {
+			  real u[3];
+			  pairRNG(esutil::CounterRNG::STREAM_TDPD, p1, p2).uniform(u, 3);
+			  noisevec = Real3D(u[0] - 0.5, u[1] - 0.5, u[2] - 0.5);
+		  } else {
+			  noisevec = Real3D((*rng)() - 0.5, (*rng)() - 0.5, (*rng)() - 0.5);
+		  }
 
 		  // damping, random force
 		  Real3D f_damp(0.0, 0.0, 0.0), f_rand(0.0, 0.0, 0.0);
@@ -192,6 +277,12 @@ namespace espressopp {
 		}
 	}
 
+    esutil::CounterRNG DPDThermostat::pairRNG(unsigned int stream, const Particle& p1, const Particle& p2) {
+      longint id1 = p1.id(), id2 = p2.id();
+      if (id1 > id2) std::swap(id1, id2);
+      return rng->counter(stream, noiseStep, id1, id2);
+    }
+
     void DPDThermostat::initialize() {
     	// calculate the prefactors
       System& system = getSystemRef();
@@ -223,10 +314,14 @@ namespace espressopp {
     	LOG4ESPP_INFO(theLogger, "heatUp");
 
     	
+        recalc = true;
         pref2buffer = pref2;
-    	pref2       *= sqrt(3.0);
     	pref4buffer = pref4;
-    	pref4       *= sqrt(3.0);
+        // the counter-based noise of a recalculated force is the one it had before
+        if (!counterRNG) {
+    	  pref2       *= sqrt(3.0);
+    	  pref4       *= sqrt(3.0);
+        }
         
     }
 
@@ -236,6 +331,7 @@ namespace espressopp {
         LOG4ESPP_INFO(theLogger, "coolDown");
 
         
+        recalc = false;
         pref2 = pref2buffer;
         pref4 = pref4buffer;
         
@@ -254,6 +350,8 @@ namespace espressopp {
         .add_property("gamma", &DPDThermostat::getGamma, &DPDThermostat::setGamma)
         .add_property("tgamma", &DPDThermostat::getTGamma, &DPDThermostat::setTGamma)
         .add_property("temperature", &DPDThermostat::getTemperature, &DPDThermostat::setTemperature)
+        .add_property("counterRNG", &DPDThermostat::getCounterRNG, &DPDThermostat::setCounterRNG)
+        .def("fuseWith", &DPDThermostat::fuseWith)
         ;
     }
   }
@@ -29,6 +29,9 @@
 #include "VerletList.hpp"
 #include "Particle.hpp"
 #include "SystemAccess.hpp"
+#include "esutil/CounterRNG.hpp"
+#include "interaction/Interaction.hpp"
+#include "interaction/PairExtension.hpp"
 
 #include "Extension.hpp"
 #include "VelocityVerlet.hpp"
@@ -40,9 +43,12 @@
 namespace espressopp {
   namespace integrator {
 
-    /** DPD thermostat */
+    /** DPD thermostat. By default, the thermostat loops over the pairs
+        of its Verlet list on its own. After fuseWith(interaction), the
+        pair forces are evaluated in the pair loop of the interaction,
+        which has to use the same Verlet list, as a PairExtension. */
 
-    class DPDThermostat : public Extension {
+    class DPDThermostat : public Extension, public interaction::PairExtension {
 
       public:
 
@@ -59,11 +65,25 @@ namespace espressopp {
         void setTemperature(real temperature);
         real getTemperature();
 
+        /** draw the noise from the counter-based RNG keyed on (step, pair of
+            particle ids), which does not depend on the decomposition */
+        void setCounterRNG(bool _counterRNG);
+        bool getCounterRNG();
+
+        /** evaluate the pair forces in the force loop of interaction */
+        void fuseWith(shared_ptr< interaction::Interaction > interaction);
+
         void initialize();
 
         /** update of forces to thermalize the system */
         void thermalize();
 
+        /** PairExtension interface, used after fuseWith() */
+        void beginPairs();
+        void addPairForce(Real3D& force, const Particle &p1,
+                          const Particle &p2, const Real3D& dist);
+        bool isThreadSafe() const { return counterRNG; }
+
         /** very nasty: if we recalculate force when leaving/reentering the integrator,
             a(t) and a((t-dt)+dt) are NOT equal in the vv algorithm. The random
             numbers are drawn twice, resulting in a different variance of the random force.
@@ -85,6 +105,7 @@ namespace espressopp {
                                        _thermalize;
 
         void frictionThermoDPD(Particle& p1, Particle& p2);
+        void addForceDPD(Real3D& f, const Particle& p1, const Particle& p2, const Real3D& r);
 		void frictionThermoTDPD(Particle& p1, Particle& p2);
 
         void connect();
@@ -101,6 +122,15 @@ namespace espressopp {
         shared_ptr<VerletList> verletList;
         shared_ptr< esutil::RNG > rng;  //!< random number generator used for friction term
 
+        bool counterRNG;       //!< use rng->counter() instead of the stateful rng
+        bool recalc;           //!< between heatUp and coolDown
+        long long noiseStep;   //!< step the current forces belong to, key of the counter-based noise
+
+        shared_ptr< interaction::Interaction > fusedInteraction;  //!< evaluates the pairs, if any
+
+        /** counter-based generator of the pair, the same for (p1, p2) and (p2, p1) */
+        esutil::CounterRNG pairRNG(unsigned int stream, const Particle& p1, const Particle& p2);
+
     };
   }
 }
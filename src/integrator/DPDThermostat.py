@@ -31,6 +31,15 @@ r"""
 		:param vl: 
 		:type system: 
 		:type vl: 
+
+.. function:: espressopp.integrator.DPDThermostat.fuseWith(interaction)
+
+		Evaluate the DPD pair forces in the force loop of interaction,
+		a Verlet list interaction on the same Verlet list, instead of
+		looping over the pairs a second time.
+
+		:param interaction: 
+		:type interaction: 
 """
 from espressopp.esutil import cxxinit
 from espressopp import pmi
@@ -53,5 +62,6 @@ if pmi.isController :
         __metaclass__ = pmi.Proxy
         pmiproxydefs = dict(
             cls =  'espressopp.integrator.DPDThermostatLocal',
-            pmiproperty = [ 'gamma', 'tgamma', 'temperature' ]
+            pmicall = [ 'fuseWith' ],
+            pmiproperty = [ 'gamma', 'tgamma', 'temperature', 'counterRNG' ]
             )
@@ -46,6 +46,10 @@ namespace espressopp {
       
       adress = false;
 
+      counterRNG = false;
+      recalc = false;
+      noiseStep = 0;
+
       if (!system->rng) {
         throw std::runtime_error("system has no RNG");
       }
@@ -75,6 +79,14 @@ namespace espressopp {
         return adress;
     }
 
+    void LangevinThermostat::setCounterRNG(bool _counterRNG){
+        counterRNG = _counterRNG;
+    }
+
+    bool LangevinThermostat::getCounterRNG(){
+        return counterRNG;
+    }
+
     void LangevinThermostat::setTemperature(real _temperature)
     {
       temperature = _temperature;
@@ -129,6 +141,9 @@ namespace espressopp {
 
       System& system = getSystemRef();
       
+      // forces computed inside the step loop belong to the next step
+      noiseStep = integrator->getStep() + (recalc ? 0 : 1);
+
       CellList cells = system.storage->getRealCells();
 
       for(CellListIterator cit(cells); !cit.isDone(); ++cit) {
@@ -143,6 +158,8 @@ namespace espressopp {
 
       System& system = getSystemRef();
 
+      noiseStep = integrator->getStep() + (recalc ? 0 : 1);
+
       // thermalize CG particles
       /*CellList cells = system.storage->getRealCells();
       for(CellListIterator cit(cells); !cit.isDone(); ++cit) {
@@ -177,7 +194,14 @@ namespace espressopp {
 
       // get a random value for each vector component
 
-      Real3D ranval((*rng)() - 0.5, (*rng)() - 0.5, (*rng)() - 0.5);
+      Real3D ranval;
+      if (counterRNG) {
+        real u[3];
+        rng->counter(esutil::CounterRNG::STREAM_LANGEVIN, noiseStep, p.id()).uniform(u, 3);
+        ranval = Real3D(u[0] - 0.5, u[1] - 0.5, u[2] - 0.5);
+      } else {
+        ranval = Real3D((*rng)() - 0.5, (*rng)() - 0.5, (*rng)() - 0.5);
+      }
 
       p.force() += pref1 * p.velocity() * p.mass() +
                    pref2 * ranval * massf;
@@ -211,8 +235,10 @@ namespace espressopp {
     {
       LOG4ESPP_INFO(theLogger, "heatUp");
 
+      recalc = true;
       pref2buffer = pref2;
-      pref2       *= sqrt(3.0);
+      // the counter-based noise of a recalculated force is the one it had before
+      if (!counterRNG) pref2 *= sqrt(3.0);
     }
 
     /** Opposite to heatUp */
@@ -221,6 +247,7 @@ namespace espressopp {
     {
       LOG4ESPP_INFO(theLogger, "coolDown");
 
+      recalc = false;
       pref2 = pref2buffer;
     }
 
@@ -239,6 +266,7 @@ namespace espressopp {
         .def("connect", &LangevinThermostat::connect)
         .def("disconnect", &LangevinThermostat::disconnect)
         .add_property("adress", &LangevinThermostat::getAdress, &LangevinThermostat::setAdress)
+        .add_property("counterRNG", &LangevinThermostat::getCounterRNG, &LangevinThermostat::setCounterRNG)
         .add_property("gamma", &LangevinThermostat::getGamma, &LangevinThermostat::setGamma)
         .add_property("temperature", &LangevinThermostat::getTemperature, &LangevinThermostat::setTemperature)
         ;
@@ -57,6 +57,11 @@ namespace espressopp {
         void setAdress(bool _adress);
         bool getAdress();
 
+        /** draw the noise from the counter-based RNG keyed on (step, particle id),
+            which does not depend on the decomposition */
+        void setCounterRNG(bool _counterRNG);
+        bool getCounterRNG();
+
         void initialize();
 
         /** update of forces to thermalize the system */
@@ -102,6 +107,10 @@ namespace espressopp {
 
         shared_ptr< esutil::RNG > rng;  //!< random number generator used for friction term
 
+        bool counterRNG;       //!< use rng->counter() instead of the stateful rng
+        bool recalc;           //!< between heatUp and coolDown
+        long long noiseStep;   //!< step the current forces belong to, key of the counter-based noise
+
     };
   }
 }
@@ -51,5 +51,5 @@ if pmi.isController :
         __metaclass__ = pmi.Proxy
         pmiproxydefs = dict(
             cls =  'espressopp.integrator.LangevinThermostatLocal',
-            pmiproperty = [ 'gamma', 'temperature', 'adress' ]
+            pmiproperty = [ 'gamma', 'temperature', 'adress', 'counterRNG' ]
             )
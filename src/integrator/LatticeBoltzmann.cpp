@@ -22,12 +22,14 @@
 #include "LatticeBoltzmann.hpp"
 #include <iomanip>
 #include <iostream>
+#include <algorithm>
 #include <fstream>
 
 #include "boost/serialization/vector.hpp"
 #include "types.hpp"
 #include "System.hpp"
 #include "storage/Storage.hpp"
+#include "storage/DomainDecomposition.hpp"
 #include "iterator/CellListIterator.hpp"
 #include "esutil/RNG.hpp"
 #include "esutil/Grid.hpp"
@@ -54,6 +56,16 @@
 #define COMM_DEN_4 716
 #define COMM_DEN_5 717
 
+/* populations leaving a CPU along the velocity directions in the halo exchange
+ (postHalo() and finishHalo()), per dimension the ones moving to the right ([0])
+ and the ones moving to the left ([1]) */
+static const int numPopTransf = 5;
+static const int haloPops[3][2][numPopTransf] = {
+	{{1, 7, 9, 11, 13}, {2, 8, 10, 12, 14}},
+	{{3, 7, 10, 15, 17}, {4, 8, 9, 16, 18}},
+	{{5, 11, 14, 15, 18}, {6, 12, 13, 16, 17}}
+};
+
 using namespace boost;
 
 namespace espressopp {
@@ -115,19 +127,25 @@ namespace espressopp {
 			setHaloSkin(1);
 			findMyNeighbours();
 			
+			/* the lattice of a CPU covers the domain of its particles, which may
+			 have been balanced, and the domain boundaries must not move any more */
+			shared_ptr< storage::DomainDecomposition > _domdec =
+				dynamic_pointer_cast< storage::DomainDecomposition >(_system->storage);
+			if (_domdec) {
+				_domdec->setFixedBoundaries(true);
+				fixedStorage = _domdec;
+			}
+			
 			Int3D _numSites = Int3D(0,0,0);
 			Real3D _myLeft = Real3D(0.,0.,0.);
-			real _L = 0.;
-			
-			longint _myRank = getSystem()->comm->rank();
-			Int3D _myPosition = getMyPosition();
+			storage::Storage& _storage = *_system->storage;
+			real _left[3] = { _storage.getLocalBoxXMin(), _storage.getLocalBoxYMin(), _storage.getLocalBoxZMin() };
+			real _right[3] = { _storage.getLocalBoxXMax(), _storage.getLocalBoxYMax(), _storage.getLocalBoxZMax() };
 
 			for (int _dim = 0; _dim < 3; ++_dim) {
-				_L = getSystem()->bc->getBoxL().getItem(_dim);
-				_numSites[_dim] = floor((_myPosition[_dim]+1)*_L/(_nodeGrid[_dim]*getA())) -
-													floor(_myPosition[_dim]*_L/(_nodeGrid[_dim]*getA())) +
+				_numSites[_dim] = floor(_right[_dim]/getA()) - floor(_left[_dim]/getA()) +
 													2 * getHaloSkin();
-				_myLeft[_dim] = floor(_myPosition[_dim]*_L/_nodeGrid[_dim]);
+				_myLeft[_dim] = floor(_left[_dim]/getA()) * getA();
 			}
 #warning: probably one needs to eliminate Ni as input parameter and calculate it through Li and a
 //			setNi(_L / getA());
@@ -139,24 +157,18 @@ namespace espressopp {
 //			LatticePar::initEqWeights();
 			
 			/* stretch lattices resizing them in 3 dimensions */
-			lbfluid = new lblattice;
-			ghostlat = new lblattice;
+			lbfluid = new lblattice(_numSites, getNumVels());
+			ghostlat = new lblattice(_numSites, getNumVels());
 			lbmom = new lbmoments;
 			lbfor = new lbforces;
 
-			(*lbfluid).resize(_numSites[0]);
-			(*ghostlat).resize(_numSites[0]);
 			(*lbmom).resize(_numSites[0]);
 			(*lbfor).resize(_numSites[0]);
 			
 			for (int i = 0; i < _numSites[0]; i++) {
-				(*lbfluid)[i].resize(_numSites[1]);
-				(*ghostlat)[i].resize(_numSites[1]);
 				(*lbmom)[i].resize(_numSites[1]);
 				(*lbfor)[i].resize(_numSites[1]);
 				for (int j = 0; j < _numSites[1]; j++) {
-					(*lbfluid)[i][j].resize(_numSites[2]);
-					(*ghostlat)[i][j].resize(_numSites[2]);
 					(*lbmom)[i][j].resize(_numSites[2]);
 					(*lbfor)[i][j].resize(_numSites[2]);
 				}
@@ -165,11 +177,28 @@ namespace espressopp {
 			/* initialise global weights and coefficients from the local ones */
 			initLatticeModel();
 
+			/* shifts of the site index along the velocity vectors, used in streaming */
+			streamShift.resize(getNumVels());
+			for (int l = 0; l < getNumVels(); l++) {
+				Real3D _ci = getCi(l);
+				streamShift[l] = lbfluid->offset(int(_ci[0]), int(_ci[1]), int(_ci[2]));
+			}
+
+			/* halo buffers are allocated once, large enough for the biggest plane */
+			longint _maxPlane = std::max(longint(_numSites[1]) * _numSites[2],
+																	 std::max(longint(_numSites[0]) * _numSites[2],
+																						longint(_numSites[0]) * _numSites[1]));
+			for (int _dir = 0; _dir < 2; _dir++) {
+				haloSendBuf[_dir].resize(numPopTransf * _maxPlane);
+				haloRecvBuf[_dir].resize(numPopTransf * _maxPlane);
+			}
+
 			// reset timers
 			colstream.reset();
 			comm.reset();
 			swapping.reset();
 			time_colstr = 0.;
+			num_colstr = 0;
 			time_comm = 0.;
 			time_sw = 0.;
 		}
@@ -315,12 +344,12 @@ namespace espressopp {
 		
 		/* Setter and getter for access to population values */
 		void LatticeBoltzmann::setLBFluid (Int3D _Ni, int _l, real _value) {
-			(*lbfluid)[_Ni.getItem(0)][_Ni.getItem(1)][_Ni.getItem(2)].setF_i(_l, _value);	}
+			lbfluid->setF_i(_Ni.getItem(0),_Ni.getItem(1),_Ni.getItem(2),_l, _value);	}
 		real LatticeBoltzmann::getLBFluid (Int3D _Ni, int _l) {
-			return (*lbfluid)[_Ni.getItem(0)][_Ni.getItem(1)][_Ni.getItem(2)].getF_i(_l);	}
+			return lbfluid->getF_i(_Ni.getItem(0),_Ni.getItem(1),_Ni.getItem(2),_l);	}
 		
 		void LatticeBoltzmann::setGhostFluid (Int3D _Ni, int _l, real _value) {
-			(*ghostlat)[_Ni.getItem(0)][_Ni.getItem(1)][_Ni.getItem(2)].setF_i(_l, _value);	}
+			ghostlat->setF_i(_Ni.getItem(0),_Ni.getItem(1),_Ni.getItem(2),_l, _value);	}
 	
 		void LatticeBoltzmann::setLBMom (Int3D _Ni, int _l, real _value) {
 			(*lbmom)[_Ni.getItem(0)][_Ni.getItem(1)][_Ni.getItem(2)].setMom_i(_l, _value);	}
@@ -399,29 +428,22 @@ namespace espressopp {
       using std::fixed;
       using std::setw;
 
-      // (re)set values of gammas depending on the id of the gamma that was changed
-      for (int i = 0; i < getMyNi().getItem(0); i++) {
-        for (int j = 0; j < getMyNi().getItem(1); j++) {
-          for (int k = 0; k < getMyNi().getItem(2); k++) {
-            for (int l = 0; l < getNumVels(); l++) {		// ich glaube die Schleife ist überflüssig hier
-              if (_idGamma == 0) (*lbfluid)[i][j][k].setGammaBLoc(getGammaB());
-              if (_idGamma == 1) (*lbfluid)[i][j][k].setGammaSLoc(getGammaS());
-              if (_idGamma == 2) (*lbfluid)[i][j][k].setGammaOddLoc(getGammaOdd());
-              if (_idGamma == 3) (*lbfluid)[i][j][k].setGammaEvenLoc(getGammaEven());
-            }
-          }
-        }
-      }
+      // (re)set values of gammas depending on the id of the gamma that was changed.
+      // They are shared by all lattice sites.
+      if (_idGamma == 0) LBSite::setGammaBLoc(getGammaB());
+      if (_idGamma == 1) LBSite::setGammaSLoc(getGammaS());
+      if (_idGamma == 2) LBSite::setGammaOddLoc(getGammaOdd());
+      if (_idGamma == 3) LBSite::setGammaEvenLoc(getGammaEven());
 			
       // print for control
 			longint _myRank = getSystem()->comm->rank();
 			if (_myRank == 0) {
 				std::cout << setprecision(8);
 				std::cout << "One of the gamma's controlling viscosities has been changed:\n";
-				if (_idGamma == 0) std::cout << "  gammaB is " << (*lbfluid)[0][0][0].getGammaBLoc() << "\n";
-				if (_idGamma == 1) std::cout << "  gammaS is " << (*lbfluid)[0][0][0].getGammaSLoc() << "\n";
-				if (_idGamma == 2) std::cout << ", gammaOdd is " << (*lbfluid)[0][0][0].getGammaOddLoc() << "\n";
-				if (_idGamma == 3) std::cout << ", gammaEven is " << (*lbfluid)[0][0][0].getGammaEvenLoc() << "\n";
+				if (_idGamma == 0) std::cout << "  gammaB is " << LBSite::getGammaBLoc() << "\n";
+				if (_idGamma == 1) std::cout << "  gammaS is " << LBSite::getGammaSLoc() << "\n";
+				if (_idGamma == 2) std::cout << ", gammaOdd is " << LBSite::getGammaOddLoc() << "\n";
+				if (_idGamma == 3) std::cout << ", gammaEven is " << LBSite::getGammaEvenLoc() << "\n";
 				std::cout << "-------------------------------------\n";
 			}
     }
@@ -478,14 +500,8 @@ namespace espressopp {
           setPhi(l, sqrt(mu / getInvB(l)));
         }
 
-        for (int i = 0; i < getMyNi().getItem(0); i++) {
-          for (int j = 0; j < getMyNi().getItem(1); j++) {
-            for (int k = 0; k < getMyNi().getItem(2); k++) {
-              for (int l = 0; l < getNumVels(); l++) {
-                (*lbfluid)[i][j][k].setPhiLoc(l,getPhi(l));    // set amplitudes of local fluctuations
-              }
-            }
-          }
+        for (int l = 0; l < getNumVels(); l++) {
+          LBSite::setPhiLoc(l,getPhi(l));    // set amplitudes of local fluctuations
         }
 				
 				if (_myRank == 0) {
@@ -510,13 +526,18 @@ namespace espressopp {
 			}
 			
 			if (_stepNum % _profStep == 0 && _stepNum!=0) {
-				printf ("CPU %d: colstr takes %f sec, comm % f, swapping %f\n",
-								getSystem()->comm->rank(), time_colstr, time_comm, time_sw);
+				Int3D _myNi = getMyNi();
+				int _offset = getHaloSkin();
+				real _numSites = real(_myNi[0] - 2*_offset) * (_myNi[1] - 2*_offset) * (_myNi[2] - 2*_offset);
+				real _mlups = (time_colstr > 0.) ? 1e-6 * _numSites * num_colstr / time_colstr : 0.;
+				printf ("CPU %d: colstr takes %f sec (%.2f MLUPS), comm % f, swapping %f\n",
+								getSystem()->comm->rank(), time_colstr, _mlups, time_comm, time_sw);
 
 				colstream.reset();
 				comm.reset();
 				swapping.reset();
 				time_colstr = 0.;
+				num_colstr = 0;
 				time_comm = 0.;
 				time_sw = 0.;
 			}
@@ -657,9 +678,6 @@ namespace espressopp {
 		/* COLLIDE-STREAM STEP */
     void LatticeBoltzmann::collideStream () {
 			int _offset = getHaloSkin();
-			int _extForceFlag = getExtForceFlag();
-			int _couplForceFlag = getCouplForceFlag();
-			int _lbTempFlag = getLBTempFlag();
 			Int3D _myNi = getMyNi();
 			
 			/* copy forces from halo region to the real one */
@@ -667,24 +685,54 @@ namespace espressopp {
 				copyForcesFromHalo();
 			}
 			
-			/* collision-streaming */
+			/* collision-streaming in one pass over the flat lattice, overlapped with
+			 the halo communication. The boundary shell of the real region goes first
+			 since it produces everything the halo exchange sends. The interior is
+			 done in three slabs along x, each while the exchange of one direction
+			 is in flight. The directions stay ordered x, y, z as the later ones
+			 carry on the corner populations received by the earlier ones. The
+			 interior never writes the populations the unpacking fills in. */
 			real time1 = colstream.getElapsedTime();
-			for (int i = _offset; i < _myNi[0]-_offset; i++) {
-        for (int j = _offset; j < _myNi[1]-_offset; j++) {
-          for (int k = _offset; k < _myNi[2]-_offset; k++) {
-						Real3D _f = (*lbfor)[i][j][k].getExtForceLoc() + (*lbfor)[i][j][k].getCouplForceLoc();
-						(*lbfluid)[i][j][k].collision(_lbTempFlag, _extForceFlag, _couplForceFlag, _f);
-
-						streaming (i,j,k);
-					}
-        }
-      }
-			time_colstr += (colstream.getElapsedTime()-time1);
-	
-			/* halo communication */
+			real _commTime = 0.;
+			Int3D _lo(_offset), _hi;
+			Int3D _inLo(_offset + 1), _inHi;
+			for (int _dim = 0; _dim < 3; _dim++) {
+				_hi[_dim] = _myNi[_dim] - _offset;
+				_inHi[_dim] = std::max(_inLo[_dim], _hi[_dim] - 1);
+			}
+			
+			for (int _dim = 0; _dim < 3; _dim++) {
+				Int3D _faceLo = _lo, _faceHi = _hi;
+				for (int _prev = 0; _prev < _dim; _prev++) {
+					_faceLo[_prev] = _inLo[_prev];
+					_faceHi[_prev] = _inHi[_prev];
+				}
+				_faceHi[_dim] = std::min(_lo[_dim] + 1, _hi[_dim]);
+				collideStreamBox(_faceLo, _faceHi);
+				_faceLo[_dim] = std::max(_lo[_dim] + 1, _hi[_dim] - 1);
+				_faceHi[_dim] = _hi[_dim];
+				collideStreamBox(_faceLo, _faceHi);
+			}
+			
+			for (int _dim = 0; _dim < 3; _dim++) {
+				real time2 = comm.getElapsedTime();
+				if (_dim > 0) finishHalo(_dim - 1);
+				postHalo(_dim);
+				_commTime += comm.getElapsedTime() - time2;
+				
+				Int3D _slabLo = _inLo, _slabHi = _inHi;
+				_slabLo[0] = _inLo[0] + (_inHi[0] - _inLo[0]) * _dim / 3;
+				_slabHi[0] = _inLo[0] + (_inHi[0] - _inLo[0]) * (_dim + 1) / 3;
+				collideStreamBox(_slabLo, _slabHi);
+			}
+			
 			real time2 = comm.getElapsedTime();
-			commHalo();
-			time_comm += (comm.getElapsedTime()-time2);
+			finishHalo(2);
+			_commTime += comm.getElapsedTime() - time2;
+			
+			time_colstr += (colstream.getElapsedTime() - time1 - _commTime);
+			time_comm += _commTime;
+			++num_colstr;
 			
 			/* swapping of the pointers to the lattices */
 			real time3 = swapping.getElapsedTime();
@@ -715,41 +763,48 @@ namespace espressopp {
     }
 		
 /*******************************************************************************************/
-		
-    /* STREAMING ALONG THE VELOCITY VECTORS. SERIAL */
-    void LatticeBoltzmann::streaming(int _i, int _j, int _k) {
-      // periodic boundaries are handled separately in commHalo() //
-			
-      // assign iterations
-      int _ip = _i + 1; int _im = _i - 1;
-      int _jp = _j + 1; int _jm = _j - 1;
-      int _kp = _k + 1; int _km = _k - 1;
-
-      // do not move the staying populations
-      (*ghostlat)[_i][_j][_k].setF_i(0,(*lbfluid)[_i][_j][_k].getF_i(0));
-
-      // move populations to the nearest neighbors
-      (*ghostlat)[_ip][_j][_k].setF_i(1,(*lbfluid)[_i][_j][_k].getF_i(1));
-      (*ghostlat)[_im][_j][_k].setF_i(2,(*lbfluid)[_i][_j][_k].getF_i(2));
-      (*ghostlat)[_i][_jp][_k].setF_i(3,(*lbfluid)[_i][_j][_k].getF_i(3));
-      (*ghostlat)[_i][_jm][_k].setF_i(4,(*lbfluid)[_i][_j][_k].getF_i(4));
-      (*ghostlat)[_i][_j][_kp].setF_i(5,(*lbfluid)[_i][_j][_k].getF_i(5));
-      (*ghostlat)[_i][_j][_km].setF_i(6,(*lbfluid)[_i][_j][_k].getF_i(6));
-
-      // move populations to the next-to-the-nearest neighbors
-      (*ghostlat)[_ip][_jp][_k].setF_i(7,(*lbfluid)[_i][_j][_k].getF_i(7));
-      (*ghostlat)[_im][_jm][_k].setF_i(8,(*lbfluid)[_i][_j][_k].getF_i(8));
-      (*ghostlat)[_ip][_jm][_k].setF_i(9,(*lbfluid)[_i][_j][_k].getF_i(9));
-      (*ghostlat)[_im][_jp][_k].setF_i(10,(*lbfluid)[_i][_j][_k].getF_i(10));
-      (*ghostlat)[_ip][_j][_kp].setF_i(11,(*lbfluid)[_i][_j][_k].getF_i(11));
-      (*ghostlat)[_im][_j][_km].setF_i(12,(*lbfluid)[_i][_j][_k].getF_i(12));
-      (*ghostlat)[_ip][_j][_km].setF_i(13,(*lbfluid)[_i][_j][_k].getF_i(13));
-      (*ghostlat)[_im][_j][_kp].setF_i(14,(*lbfluid)[_i][_j][_k].getF_i(14));
-      (*ghostlat)[_i][_jp][_kp].setF_i(15,(*lbfluid)[_i][_j][_k].getF_i(15));
-      (*ghostlat)[_i][_jm][_km].setF_i(16,(*lbfluid)[_i][_j][_k].getF_i(16));
-      (*ghostlat)[_i][_jp][_km].setF_i(17,(*lbfluid)[_i][_j][_k].getF_i(17));
-      (*ghostlat)[_i][_jm][_kp].setF_i(18,(*lbfluid)[_i][_j][_k].getF_i(18));
-    }
+
+		/* COLLIDE AND STREAM THE REAL SITES IN [_lo, _hi). The populations of a row
+		 along z are processed in blocks of consecutive sites by LBSite::collideStreamBlock() */
+		template < bool _fluct, bool _extForce, bool _force >
+		void LatticeBoltzmann::collideStreamRows (const Int3D& _lo, const Int3D& _hi) {
+			int _kEnd = _hi[2];
+
+			LBSite _site;
+			Real3D _f[LBSite::blockSize];
+			for (int i = _lo[0]; i < _hi[0]; i++) {
+				for (int j = _lo[1]; j < _hi[1]; j++) {
+					std::vector<LBForce>& _forRow = (*lbfor)[i][j];
+					longint _index = lbfluid->index(i, j, _lo[2]);
+					for (int k = _lo[2]; k < _kEnd; k += LBSite::blockSize) {
+						int _n = std::min(int(LBSite::blockSize), _kEnd - k);
+						if (_force) {
+							for (int s = 0; s < _n; s++) {
+								_f[s] = _forRow[k+s].getExtForceLoc() + _forRow[k+s].getCouplForceLoc();
+							}
+						}
+						_site.collideStreamBlock<_fluct, _extForce, _force>(*lbfluid, *ghostlat,
+																																 _index, _n, _f, &streamShift[0]);
+						_index += _n;
+					}
+				}
+			}
+		}
+
+		/* dispatch to the collideStreamRows specialised on the current flags */
+		void LatticeBoltzmann::collideStreamBox (const Int3D& _lo, const Int3D& _hi) {
+			if (_lo[0] >= _hi[0] || _lo[1] >= _hi[1] || _lo[2] >= _hi[2]) return;
+			
+			if (getLBTempFlag() == 1) {
+				if (getExtForceFlag() == 1) collideStreamRows<true, true, true>(_lo, _hi);
+				else if (getCouplForceFlag() == 1) collideStreamRows<true, false, true>(_lo, _hi);
+				else collideStreamRows<true, false, false>(_lo, _hi);
+			} else {
+				if (getExtForceFlag() == 1) collideStreamRows<false, true, true>(_lo, _hi);
+				else if (getCouplForceFlag() == 1) collideStreamRows<false, false, true>(_lo, _hi);
+				else collideStreamRows<false, false, false>(_lo, _hi);
+			}
+		}
 
 /*******************************************************************************************/
 		
@@ -903,8 +958,8 @@ namespace espressopp {
 						real denLoc = 0.;
 						Real3D jLoc = Real3D(0.);
 						for (int l = 0; l < _numVels; l++) {
-							denLoc += (*lbfluid)[i][j][k].getF_i(l);
-							jLoc += (*lbfluid)[i][j][k].getF_i(l)*getCi(l);
+							denLoc += lbfluid->getF_i(i,j,k,l);
+							jLoc += lbfluid->getF_i(i,j,k,l)*getCi(l);
 						}
 						(*lbmom)[i][j][k].setMom_i(0,denLoc);
 						(*lbmom)[i][j][k].setMom_i(1,jLoc[0]);
@@ -1114,315 +1169,83 @@ namespace espressopp {
 		
 /*******************************************************************************************/
 		
-		/* COMMUNICATE POPULATIONS IN HALO REGIONS TO THE NEIGHBOURING CPUs */
-		void LatticeBoltzmann::commHalo() {
-			int i, j, k, index;											// running indices and index of the node to be copied
-			static int numPopTransf = 5;						// number of populations and hydrod. moments to transfer
-			int rnode, snode;												// rank of the node to receive from and to send to
-			std::vector<real> bufToSend, bufToRecv;	// buffers used to send and to receive the data
-			
+		/* PACK THE HALO PLANES ALONG _dim AND POST THEIR NONBLOCKING TRANSFER.
+		 The populations streamed into the right halo go to the right neighbour,
+		 the ones in the left halo to the left neighbour */
+		void LatticeBoltzmann::postHalo(int _dim) {
 			int _offset = getHaloSkin();
 			Int3D _myNi = getMyNi();
-			Int3D _myPosition = getMyPosition();
-			
-			mpi::environment env;
-			mpi::communicator world;
-			
-			//////////////////////
-			//// X-direction /////
-			//////////////////////
-			// number of reals to transfer
-			int numDataTransf = numPopTransf * _myNi[1] * _myNi[2];
-
-			bufToSend.resize(numDataTransf);				// resize bufToSend
-			bufToRecv.resize(numDataTransf);				// resize bufToRecv
-			
-			/* send to right, recv from left i = 1, 7, 9, 11, 13 */
-			snode = getMyNeighbour(1);
-			rnode = getMyNeighbour(0);
+			int _planeSize = _myNi[(_dim + 1) % 3] * _myNi[(_dim + 2) % 3];
+			int numDataTransf = numPopTransf * _planeSize;
 			
-			// prepare message for sending
-			i = _myNi[0] - _offset;
-			index = 0;
-			for (k=0; k<_myNi[2]; k++) {
-				for (j=0; j<_myNi[1]; j++) {
-					bufToSend[index] = (*ghostlat)[i][j][k].getF_i(1);
-					bufToSend[index+1] = (*ghostlat)[i][j][k].getF_i(7);
-					bufToSend[index+2] = (*ghostlat)[i][j][k].getF_i(9);
-					bufToSend[index+3] = (*ghostlat)[i][j][k].getF_i(11);
-					bufToSend[index+4] = (*ghostlat)[i][j][k].getF_i(13);
-					index += numPopTransf;
-				}
-			}
-			
-			// send and receive data or use memcpy if number of CPU in x-dir is 1
-			if (getNodeGrid().getItem(0) > 1) {
-				if (_myPosition[0] % 2 == 0) {
-					world.send(snode, COMM_DIR_0, bufToSend);
-					world.recv(rnode, COMM_DIR_0, bufToRecv);
-				} else {
-					world.recv(rnode, COMM_DIR_0, bufToRecv);
-					world.send(snode, COMM_DIR_0, bufToSend);
-				}
-			} else {
-				bufToRecv = bufToSend;
-			}
-			
-			// unpack message
-			i = _offset;
-			index = 0;
-			for (k=0; k<_myNi[2]; k++) {
-				for (j=0; j<_myNi[1]; j++) {
-					(*ghostlat)[i][j][k].setF_i(1, bufToRecv[index]);
-					(*ghostlat)[i][j][k].setF_i(7, bufToRecv[index+1]);
-					(*ghostlat)[i][j][k].setF_i(9, bufToRecv[index+2]);
-					(*ghostlat)[i][j][k].setF_i(11, bufToRecv[index+3]);
-					(*ghostlat)[i][j][k].setF_i(13, bufToRecv[index+4]);
-					index += numPopTransf;
-				}
-			}
-			
-			/* send to left, recv from right i = 2, 8, 10, 12, 14 */
-			snode = getMyNeighbour(0);
-			rnode = getMyNeighbour(1);
-			
-			// prepare message for sending
-			i = 0;
-			index = 0;
-			for (k=0; k<_myNi[2]; k++) {
-				for (j=0; j<_myNi[1]; j++) {
-					bufToSend[index] = (*ghostlat)[i][j][k].getF_i(2);
-					bufToSend[index+1] = (*ghostlat)[i][j][k].getF_i(8);
-					bufToSend[index+2] = (*ghostlat)[i][j][k].getF_i(10);
-					bufToSend[index+3] = (*ghostlat)[i][j][k].getF_i(12);
-					bufToSend[index+4] = (*ghostlat)[i][j][k].getF_i(14);
-					index += numPopTransf;
-				}
-			}
-			
-			// send and receive data or use memcpy if number of CPU in x-dir is 1
-			if (getNodeGrid().getItem(0) > 1) {
-				if (_myPosition[0] % 2 == 0) {
-					world.send(snode, COMM_DIR_1, bufToSend);
-					world.recv(rnode, COMM_DIR_1, bufToRecv);
-				} else {
-					world.recv(rnode, COMM_DIR_1, bufToRecv);
-					world.send(snode, COMM_DIR_1, bufToSend);
-				}
-			} else {
-				bufToRecv = bufToSend;
-			}
-			
-			// unpack message
-			i = _myNi[0] - 2 * _offset;
-			index = 0;
-			for (k=0; k<_myNi[2]; k++) {
-				for (j=0; j<_myNi[1]; j++) {
-					(*ghostlat)[i][j][k].setF_i(2, bufToRecv[index]);
-					(*ghostlat)[i][j][k].setF_i(8, bufToRecv[index+1]);
-					(*ghostlat)[i][j][k].setF_i(10, bufToRecv[index+2]);
-					(*ghostlat)[i][j][k].setF_i(12, bufToRecv[index+3]);
-					(*ghostlat)[i][j][k].setF_i(14, bufToRecv[index+4]);
-					index += numPopTransf;
-				}
-			}
-			
-			//////////////////////
-			//// Y-direction /////
-			//////////////////////
-			numDataTransf = numPopTransf * _myNi[0] * _myNi[2];
-			bufToSend.resize(numDataTransf);				// resize bufToSend
-			bufToRecv.resize(numDataTransf);				// resize bufToRecv
-			
-			/* send to right, recv from left i = 3, 7, 10, 15, 17 */
-			snode = getMyNeighbour(3);
-			rnode = getMyNeighbour(2);
+			packHaloPlane(_dim, _myNi[_dim] - _offset, haloPops[_dim][0], &haloSendBuf[0][0]);
+			packHaloPlane(_dim, 0, haloPops[_dim][1], &haloSendBuf[1][0]);
 			
-			// prepare message for sending
-			j = _myNi[1] - _offset;
-			index = 0;
-			for (k=0; k<_myNi[2]; k++) {
-				for (i=0; i<_myNi[0]; i++) {
-					bufToSend[index] = (*ghostlat)[i][j][k].getF_i(3);
-					bufToSend[index+1] = (*ghostlat)[i][j][k].getF_i(7);
-					bufToSend[index+2] = (*ghostlat)[i][j][k].getF_i(10);
-					bufToSend[index+3] = (*ghostlat)[i][j][k].getF_i(15);
-					bufToSend[index+4] = (*ghostlat)[i][j][k].getF_i(17);
-					index += numPopTransf;
-				}
-			}
-			
-			// send and receive data or use memcpy if number of CPU in y-dir is 1
-			if (getNodeGrid().getItem(1) > 1) {
-				if (_myPosition[1] % 2 == 0) {
-					world.send(snode, COMM_DIR_2, bufToSend);
-					world.recv(rnode, COMM_DIR_2, bufToRecv);
-				} else {
-					world.recv(rnode, COMM_DIR_2, bufToRecv);
-					world.send(snode, COMM_DIR_2, bufToSend);
-				}
-			} else {
-				bufToRecv = bufToSend;
-			}
-			
-			// unpack message
-			j = _offset;
-			index = 0;
-			for (k=0; k<_myNi[2]; k++) {
-				for (i=0; i<_myNi[0]; i++) {
-					(*ghostlat)[i][j][k].setF_i(3, bufToRecv[index]);
-					(*ghostlat)[i][j][k].setF_i(7, bufToRecv[index+1]);
-					(*ghostlat)[i][j][k].setF_i(10, bufToRecv[index+2]);
-					(*ghostlat)[i][j][k].setF_i(15, bufToRecv[index+3]);
-					(*ghostlat)[i][j][k].setF_i(17, bufToRecv[index+4]);
-					index += numPopTransf;
-				}
-			}
-			
-			/* send to left, recv from right i = 4, 8, 9, 16, 18 */
-			snode = getMyNeighbour(2);
-			rnode = getMyNeighbour(3);
-			
-			// prepare message for sending
-			j = 0;
-			index = 0;
-			for (k=0; k<_myNi[2]; k++) {
-				for (i=0; i<_myNi[0]; i++) {
-					bufToSend[index] = (*ghostlat)[i][j][k].getF_i(4);
-					bufToSend[index+1] = (*ghostlat)[i][j][k].getF_i(8);
-					bufToSend[index+2] = (*ghostlat)[i][j][k].getF_i(9);
-					bufToSend[index+3] = (*ghostlat)[i][j][k].getF_i(16);
-					bufToSend[index+4] = (*ghostlat)[i][j][k].getF_i(18);
-					index += numPopTransf;
-				}
-			}
-			
-			// send and receive data or use memcpy if number of CPU in y-dir is 1
-			if (getNodeGrid().getItem(1) > 1) {
-				if (_myPosition[1] % 2 == 0) {
-					world.send(snode, COMM_DIR_3, bufToSend);
-					world.recv(rnode, COMM_DIR_3, bufToRecv);
-				} else {
-					world.recv(rnode, COMM_DIR_3, bufToRecv);
-					world.send(snode, COMM_DIR_3, bufToSend);
-				}
-			} else {
-				bufToRecv = bufToSend;
-			}
-			
-			// unpack message
-			j = _myNi[1] - 2 * _offset;
-			index = 0;
-			for (k=0; k<_myNi[2]; k++) {
-				for (i=0; i<_myNi[0]; i++) {
-					(*ghostlat)[i][j][k].setF_i(4, bufToRecv[index]);
-					(*ghostlat)[i][j][k].setF_i(8, bufToRecv[index+1]);
-					(*ghostlat)[i][j][k].setF_i(9, bufToRecv[index+2]);
-					(*ghostlat)[i][j][k].setF_i(16, bufToRecv[index+3]);
-					(*ghostlat)[i][j][k].setF_i(18, bufToRecv[index+4]);
-					index += numPopTransf;
-				}
-			}
-			
-			//////////////////////
-			//// Z-direction /////
-			//////////////////////
-			numDataTransf = numPopTransf * _myNi[0] * _myNi[1];
-			bufToSend.resize(numDataTransf);				// resize bufToSend
-			bufToRecv.resize(numDataTransf);				// resize bufToRecv
-			
-			/* send to right, recv from left i = 5, 11, 14, 15, 18 */
-			snode = getMyNeighbour(5);
-			rnode = getMyNeighbour(4);
-			
-			// prepare message for sending
-			k = _myNi[2] - _offset;
-			index = 0;
-			for (j=0; j<_myNi[1]; j++) {
-				for (i=0; i<_myNi[0]; i++) {
-					bufToSend[index] = (*ghostlat)[i][j][k].getF_i(5);
-					bufToSend[index+1] = (*ghostlat)[i][j][k].getF_i(11);
-					bufToSend[index+2] = (*ghostlat)[i][j][k].getF_i(14);
-					bufToSend[index+3] = (*ghostlat)[i][j][k].getF_i(15);
-					bufToSend[index+4] = (*ghostlat)[i][j][k].getF_i(18);
-					index += numPopTransf;
-				}
+			// with one CPU along _dim the buffers are swapped in finishHalo()
+			if (getNodeGrid().getItem(_dim) > 1) {
+				const mpi::communicator& _comm = *getSystem()->comm;
+				int _left = getMyNeighbour(2 * _dim);
+				int _right = getMyNeighbour(2 * _dim + 1);
+				
+				haloRequests[0] = _comm.irecv(_left, COMM_DIR_0 + 2 * _dim, &haloRecvBuf[0][0], numDataTransf);
+				haloRequests[1] = _comm.irecv(_right, COMM_DIR_1 + 2 * _dim, &haloRecvBuf[1][0], numDataTransf);
+				haloRequests[2] = _comm.isend(_right, COMM_DIR_0 + 2 * _dim, &haloSendBuf[0][0], numDataTransf);
+				haloRequests[3] = _comm.isend(_left, COMM_DIR_1 + 2 * _dim, &haloSendBuf[1][0], numDataTransf);
 			}
+		}
+		
+		/* COMPLETE THE HALO TRANSFER ALONG _dim AND ADD IT TO THE REAL PLANES */
+		void LatticeBoltzmann::finishHalo(int _dim) {
+			int _offset = getHaloSkin();
+			Int3D _myNi = getMyNi();
 			
-			// send and receive data or use memcpy if number of CPU in z-dir is 1
-			if (getNodeGrid().getItem(2) > 1) {
-				if (_myPosition[2] % 2 == 0) {
-					world.send(snode, COMM_DIR_4, bufToSend);
-					world.recv(rnode, COMM_DIR_4, bufToRecv);
-				} else {
-					world.recv(rnode, COMM_DIR_4, bufToRecv);
-					world.send(snode, COMM_DIR_4, bufToSend);
-				}
+			if (getNodeGrid().getItem(_dim) > 1) {
+				mpi::wait_all(haloRequests, haloRequests + 4);
 			} else {
-				bufToRecv = bufToSend;
+				haloSendBuf[0].swap(haloRecvBuf[0]);
+				haloSendBuf[1].swap(haloRecvBuf[1]);
 			}
 			
-			// unpack message
-			k = _offset;
-			index = 0;
-			for (j=0; j<_myNi[1]; j++) {
-				for (i=0; i<_myNi[0]; i++) {
-					(*ghostlat)[i][j][k].setF_i(5, bufToRecv[index]);
-					(*ghostlat)[i][j][k].setF_i(11, bufToRecv[index+1]);
-					(*ghostlat)[i][j][k].setF_i(14, bufToRecv[index+2]);
-					(*ghostlat)[i][j][k].setF_i(15, bufToRecv[index+3]);
-					(*ghostlat)[i][j][k].setF_i(18, bufToRecv[index+4]);
-					index += numPopTransf;
-				}
-			}
+			unpackHaloPlane(_dim, _offset, haloPops[_dim][0], &haloRecvBuf[0][0]);
+			unpackHaloPlane(_dim, _myNi[_dim] - 2 * _offset, haloPops[_dim][1], &haloRecvBuf[1][0]);
+		}
+		
+		/* COPY THE POPULATIONS _pops OF THE PLANE _plane NORMAL TO _dim TO _buf */
+		void LatticeBoltzmann::packHaloPlane(int _dim, int _plane, const int *_pops, real *_buf) {
+			Int3D _myNi = getMyNi();
+			int _a = (_dim == 0) ? 1 : 0;
+			int _b = (_dim == 2) ? 1 : 2;
+			int _pos[3];
+			_pos[_dim] = _plane;
 			
-			/* send to left, recv from right i = 6, 12, 13, 16, 17 */
-			snode = getMyNeighbour(4);
-			rnode = getMyNeighbour(5);
+			const real *_f[numPopTransf];
+			for (int n = 0; n < numPopTransf; n++) _f[n] = ghostlat->pop(_pops[n]);
 			
-			// prepare message for sending
-			k = 0;
-			index = 0;
-			for (j=0; j<_myNi[1]; j++) {
-				for (i=0; i<_myNi[0]; i++) {
-					bufToSend[index] = (*ghostlat)[i][j][k].getF_i(6);
-					bufToSend[index+1] = (*ghostlat)[i][j][k].getF_i(12);
-					bufToSend[index+2] = (*ghostlat)[i][j][k].getF_i(13);
-					bufToSend[index+3] = (*ghostlat)[i][j][k].getF_i(16);
-					bufToSend[index+4] = (*ghostlat)[i][j][k].getF_i(17);
-					index += numPopTransf;
+			for (_pos[_a] = 0; _pos[_a] < _myNi[_a]; _pos[_a]++) {
+				for (_pos[_b] = 0; _pos[_b] < _myNi[_b]; _pos[_b]++) {
+					longint _index = ghostlat->index(_pos[0], _pos[1], _pos[2]);
+					for (int n = 0; n < numPopTransf; n++) *_buf++ = _f[n][_index];
 				}
 			}
+		}
+		
+		/* COPY _buf TO THE POPULATIONS _pops OF THE PLANE _plane NORMAL TO _dim */
+		void LatticeBoltzmann::unpackHaloPlane(int _dim, int _plane, const int *_pops, const real *_buf) {
+			Int3D _myNi = getMyNi();
+			int _a = (_dim == 0) ? 1 : 0;
+			int _b = (_dim == 2) ? 1 : 2;
+			int _pos[3];
+			_pos[_dim] = _plane;
 			
-			// send and receive data or use memcpy if number of CPU in z-dir is 1
-			if (getNodeGrid().getItem(2) > 1) {
-				if (_myPosition[2] % 2 == 0) {
-					world.send(snode, COMM_DIR_5, bufToSend);
-					world.recv(rnode, COMM_DIR_5, bufToRecv);
-				} else {
-					world.recv(rnode, COMM_DIR_5, bufToRecv);
-					world.send(snode, COMM_DIR_5, bufToSend);
-				}
-			} else {
-				bufToRecv = bufToSend;
-			}
+			real *_f[numPopTransf];
+			for (int n = 0; n < numPopTransf; n++) _f[n] = ghostlat->pop(_pops[n]);
 			
-			// unpack message
-			k = _myNi[2] - 2 * _offset;
-			index = 0;
-			for (j=0; j<_myNi[1]; j++) {
-				for (i=0; i<_myNi[0]; i++) {
-					(*ghostlat)[i][j][k].setF_i(6, bufToRecv[index]);
-					(*ghostlat)[i][j][k].setF_i(12, bufToRecv[index+1]);
-					(*ghostlat)[i][j][k].setF_i(13, bufToRecv[index+2]);
-					(*ghostlat)[i][j][k].setF_i(16, bufToRecv[index+3]);
-					(*ghostlat)[i][j][k].setF_i(17, bufToRecv[index+4]);
-					index += numPopTransf;
+			for (_pos[_a] = 0; _pos[_a] < _myNi[_a]; _pos[_a]++) {
+				for (_pos[_b] = 0; _pos[_b] < _myNi[_b]; _pos[_b]++) {
+					longint _index = ghostlat->index(_pos[0], _pos[1], _pos[2]);
+					for (int n = 0; n < numPopTransf; n++) _f[n][_index] = *_buf++;
 				}
 			}
-			
-			bufToSend.resize(0);
-			bufToRecv.resize(0);
 		}
 		
 /*******************************************************************************************/
@@ -1984,6 +1807,9 @@ namespace espressopp {
     /* Destructor of the LB */
     LatticeBoltzmann::~LatticeBoltzmann() {
 			disconnect();
+			if (shared_ptr< storage::DomainDecomposition > _domdec = fixedStorage.lock()) {
+				_domdec->setFixedBoundaries(false);
+			}
     }
 		
 /*******************************************************************************************/
@@ -30,13 +30,17 @@
 #include "esutil/Timer.hpp"
 #include "Real3D.hpp"
 #include "Int3D.hpp"
+#include "mpi.hpp"
 #include "LatticeSite.hpp"
 
-typedef std::vector< std::vector< std::vector<espressopp::integrator::LBSite> > > lblattice;
+typedef espressopp::integrator::LBLattice lblattice;
 typedef std::vector< std::vector< std::vector<espressopp::integrator::LBMom> > > lbmoments;
 typedef std::vector< std::vector< std::vector<espressopp::integrator::LBForce> > > lbforces;
 
 namespace espressopp {
+	namespace storage {
+		class DomainDecomposition;
+	}
 	namespace integrator {
 		class LatticeBoltzmann : public Extension {
       /* LatticeBoltzmann constructor expects 5 parameters (and a system pointer).
@@ -190,11 +194,16 @@ namespace espressopp {
 			
 			void collideStream ();									// use collide-stream scheme
 
-			void streaming (int _i, int _j, int _k); // streaming along the velocity vectors
+			template < bool _fluct, bool _extForce, bool _force >
+			void collideStreamRows (const Int3D& _lo, const Int3D& _hi);	// fused collide-stream over a box of real sites
+			void collideStreamBox (const Int3D& _lo, const Int3D& _hi);		// collideStreamRows specialised on the flags
 
 			/* MPI FUNCTIONS */
 			void findMyNeighbours ();
-			void commHalo ();							// communicate populations in halo regions to the neighbouring CPUs
+			void postHalo (int _dim);			// pack the halo planes along _dim and post their nonblocking transfer
+			void finishHalo (int _dim);		// complete the transfer along _dim and unpack it to the real planes
+			void packHaloPlane (int _dim, int _plane, const int *_pops, real *_buf);
+			void unpackHaloPlane (int _dim, int _plane, const int *_pops, const real *_buf);
 			void copyForcesFromHalo ();		// copy coupling forces from halo regions to the real lattice sites
 			void copyDenMomToHalo ();			// copy den and j from real lattice sites to halo
 			void makeDecompose ();				// decompose storage to put escaped real particles into neighbouring CPU
@@ -260,6 +269,7 @@ namespace espressopp {
 			lblattice *ghostlat;
 			lbmoments *lbmom;
 			lbforces *lbfor;
+			std::vector<longint> streamShift;			// shifts of the site index along c_i's
 			
 			// COUPLING
 			int couplForceFlag;						// flag for a coupling force
@@ -275,6 +285,10 @@ namespace espressopp {
 			Int3D myNi;
 			Int3D nodeGrid;								// 3D-array of processors
 			Real3D myLeft;								// left border of a physical ("real") domain for a CPU
+			weak_ptr< storage::DomainDecomposition > fixedStorage;	// storage whose node boundaries the lattice follows
+			std::vector<real> haloSendBuf[2];	// persistent halo buffers, [0] to the right, [1] to the left
+			std::vector<real> haloRecvBuf[2];	// persistent halo buffers, [0] from the left, [1] from the right
+			mpi::request haloRequests[4];	// pending halo transfers of one direction
 			
 			// SIGNALS
 			boost::signals2::connection _befIntV;
@@ -284,6 +298,7 @@ namespace espressopp {
 			esutil::WallTimer swapping, colstream, comm;
 			esutil::WallTimer timeRead, timeSave;
 			real time_sw, time_colstr, time_comm;
+			int num_colstr;												// number of collide-stream steps timed
 			int profStep;									// profiling interval
 			
 			void connect();
@@ -24,17 +24,22 @@
 #ifndef _INTEGRATOR_LATTICEMODEL_HPP
 #define _INTEGRATOR_LATTICEMODEL_HPP
 
+#include <vector>
+#include "types.hpp"
 #include "Real3D.hpp"
+#include "Int3D.hpp"
 
 namespace espressopp {
   namespace integrator {
+		class LBLattice;
+
 		class LBSite {
 			/**
 			 * \brief Description of the properties of the LBSite class
 			 *
-			 * This is a LBSite class for storing of the populations, ext and coupling forces on the lattice site. Through its methods this class handles everything that happens on the node during collision. It also sets the values to the D3Q19 model-related parameters on EVERY lattice site.
+			 * This is a LBSite class handling everything that happens on the nodes during collision. The D3Q19 model-related parameters are static and shared by all sites.
 			 *
-			 * The normal lattice and its ghost counterpart are based on this LBSite class. They are defined in LatticeBoltzmann.*pp files.
+			 * The populations of the lattice itself are stored in LBLattice. The collision loop collides blocks of its sites and streams them back to the lattice, see collideStreamBlock().
 			 *
 			 * Please note that by default ESPResSo++ supports only D3Q19 lattice model.
 			 * However, you can code other lattice models, it should not be difficult.
@@ -44,40 +49,33 @@ namespace espressopp {
 			~LBSite ();
 
 			/* SET AND GET DECLARATION */
-			void setF_i (int _i, real _f);									// set f_i population to _f
-			real getF_i (int _i);														// get f_i population
-
-			void setPhiLoc (int _i, real _phi);							// set phi value to _phi
-			real getPhiLoc (int _i);												// get phi value
-
-			void setGammaBLoc (real _gamma_b);							// set gamma for bulk
-			real getGammaBLoc ();														// get gamma for bulk
+			static void setPhiLoc (int _i, real _phi);							// set phi value to _phi
+			static real getPhiLoc (int _i);												// get phi value
 
-			void setGammaSLoc (real _gamma_s);							// set gamma for shear
-			real getGammaSLoc ();														// get gamma for shear
+			static void setGammaBLoc (real _gamma_b);							// set gamma for bulk
+			static real getGammaBLoc ();														// get gamma for bulk
 
-			void setGammaOddLoc (real _gamma_odd);					// set gamma odd
-			real getGammaOddLoc ();													// get gamma odd
+			static void setGammaSLoc (real _gamma_s);							// set gamma for shear
+			static real getGammaSLoc ();														// get gamma for shear
 
-			void setGammaEvenLoc (real _gamma_even);				// set gamma even
-			real getGammaEvenLoc ();												// get gamma even
+			static void setGammaOddLoc (real _gamma_odd);					// set gamma odd
+			static real getGammaOddLoc ();													// get gamma odd
 
-			/* HELPFUL OPERATIONS WITH POPULATIONS AND MOMENTS */
-			void scaleF_i (int _i, real _value);						// scale population i by _value
+			static void setGammaEvenLoc (real _gamma_even);				// set gamma even
+			static real getGammaEvenLoc ();												// get gamma even
 
 			/* FUNCTIONS DECLARATION */
 //			void initLatticeModelLoc ();										// local eq weights
-			void collision (int _lbTempFlag, int _extForceFlag,
-											int _couplForceFlag, Real3D _f);						// perform collision step
-			void calcLocalMoments (real *m);								// calculate local moments
-			void relaxMoments (real *m,
-												 int _extForceFlag, Real3D _f);					// relax local moms to eq moms
-			void thermalFluct (real *m);										// apply thermal fluctuations
-			void applyForces (real *m, Real3D _f);											// apply ext and coupl forces
-			void btranMomToPop (real *m);										// back-transform moms to pops
+			void thermalFluct (real *m);										// apply thermal fluctuations to the moments m
+
+			/* FUSED COLLISION AND STREAMING OF A BLOCK OF SITES */
+			enum { blockSize = 8 };													// max. number of sites in a block
+			template < bool _fluct, bool _extForce, bool _force >
+			void collideStreamBlock (const LBLattice& _src, LBLattice& _dst,
+															 longint _index, int _n, const Real3D *_f,
+															 const longint *_shift);
 
 		private:
-			std::vector<real> f;														// populations on a site
 			static real gamma_bLoc;													// gamma bulk
 			static real gamma_sLoc;													// gamma shear
 			static real gamma_oddLoc;												// gamma odd
@@ -85,6 +83,40 @@ namespace espressopp {
 			static std::vector<real> phiLoc;								// local fluct amplitudes
     };
 		
+/*******************************************************************************************/
+
+		class LBLattice {
+			/**
+			 * \brief Description of the properties of the LBLattice class
+			 *
+			 * This is a LBLattice class storing the populations of all lattice sites of a CPU
+			 * (including the halo) in one contiguous array. The populations of one velocity
+			 * direction are stored together (structure of arrays): population _l of site
+			 * (_i,_j,_k) is at pop(_l)[index(_i,_j,_k)], and the site index runs fastest along z.
+			 * A shift along the lattice is a constant offset of the site index, see offset().
+			 */
+		public:
+			LBLattice (Int3D _myNi, int _numVels);
+			~LBLattice ();
+
+			longint index (int _i, int _j, int _k) const {
+				return (longint(_i) * myNi[1] + _j) * myNi[2] + _k; }
+			longint offset (int _di, int _dj, int _dk) const {
+				return (longint(_di) * myNi[1] + _dj) * myNi[2] + _dk; }
+			longint getNumSites () const { return numSites; }
+
+			real *pop (int _l) { return &f[_l * numSites]; }
+			const real *pop (int _l) const { return &f[_l * numSites]; }
+
+			void setF_i (int _i, int _j, int _k, int _l, real _f) { pop(_l)[index(_i,_j,_k)] = _f; }
+			real getF_i (int _i, int _j, int _k, int _l) const { return pop(_l)[index(_i,_j,_k)]; }
+
+		private:
+			Int3D myNi;																			// lattice size of the CPU + halo
+			longint numSites;																// number of sites of the CPU + halo
+			std::vector<real> f;														// populations, [_l * numSites + site]
+		};
+
 /*******************************************************************************************/
 		
     class LBMom {
@@ -156,6 +188,176 @@ namespace espressopp {
 			Real3D extForceLoc;															// local external force
 			Real3D couplForceLoc;														// local coupling force
 		};
+
+/*******************************************************************************************/
+
+		/* Collide the _n <= blockSize sites _index, _index+1, ... of _src (consecutive along z)
+		 and push the populations along the shifts _shift to _dst. Every stage of the collision
+		 (moments, relaxation, fluctuations, forces, back-transformation) runs over the whole block, so that
+		 the moments stay in a small local array and the loops over the sites vectorize. The
+		 flags are template parameters: _fluct adds thermal fluctuations, _extForce shifts the
+		 equilibrium fluxes by half the forces _f, _force applies the forces _f. */
+		template < bool _fluct, bool _extForce, bool _force >
+		inline void LBSite::collideStreamBlock (const LBLattice& _src, LBLattice& _dst,
+																						 longint _index, int _n, const Real3D *_f,
+																						 const longint *_shift) {
+			real m[19][blockSize];
+			const real *p[19];
+			real _invB[19], _w[19];
+			for (int l = 0; l < 19; l++) {
+				p[l] = _src.pop(l) + _index;
+				_invB[l] = LatticePar::getInvBLoc(l);
+				_w[l] = LatticePar::getEqWeightLoc(l);
+			}
+
+			/* local moments */
+			for (int s = 0; s < _n; s++) {
+				real f0 = p[0][s];
+				real f1p2   =  p[1][s] +  p[2][s],  f1m2   =  p[1][s] -  p[2][s];
+				real f3p4   =  p[3][s] +  p[4][s],  f3m4   =  p[3][s] -  p[4][s];
+				real f5p6   =  p[5][s] +  p[6][s],  f5m6   =  p[5][s] -  p[6][s];
+				real f7p8   =  p[7][s] +  p[8][s],  f7m8   =  p[7][s] -  p[8][s];
+				real f9p10  =  p[9][s] + p[10][s],  f9m10  =  p[9][s] - p[10][s];
+				real f11p12 = p[11][s] + p[12][s],  f11m12 = p[11][s] - p[12][s];
+				real f13p14 = p[13][s] + p[14][s],  f13m14 = p[13][s] - p[14][s];
+				real f15p16 = p[15][s] + p[16][s],  f15m16 = p[15][s] - p[16][s];
+				real f17p18 = p[17][s] + p[18][s],  f17m18 = p[17][s] - p[18][s];
+
+				m[0][s] = f0 + f1p2 + f3p4 + f5p6 + f7p8 + f9p10 + f11p12 + f13p14 + f15p16 + f17p18;
+				m[1][s] = f1m2 +   f7m8 +  f9m10 + f11m12 + f13m14;
+				m[2][s] = f3m4 +   f7m8 -  f9m10 + f15m16 + f17m18;
+				m[3][s] = f5m6 + f11m12 - f13m14 + f15m16 - f17m18;
+				m[4][s] = -f0 +   f7p8 + f9p10 + f11p12 + f13p14 + f15p16 + f17p18;
+				m[5][s] = 2.*f1p2 -   f3p4 -  f5p6 +   f7p8 +  f9p10 + f11p12 + f13p14 - 2.* (f15p16 + f17p18);
+				m[6][s] = f3p4 -   f5p6 +  f7p8 +  f9p10 - f11p12 - f13p14;
+				m[7][s] = f7p8 -  f9p10;
+				m[8][s] = f11p12 - f13p14;
+				m[9][s] = f15p16 - f17p18;
+				m[10][s] = -2.* f1m2 +   f7m8 +  f9m10 + f11m12 + f13m14;
+				m[11][s] = -2.* f3m4 +   f7m8 -  f9m10 + f15m16 + f17m18;
+				m[12][s] = -2.* f5m6 + f11m12 - f13m14 + f15m16 - f17m18;
+				m[13][s] = f7m8 +  f9m10 - f11m12 - f13m14;
+				m[14][s] = -f7m8 +  f9m10 + f15m16 + f17m18;
+				m[15][s] = f11m12 - f13m14 - f15m16 + f17m18;
+				m[16][s] = f0 - 2.* (f1p2 + f3p4 + f5p6) +   f7p8 +  f9p10
+				+ f11p12 + f13p14 + f15p16 + f17p18;
+				m[17][s] = -2.* f1p2 +   f3p4 +   f5p6 +   f7p8 +  f9p10 + f11p12
+				+ f13p14 -    2.* (f15p16 + f17p18);
+				m[18][s] = -f3p4 +   f5p6 +   f7p8 +  f9p10 - f11p12 - f13p14;
+			}
+
+			/* relaxation to the equilibrium moments */
+			real _jScale = LatticePar::getALoc() / LatticePar::getTauLoc();
+			real _gamma_b = gamma_bLoc, _gamma_s = gamma_sLoc;
+			real _gamma_odd = gamma_oddLoc, _gamma_even = gamma_evenLoc;
+			for (int s = 0; s < _n; s++) {
+				real jx = m[1][s] * _jScale, jy = m[2][s] * _jScale, jz = m[3][s] * _jScale;
+				if (_extForce) {
+					jx += 0.5 * _f[s][0]; jy += 0.5 * _f[s][1]; jz += 0.5 * _f[s][2];
+				}
+				real _invRhoLoc = 1. / m[0][s];
+				real j2 = jx*jx + jy*jy + jz*jz;
+
+				real pi0 = j2 * _invRhoLoc;
+				real pi1 = (jx*jx - jy*jy) * _invRhoLoc;
+				real pi2 = (3.*jx*jx - j2) * _invRhoLoc;
+				real pi3 = jx*jy * _invRhoLoc;
+				real pi4 = jx*jz * _invRhoLoc;
+				real pi5 = jy*jz * _invRhoLoc;
+
+				m[4][s] = pi0 + _gamma_b * (m[4][s] - pi0);
+				m[5][s] = pi1 + _gamma_s * (m[5][s] - pi1);
+				m[6][s] = pi2 + _gamma_s * (m[6][s] - pi2);
+				m[7][s] = pi3 + _gamma_s * (m[7][s] - pi3);
+				m[8][s] = pi4 + _gamma_s * (m[8][s] - pi4);
+				m[9][s] = pi5 + _gamma_s * (m[9][s] - pi5);
+				for (int l = 10; l < 16; l++) m[l][s] *= _gamma_odd;
+				for (int l = 16; l < 19; l++) m[l][s] *= _gamma_even;
+			}
+
+			/* thermal fluctuations draw random numbers, this stage stays per site */
+			if (_fluct) {
+				for (int s = 0; s < _n; s++) {
+					real ms[19];
+					for (int l = 0; l < 19; l++) ms[l] = m[l][s];
+					thermalFluct(ms);
+					for (int l = 4; l < 19; l++) m[l][s] = ms[l];
+				}
+			}
+
+			/* external and coupling forces, see Eq.198 for sigma in B.Dünweg & A.J.C.Ladd in Adv.Poly.Sci. 221, 89-166 (2009) */
+			if (_force) {
+				real _gamma_sp = _gamma_s + 1.;
+				real _gamma_sph = 0.5 * _gamma_sp;
+				real _third = (1./3.)*(_gamma_b - _gamma_s);
+				for (int s = 0; s < _n; s++) {
+					real fx = _f[s][0], fy = _f[s][1], fz = _f[s][2];
+					real _invRho = 1. / m[0][s];
+					real ux = (0.5 * fx + m[1][s]) * _invRho;
+					real uy = (0.5 * fy + m[2][s]) * _invRho;
+					real uz = (0.5 * fz + m[3][s]) * _invRho;
+
+					m[1][s] += fx;
+					m[2][s] += fy;
+					m[3][s] += fz;
+
+					real _secTerm = _third * (ux*fx + uy*fy + uz*fz);
+					real sigma0 = _gamma_sp*ux*fx + _secTerm;
+					real sigma1 = _gamma_sp*uy*fy + _secTerm;
+					real sigma2 = _gamma_sp*uz*fz + _secTerm;
+
+					m[4][s] += sigma0 + sigma1 + sigma2;
+					m[5][s] += 2.*sigma0 - sigma1 - sigma2;
+					m[6][s] += sigma1 - sigma2;
+					m[7][s] += _gamma_sph*(ux*fy + uy*fx);
+					m[8][s] += _gamma_sph*(ux*fz + uz*fx);
+					m[9][s] += _gamma_sph*(uy*fz + uz*fy);
+				}
+			}
+
+			/* back-transformation to the populations, scaled with the weights, and streaming */
+			real *q[19];
+			for (int l = 0; l < 19; l++) q[l] = _dst.pop(l) + _index + _shift[l];
+			for (int s = 0; s < _n; s++) {
+				real b[19];
+				for (int l = 0; l < 19; l++) b[l] = m[l][s] * _invB[l];
+
+				q[0][s] = _w[0] * (b[0] -b[4] +b[16]);
+				q[1][s] = _w[1] * (b[0] +b[1] + 2.* (b[5] -b[10] -b[16] -b[17]));
+				q[2][s] = _w[2] * (b[0] -b[1] + 2.* (b[5] +b[10] -b[16] -b[17]));
+				q[3][s] = _w[3] * (b[0] +b[2] -b[5] +b[6] - 2.* (b[11] +b[16]) +b[17] -b[18]);
+				q[4][s] = _w[4] * (b[0] -b[2] -b[5] +b[6] + 2.* (b[11] -b[16]) +b[17] -b[18]);
+				q[5][s] = _w[5] * (b[0] +b[3] -b[5] -b[6] - 2.* (b[12] +b[16]) +b[17] +b[18]);
+				q[6][s] = _w[6] * (b[0] -b[3] -b[5] -b[6] + 2.* (b[12] -b[16]) +b[17] +b[18]);
+
+				q[7][s] = _w[7] * (b[0] +b[1] +b[2] +b[4] +b[5] +b[6] +b[7] +b[10] +b[11]
+													 +b[13] -b[14] +b[16] +b[17] +b[18]);
+				q[8][s] = _w[8] * (b[0] -b[1] -b[2] +b[4] +b[5] +b[6] +b[7] -b[10] -b[11]
+													 -b[13] +b[14] +b[16] +b[17] +b[18]);
+				q[9][s] = _w[9] * (b[0] +b[1] -b[2] +b[4] +b[5] +b[6] -b[7] +b[10] -b[11]
+													 +b[13] +b[14] +b[16] +b[17] +b[18]);
+				q[10][s] = _w[10] * (b[0] -b[1] +b[2] +b[4] +b[5] +b[6] -b[7] -b[10] +b[11]
+														 -b[13] -b[14] +b[16] +b[17] +b[18]);
+
+				q[11][s] = _w[11] * (b[0] +b[1] +b[3] +b[4] +b[5] -b[6] +b[8] +b[10] +b[12]
+														 -b[13] +b[15] +b[16] +b[17] -b[18]);
+				q[12][s] = _w[12] * (b[0] -b[1] -b[3] +b[4] +b[5] -b[6] +b[8] -b[10] -b[12]
+														 +b[13] -b[15] +b[16] +b[17] -b[18]);
+				q[13][s] = _w[13] * (b[0] +b[1] -b[3] +b[4] +b[5] -b[6] -b[8] +b[10] -b[12]
+														 -b[13] -b[15] +b[16] +b[17] -b[18]);
+				q[14][s] = _w[14] * (b[0] -b[1] +b[3] +b[4] +b[5] -b[6] -b[8] -b[10] +b[12]
+														 +b[13] +b[15] +b[16] +b[17] -b[18]);
+
+				q[15][s] = _w[15] * (b[0] +b[2] +b[3] +b[4] - 2.*b[5] +b[9] +b[11] +b[12]
+														 +b[14] -b[15] +b[16] - 2.*b[17]);
+				q[16][s] = _w[16] * (b[0] -b[2] -b[3] +b[4] - 2.*b[5] +b[9] -b[11] -b[12]
+														 -b[14] +b[15] +b[16] - 2.*b[17]);
+				q[17][s] = _w[17] * (b[0] +b[2] -b[3] +b[4] - 2.*b[5] -b[9] +b[11] -b[12]
+														 +b[14] +b[15] +b[16] - 2.*b[17]);
+				q[18][s] = _w[18] * (b[0] -b[2] +b[3] +b[4] - 2.*b[5] -b[9] -b[11] +b[12]
+														 -b[14] -b[15] +b[16] - 2.*b[17]);
+			}
+		}
   }
 }
 
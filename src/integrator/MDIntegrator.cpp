@@ -23,6 +23,9 @@
 #include <python.hpp>
 #include "MDIntegrator.hpp"
 #include "System.hpp"
+#include "storage/Storage.hpp"
+#include "iterator/CellListIterator.hpp"
+#include <limits>
 
 
 namespace espressopp {
@@ -44,11 +47,13 @@ namespace espressopp {
       timeFlag = true;
       step = 0;
       dt = 0.005;
+      trackDisplacement = false;
     }
     
     MDIntegrator::~MDIntegrator()
     {
       LOG4ESPP_INFO(theLogger, "~Integrator");
+      _onParticlesChanged.disconnect();
     }
     
     void MDIntegrator::setTimeStep(real _dt)
@@ -93,6 +98,73 @@ namespace espressopp {
     	return exList[k];
     }
 
+    void MDIntegrator::setRebuildPolicy(std::string policy)
+    {
+      System& system = getSystemRef();
+      esutil::Error err(system.comm);
+      if (policy != "step" && policy != "displacement") {
+        std::stringstream msg;
+        msg << "Unknown rebuild policy: " << policy << ", it should be step or displacement";
+        err.setException(msg.str());
+        err.checkException();
+      }
+
+      _onParticlesChanged.disconnect();
+      refIds.clear();
+      refPositions.clear();
+      trackDisplacement = (policy == "displacement");
+
+      // without reference positions the next check forces a resort
+      if (trackDisplacement) {
+        _onParticlesChanged = system.storage->onParticlesChanged.connect(
+          boost::bind(&MDIntegrator::saveReferencePositions, this));
+      }
+    }
+
+    std::string MDIntegrator::getRebuildPolicy()
+    {
+      return trackDisplacement ? "displacement" : "step";
+    }
+
+    void MDIntegrator::saveReferencePositions()
+    {
+      System& system = getSystemRef();
+      CellList realCells = system.storage->getRealCells();
+
+      refIds.clear();
+      refPositions.clear();
+      for(iterator::CellListIterator cit(realCells); !cit.isDone(); ++cit) {
+        refIds.push_back(cit->id());
+        refPositions.push_back(cit->position());
+      }
+    }
+
+    /* Between two decompose() calls particles neither change their cell
+       nor are folded back into the box, so the cell order of the
+       particles and their positions can be compared directly. */
+    real MDIntegrator::maxDisplacement()
+    {
+      System& system = getSystemRef();
+      CellList realCells = system.storage->getRealCells();
+
+      const real unknown = std::numeric_limits<real>::max();
+      real maxSqDist = 0.0;
+      size_t i = 0, n = refIds.size();
+      for(iterator::CellListIterator cit(realCells); !cit.isDone(); ++cit, ++i) {
+        if (i == n || cit->id() != refIds[i]) {
+          maxSqDist = unknown;
+          break;
+        }
+        maxSqDist = std::max(maxSqDist, (cit->position() - refPositions[i]).sqr());
+      }
+      if (i < n) maxSqDist = unknown;
+
+      real maxAllSqDist;
+      mpi::all_reduce(*system.comm, maxSqDist, maxAllSqDist, boost::mpi::maximum<real>());
+
+      return (maxAllSqDist == unknown) ? unknown : sqrt(maxAllSqDist);
+    }
+
     //////////////////////////////////////////////////
     // REGISTRATION WITH PYTHON
     //////////////////////////////////////////////////
@@ -106,6 +178,7 @@ namespace espressopp {
         ("integrator_MDIntegrator", no_init)
         .add_property("dt", &MDIntegrator::getTimeStep, &MDIntegrator::setTimeStep)
         .add_property("step", &MDIntegrator::getStep, &MDIntegrator::setStep)
+        .add_property("rebuildPolicy", &MDIntegrator::getRebuildPolicy, &MDIntegrator::setRebuildPolicy)
         .add_property("system", &SystemAccess::getSystem)
         .def("run", &MDIntegrator::run)
         .def("addExtension", &MDIntegrator::addExtension)
@@ -29,7 +29,10 @@
 #include "Extension.hpp"
 #include <boost/signals2.hpp>
 #include "types.hpp"
+#include "Real3D.hpp"
 #include "esutil/Error.hpp"
+#include <string>
+#include <vector>
 
 
 namespace espressopp {
@@ -79,6 +82,21 @@ namespace espressopp {
 
         int getNumberOfExtensions();
 
+        /** Sets how the integrator decides that the particles have to be
+            resorted and the Verlet lists rebuilt, i.e. that a particle
+            may have moved by more than half the skin:
+
+            "step": the largest displacement of any particle within a step
+            is summed up over the steps (default, cheap but pessimistic).
+
+            "displacement": the position of every particle is recorded
+            whenever the storage is decomposed, and the largest distance
+            of a particle from its recorded position is used.
+        */
+        void setRebuildPolicy(std::string policy);
+
+        std::string getRebuildPolicy();
+
         // signals to extend the integrator
         boost::signals2::signal0 <void> runInit; // initialization of run()
         boost::signals2::signal0 <void> recalc1; // inside recalc, before updateForces()
@@ -87,6 +105,7 @@ namespace espressopp {
         boost::signals2::signal1 <void, real&> inIntP; // inside end of integrate1()
         boost::signals2::signal0 <void> aftIntP; // after  integrate1()
         boost::signals2::signal0 <void> aftInitF; // after initForces()
+        boost::signals2::signal0 <void> aftInitG; // after initForces() and the ghost update
         boost::signals2::signal0 <void> aftCalcF; // after calcForces()
         boost::signals2::signal0 <void> befIntV; // before integrate2()
         boost::signals2::signal0 <void> aftIntV; // after  integrate2()
@@ -107,8 +126,26 @@ namespace espressopp {
         /** Timestep used for integration */
         real dt;
 
+        /** true for the rebuild policy "displacement" */
+        bool trackDisplacement;
+
+        /** Largest distance of a real particle from its position at the
+            last decompose() over all CPUs. Returns the largest real number
+            if the particles have changed since without a decompose(). */
+        real maxDisplacement();
+
         /** Logger */
         static LOG4ESPP_DECL_LOGGER(theLogger);
+
+      private:
+
+        // particles at the last decompose(), in cell order
+        std::vector<size_t> refIds;
+        std::vector<Real3D> refPositions;
+
+        boost::signals2::connection _onParticlesChanged;
+
+        void saveReferencePositions();
     };
 
 
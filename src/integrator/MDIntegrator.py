@@ -26,6 +26,24 @@ r"""
 
 
 
+Properties
+
+* `dt`
+  time step
+
+* `step`
+  current integration step
+
+* `rebuildPolicy`
+  how the integrator decides that the particles have to be resorted and the
+  Verlet lists rebuilt. 'step' (default) sums up the largest displacement of
+  any particle in every step and resorts once the sum exceeds half the skin.
+  'displacement' records the positions at every resort and resorts once a
+  particle has moved by more than half the skin from its recorded position,
+  which usually allows considerably longer intervals between resorts.
+
+>>> integrator.rebuildPolicy = 'displacement'
+
 .. function:: espressopp.integrator.MDIntegrator.addExtension(extension)
 
 		:param extension: 
@@ -79,6 +97,6 @@ if pmi.isController :
 
         __metaclass__ = pmi.Proxy
         pmiproxydefs = dict(
-            pmiproperty = [ 'dt', 'step' ],
+            pmiproperty = [ 'dt', 'step', 'rebuildPolicy' ],
             pmicall = [ 'run', 'addExtension', 'getExtension', 'getNumberOfExtensions' ]
             )
@@ -45,6 +45,7 @@ StochasticVelocityRescaling::StochasticVelocityRescaling(
 		Extension(system) {
 	temperature = 0.0;
 	coupling = 1; //tau_t coupling
+	counterRNG = false;
 
 	type = Extension::Thermostat;
 
@@ -95,6 +96,14 @@ real StochasticVelocityRescaling::getCoupling() {
 	return coupling;
 }
 
+void StochasticVelocityRescaling::setCounterRNG(bool _counterRNG) {
+	counterRNG = _counterRNG;
+}
+
+bool StochasticVelocityRescaling::getCounterRNG() {
+	return counterRNG;
+}
+
 void StochasticVelocityRescaling::initialize() {
   LOG4ESPP_INFO(theLogger, "init, coupling = " << coupling << 
                                 ", external temperature = " << temperature);
@@ -131,8 +140,16 @@ void StochasticVelocityRescaling::rescaleVelocities() {
 
 
   if(getSystem()->comm->rank() == 0){
-    EKin_new = stochasticVR_pullEkin(EKin, EKin_ref, DegreesOfFreedom, pref,
-        rng);
+    if (counterRNG) {
+      // rescaling happens once per step, after the step counter is incremented
+      esutil::CounterRNG stepRNG = rng->counter(esutil::CounterRNG::STREAM_SVR,
+          integrator->getStep(), 0);
+      EKin_new = stochasticVR_pullEkin(EKin, EKin_ref, DegreesOfFreedom, pref,
+          rng, &stepRNG);
+    } else {
+      EKin_new = stochasticVR_pullEkin(EKin, EKin_ref, DegreesOfFreedom, pref,
+          rng);
+    }
     // it should always be larger than 0
     if (EKin_new <= 0)
       throw std::runtime_error(
@@ -148,7 +165,8 @@ void StochasticVelocityRescaling::rescaleVelocities() {
 
 }
 
-real StochasticVelocityRescaling::stochasticVR_sumGaussians(const int n) {
+real StochasticVelocityRescaling::stochasticVR_sumGaussians(const int n,
+		esutil::CounterRNG *counter) {
 
 	/** plain implementation **/
 	/*	real tmp, sum = 0.0;
@@ -162,18 +180,19 @@ real StochasticVelocityRescaling::stochasticVR_sumGaussians(const int n) {
 	if (n == 0)
 		return 0.0;
 	else if (n == 1) {
-		rr = rng->normal();
+		rr = drawNormal(rng, counter);
 		return rr * rr;
 	} else if (n % 2 == 0) {
-		return 2.0 * gammaDist->drawNumber(n / 2);
+		return 2.0 * drawGamma(n / 2, counter);
 	} else {
-		rr = rng->normal();
-		return 2.0 * gammaDist->drawNumber((n - 1) / 2) + rr * rr;
+		rr = drawNormal(rng, counter);
+		return 2.0 * drawGamma((n - 1) / 2, counter) + rr * rr;
 	}
 }
 
 real StochasticVelocityRescaling::stochasticVR_pullEkin(real Ekin,
-		real Ekin_ref, int dof, real taut, shared_ptr<esutil::RNG> rng) {
+		real Ekin_ref, int dof, real taut, shared_ptr<esutil::RNG> rng,
+		esutil::CounterRNG *counter) {
 	real factor, rr;
 
 	/*
@@ -188,14 +207,24 @@ real StochasticVelocityRescaling::stochasticVR_pullEkin(real Ekin,
 	else {
 		factor = exp(-1.0 / taut);
 	}
-	rr = rng->normal();
+	rr = drawNormal(rng, counter);
 	return Ekin
 			+ (1.0 - factor)
-					* (Ekin_ref * (stochasticVR_sumGaussians(dof - 1) + rr * rr)
+					* (Ekin_ref * (stochasticVR_sumGaussians(dof - 1, counter) + rr * rr)
 							/ dof - Ekin)
 			+ 2.0 * rr * sqrt(Ekin * Ekin_ref / dof * (1.0 - factor) * factor);
 }
 
+real StochasticVelocityRescaling::drawNormal(shared_ptr<esutil::RNG> rng,
+		esutil::CounterRNG *counter) {
+	return counter ? counter->normal() : rng->normal();
+}
+
+real StochasticVelocityRescaling::drawGamma(const unsigned int ia,
+		esutil::CounterRNG *counter) {
+	return counter ? counter->gamma(ia) : gammaDist->drawNumber(ia);
+}
+
 real GammaDistributionBoost::drawNumber(const unsigned int ia) {
 	return rng->gamma(ia);
 }
@@ -267,6 +296,8 @@ void StochasticVelocityRescaling::registerPython() {
 			"coupling", &StochasticVelocityRescaling::getCoupling,
 			&StochasticVelocityRescaling::setCoupling)
     
+   .add_property("counterRNG", &StochasticVelocityRescaling::getCounterRNG,
+			&StochasticVelocityRescaling::setCounterRNG)
    .def("connect", &StochasticVelocityRescaling::connect)
    .def("disconnect", &StochasticVelocityRescaling::disconnect)
     ;
@@ -26,6 +26,7 @@
 
 #include "types.hpp"
 #include "logging.hpp"
+#include "esutil/CounterRNG.hpp"
 
 #include "Extension.hpp"
 #include "VelocityVerlet.hpp"
@@ -90,10 +91,17 @@ public:
 
 	real getCoupling();
 
+	/** draw the noise from the counter-based RNG keyed on the step */
+	void setCounterRNG(bool _counterRNG);
+
+	bool getCounterRNG();
+
 	~StochasticVelocityRescaling();
 
-	/** Sum n squared Gaussian numbers - shortcut via Gamma distribution */
-	real stochasticVR_sumGaussians(const int n);
+	/** Sum n squared Gaussian numbers - shortcut via Gamma distribution,
+	 *  drawn from counter instead of the rng if given */
+	real stochasticVR_sumGaussians(const int n,
+			esutil::CounterRNG *counter = 0);
 
 	/** Pull new value for the kinetic energy following the canonical distribution
 	 *  Cite: Bussi et al JCP (2007) (there's a typo in the paper - this code is correct
@@ -101,9 +109,11 @@ public:
 	 *  Ekin_ref: reference kinetic energy
 	 *  dof: degrees of freedom
 	 *  taut: coupling time/strength
+	 *  counter: counter-based generator to draw from instead of rng, or 0
 	 *  */
 	real stochasticVR_pullEkin(real Ekin, real Ekin_ref, int dof,
-			real taut, shared_ptr<esutil::RNG> rng);
+			real taut, shared_ptr<esutil::RNG> rng,
+			esutil::CounterRNG *counter = 0);
 
 	/** Register this class so it can be used from Python. */
 	static void registerPython();
@@ -124,6 +134,12 @@ private:
 
 	GammaDistribution *gammaDist;
 
+	bool counterRNG; //!< use rng->counter() instead of the stateful rng
+
+	/** draw from counter, the generator of the current step, if given */
+	real drawNormal(shared_ptr<esutil::RNG> rng, esutil::CounterRNG *counter);
+	real drawGamma(const unsigned int ia, esutil::CounterRNG *counter);
+
 	void rescaleVelocities();
 
     void connect();
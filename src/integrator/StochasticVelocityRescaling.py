@@ -47,5 +47,5 @@ if pmi.isController :
         __metaclass__ = pmi.Proxy
         pmiproxydefs = dict(
             cls =  'espressopp.integrator.StochasticVelocityRescalingLocal',
-            pmiproperty = [ 'temperature', 'coupling' ]
+            pmiproperty = [ 'temperature', 'coupling', 'counterRNG' ]
         )
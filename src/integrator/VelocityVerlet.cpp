@@ -30,6 +30,8 @@
 #include "System.hpp"
 #include "storage/Storage.hpp"
 #include "mpi.hpp"
+#include "esutil/Error.hpp"
+#include <sstream>
 
 #ifdef VTRACE
 #include "vampirtrace/vt_user.h"
@@ -51,6 +53,15 @@ namespace espressopp {
       LOG4ESPP_INFO(theLogger, "construct VelocityVerlet");
       resortFlag = true;
       maxDist    = 0.0;
+      overlapComm = false;
+      skinTuneInterval = 0;
+      skinTuneFactor = 1.1;
+      skinTuneDirection = 1;
+      skinTuneTime = 0.0;
+      skinTuneSteps = 0;
+      skinTuneResorts = 0;
+      skinTuneMark = 0.0;
+      skinTuneCost = -1.0;
     }
 
     VelocityVerlet::~VelocityVerlet()
@@ -68,6 +79,8 @@ namespace espressopp {
       System& system = getSystemRef();
       storage::Storage& storage = *system.storage;
       real skinHalf = 0.5 * system.getSkin();
+      // the timers were reset
+      skinTuneMark = 0.0;
 
       // signal
       runInit();
@@ -125,15 +138,27 @@ namespace espressopp {
         // signal
         aftIntP();
 
+        // measured after aftIntP so that moves by extensions are included
+        if (trackDisplacement) maxDist = maxDisplacement();
+
         LOG4ESPP_INFO(theLogger, "maxDist = " << maxDist << ", skin/2 = " << skinHalf);
 
         if (maxDist > skinHalf) resortFlag = true;
         
+        if (skinTuneInterval > 0) skinTuneSteps++;
+
         if (resortFlag) {
             VT_TRACER("resort1");
             time = timeIntegrate.getElapsedTime();
             LOG4ESPP_INFO(theLogger, "step " << i << ": resort particles");
-            storage.decompose();
+            // before the decomposition, which then builds the Verlet lists with
+            // the new skin, unless adjusting the cells has already decomposed
+            bool decomposed = false;
+            if (skinTuneInterval > 0) {
+              decomposed = tuneSkin();
+              skinHalf = 0.5 * system.getSkin();
+            }
+            if (!decomposed) storage.decompose();
             maxDist  = 0.0;
             resortFlag = false;
             nResorts ++;
@@ -154,6 +179,9 @@ namespace espressopp {
         aftIntV();
       }
 
+      // the time after the last resort counts for the next tune interval
+      skinTuneTime += timeForce + timeResort - skinTuneMark;
+
       timeRun = timeIntegrate.getElapsedTime();
       timeLost = timeRun - (timeForceComp[0] + timeForceComp[1] + timeForceComp[2] +
                  timeComm1 + timeComm2 + timeInt1 + timeInt2 + timeResort);
@@ -161,6 +189,67 @@ namespace espressopp {
       LOG4ESPP_INFO(theLogger, "finished run");
     }
 
+    void VelocityVerlet::setSkinTuneInterval(int interval)
+    {
+      skinTuneInterval = interval;
+      // start a new measurement
+      skinTuneTime = 0.0;
+      skinTuneSteps = 0;
+      skinTuneResorts = 0;
+      skinTuneCost = -1.0;
+    }
+
+    void VelocityVerlet::setSkinTuneFactor(real factor)
+    {
+      esutil::Error err(getSystemRef().comm);
+      if (factor <= 1.0) {
+        std::stringstream msg;
+        msg << "the skin tune factor has to be larger than 1, not " << factor;
+        err.setException( msg.str() );
+      }
+      err.checkException();
+      skinTuneFactor = factor;
+    }
+
+    bool VelocityVerlet::tuneSkin()
+    {
+      System& system = getSystemRef();
+      storage::Storage& storage = *system.storage;
+
+      real now = timeForce + timeResort;
+      skinTuneTime += now - skinTuneMark;
+      skinTuneMark = now;
+      if (++skinTuneResorts < skinTuneInterval || skinTuneSteps == 0) return false;
+
+      // the slowest node determines the speed, and all nodes have to agree on the skin
+      real cost;
+      mpi::all_reduce(*system.comm, skinTuneTime / skinTuneSteps, cost, boost::mpi::maximum<real>());
+      skinTuneTime = 0.0;
+      skinTuneSteps = 0;
+      skinTuneResorts = 0;
+
+      if (skinTuneCost >= 0.0 && cost > skinTuneCost) skinTuneDirection = -skinTuneDirection;
+      skinTuneCost = cost;
+
+      real skin = system.getSkin();
+      real newSkin = (skinTuneDirection > 0) ? skin * skinTuneFactor : skin / skinTuneFactor;
+
+      // at least one cell of size cutoff + skin has to fit on each node
+      real localSize = std::min(storage.getLocalBoxXMax() - storage.getLocalBoxXMin(),
+                       std::min(storage.getLocalBoxYMax() - storage.getLocalBoxYMin(),
+                                storage.getLocalBoxZMax() - storage.getLocalBoxZMin()));
+      real minSize;
+      mpi::all_reduce(*system.comm, localSize, minSize, boost::mpi::minimum<real>());
+      if (newSkin > minSize - system.maxCutoff) {
+        newSkin = std::max(skin, minSize - system.maxCutoff);
+        skinTuneDirection = -1;
+      }
+
+      LOG4ESPP_INFO(theLogger, "cost per step " << cost << " at skin " << skin
+                    << ", new skin " << newSkin);
+      return newSkin != skin && system.setSkin(newSkin);
+    }
+
     void VelocityVerlet::resetTimers() {
       timeForce  = 0.0;
       for(int i = 0; i < 100; i++)
@@ -273,6 +362,9 @@ namespace espressopp {
       // signal
       inIntP(maxSqDist);
 
+      // the displacement is measured in run(), no reduction needed here
+      if (trackDisplacement) return 0.0;
+
       real maxAllSqDist;
       mpi::all_reduce(*system.comm, maxSqDist, maxAllSqDist, boost::mpi::maximum<real>());
 
@@ -310,6 +402,7 @@ namespace espressopp {
 
       // signal
       aftInitF();
+      aftInitG();
 
       System& sys = getSystemRef();
       const InteractionList& srIL = sys.shortRangeInteractions;
@@ -323,20 +416,74 @@ namespace espressopp {
       }
     }
 
-    void VelocityVerlet::updateForces()
+    void VelocityVerlet::calcForcesOverlapped()
     {
-      LOG4ESPP_INFO(theLogger, "update ghosts, calculate forces and collect ghost forces")
+      VT_TRACER("forces");
+
+      LOG4ESPP_INFO(theLogger, "calculate interior forces during the ghost update");
+
       real time;
-      storage::Storage& storage = *getSystemRef().storage;
+      System& sys = getSystemRef();
+      storage::Storage& storage = *sys.storage;
+      const InteractionList& srIL = sys.shortRangeInteractions;
+
       time = timeIntegrate.getElapsedTime();
-      { 
+      {
         VT_TRACER("commF");
-        storage.updateGhosts();
+        storage.beginUpdateGhosts();
       }
       timeComm1 += timeIntegrate.getElapsedTime() - time;
+
       time = timeIntegrate.getElapsedTime();
-      calcForces();
+      initForces();
+
+      // signal
+      aftInitF();
+
+      for (size_t i = 0; i < srIL.size(); i++) {
+        real timeIL = timeIntegrate.getElapsedTime();
+        srIL[i]->addForcesInterior();
+        timeForceComp[i] += timeIntegrate.getElapsedTime() - timeIL;
+      }
+      timeForce += timeIntegrate.getElapsedTime() - time;
+
+      time = timeIntegrate.getElapsedTime();
+      {
+        VT_TRACER("commF");
+        storage.finishUpdateGhosts();
+      }
+      timeComm1 += timeIntegrate.getElapsedTime() - time;
+
+      time = timeIntegrate.getElapsedTime();
+      // signal, only now as the extensions may use the ghosts
+      aftInitG();
+
+      for (size_t i = 0; i < srIL.size(); i++) {
+        real timeIL = timeIntegrate.getElapsedTime();
+        srIL[i]->addForcesBoundary();
+        timeForceComp[i] += timeIntegrate.getElapsedTime() - timeIL;
+      }
       timeForce += timeIntegrate.getElapsedTime() - time;
+    }
+
+    void VelocityVerlet::updateForces()
+    {
+      LOG4ESPP_INFO(theLogger, "update ghosts, calculate forces and collect ghost forces")
+      real time;
+      storage::Storage& storage = *getSystemRef().storage;
+      if (overlapComm) {
+        calcForcesOverlapped();
+      } else {
+        time = timeIntegrate.getElapsedTime();
+        {
+          VT_TRACER("commF");
+          storage.updateGhosts();
+        }
+        timeComm1 += timeIntegrate.getElapsedTime() - time;
+        time = timeIntegrate.getElapsedTime();
+        calcForces();
+        timeForce += timeIntegrate.getElapsedTime() - time;
+      }
       time = timeIntegrate.getElapsedTime();
       {
         VT_TRACER("commR");
@@ -416,6 +563,9 @@ namespace espressopp {
         ("integrator_VelocityVerlet", init< shared_ptr<System> >())
         .def("getTimers", &wrapGetTimers)
         .def("resetTimers", &VelocityVerlet::resetTimers)
+        .add_property("overlapComm", &VelocityVerlet::getOverlapComm, &VelocityVerlet::setOverlapComm)
+        .add_property("skinTuneInterval", &VelocityVerlet::getSkinTuneInterval, &VelocityVerlet::setSkinTuneInterval)
+        .add_property("skinTuneFactor", &VelocityVerlet::getSkinTuneFactor, &VelocityVerlet::setSkinTuneFactor)
         ;
     }
   }
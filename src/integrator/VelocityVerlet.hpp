@@ -75,6 +75,27 @@ namespace espressopp {
 
         void resetTimers();
 
+        /** If set, the forces of pairs without ghosts are computed while
+            the ghost positions are communicated, see
+            Storage::beginUpdateGhosts() and Interaction::addForcesInterior().
+            The aftInitF signal is still emitted before any force is added,
+            aftInitG only after the ghosts have arrived. */
+        void setOverlapComm(bool _overlapComm) { overlapComm = _overlapComm; }
+        bool getOverlapComm() const { return overlapComm; }
+
+        /** If larger than 0, the skin is adapted during run(): every
+            skinTuneInterval-th resort, the force and resort time per step
+            since the previous adaption is compared with the one before,
+            and the skin is multiplied by the tune factor if the cost has
+            decreased, or divided by it if the cost has increased (and the
+            direction is reversed). A new skin is applied only at a resort,
+            which rebuilds the Verlet lists, and the cell grid is adjusted
+            if the cells become too small, see System::setSkin(). */
+        void setSkinTuneInterval(int interval);
+        int getSkinTuneInterval() const { return skinTuneInterval; }
+        void setSkinTuneFactor(real factor);
+        real getSkinTuneFactor() const { return skinTuneFactor; }
+
 
         // signal used for constraints
         //boost::signals2::signal0 <void> saveOldPos;
@@ -106,10 +127,31 @@ namespace espressopp {
 
 
         bool resortFlag;  //!< true implies need for resort of particles
+        bool overlapComm; //!< overlap the ghost update with the force computation
         real maxDist;
 
         real maxCut;
 
+        /// see setSkinTuneInterval()
+        int skinTuneInterval;
+        real skinTuneFactor;
+        /// +1 if the skin is currently growing, -1 if it is shrinking
+        int skinTuneDirection;
+        /// force and resort time and number of steps since the last adaption
+        real skinTuneTime;
+        int skinTuneSteps;
+        int skinTuneResorts;
+        /// force and resort time of the current run at the last resort
+        real skinTuneMark;
+        /// cost per step of the previous interval, negative if unknown
+        real skinTuneCost;
+
+        /** called at a resort before the decomposition, changes the skin
+            if the tune interval is complete. Returns whether the storage
+            was already decomposed, because the cells were adjusted to
+            the new skin. Collective. */
+        bool tuneSkin();
+
 
         /* TODO should be removed after signals will be tested
         shared_ptr< class Langevin > langevin;  //!< Langevin thermostat if available
@@ -138,6 +180,9 @@ namespace espressopp {
 
         void calcForces();
 
+        /** ghost update and force computation for overlapComm */
+        void calcForcesOverlapped();
+
         void printPositions(bool withGhost);
 
         void printForces(bool withGhost);
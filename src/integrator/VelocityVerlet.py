@@ -29,6 +29,28 @@ r"""
 
 		:param system: 
 		:type system: 
+
+.. attribute:: overlapComm
+
+		If True, the forces of pairs without ghost particles are
+		computed while the ghost positions are communicated
+		(default False). Pays off for storages with particle arrays
+		on many nodes.
+
+.. attribute:: skinTuneInterval
+
+		If larger than 0, the Verlet skin of the system is adapted
+		during the run (default 0, off). Every skinTuneInterval-th
+		rebuild of the Verlet lists, the time for the forces and the
+		rebuilds per step since the last adaption is compared with
+		the one before, and the skin is changed by skinTuneFactor
+		in the direction that lowered it. The cell grid is adjusted
+		when the cells become smaller than cutoff + skin.
+
+.. attribute:: skinTuneFactor
+
+		factor by which the skin is changed in one adaption
+		(default 1.1), has to be larger than 1.
 """
 from espressopp.esutil import cxxinit
 from espressopp import pmi
@@ -48,5 +70,6 @@ if pmi.isController :
         pmiproxydefs = dict(
           cls =  'espressopp.integrator.VelocityVerletLocal',
           pmicall = ['resetTimers'],
+          pmiproperty = ['overlapComm', 'skinTuneInterval', 'skinTuneFactor'],
           pmiinvoke = ['getTimers']
         )
@@ -125,6 +125,8 @@ namespace espressopp {
         maxDist += integrate1();
         timeInt1 += timeIntegrate.getElapsedTime() - time;
 
+        if (trackDisplacement) maxDist = maxDisplacement();
+
 	LOG4ESPP_INFO(theLogger, "maxDist = " << maxDist << ", skin/2 = " << skinHalf);
 
 	if (maxDist > skinHalf) resortFlag = true;
@@ -223,6 +225,9 @@ namespace espressopp {
 	maxSqDist = std::max(maxSqDist, sqDist);
       }
 
+      // the displacement is measured in run(), no reduction needed here
+      if (trackDisplacement) return 0.0;
+
       real maxAllSqDist;
 
       mpi::all_reduce(*system.comm, maxSqDist, maxAllSqDist, 
@@ -27,8 +27,11 @@
 #include "types.hpp"
 #include "Tensor.hpp"
 #include "Interaction.hpp"
+#include "Potential.hpp"
 #include "storage/Storage.hpp"
 #include "esutil/Array2D.hpp"
+#include "esutil/Threads.hpp"
+#include "System.hpp"
 #include "iterator/CellListAllPairsIterator.hpp"
 
 namespace espressopp {
@@ -77,6 +80,15 @@ namespace espressopp {
       virtual int bondType() { return Nonbonded; }
 
     protected:
+      /// addForces on the storage's particle arrays
+      void addForcesArrays();
+
+      /// number of threads for the loops, 1 if the potential is not thread safe
+      int numThreads() {
+        return PotentialTraits< Potential >::threadSafe ?
+          storage->getSystemRef().getNumThreads() : 1;
+      }
+
       int ntypes;
       esutil::Array2D< Potential, esutil::enlarge > potentialArray;
       shared_ptr< storage::Storage > storage;
@@ -90,6 +102,11 @@ namespace espressopp {
     addForces() {
       LOG4ESPP_INFO(theLogger, "add forces computed for all pairs in the cell lists");
 
+      if (storage->hasParticleArrays()) {
+        addForcesArrays();
+        return;
+      }
+
       for (iterator::CellListAllPairsIterator it(storage->getRealCells()); it.isValid(); ++it) {
         Particle &p1 = *it->first;
         Particle &p2 = *it->second;
@@ -103,19 +120,128 @@ namespace espressopp {
       }
     }
 
+    template < typename _Potential > inline void
+    CellListAllPairsInteractionTemplate < _Potential >::
+    addForcesArrays() {
+      storage::ParticleArrays &pa = storage->getParticleArrays();
+      if (pa.size() == 0) return;
+
+      const Cell *firstCell = storage->getFirstCell();
+      const Real3D *pos = &pa.position[0];
+      const int *type = &pa.type[0];
+      CellList &realCells = storage->getRealCells();
+      const longint ncells = realCells.size();
+
+      // getPotential() does not enlarge the array, so the threads may
+      // share it
+
+      // with several threads, each one accumulates into its own force
+      // buffer, which are summed up afterwards
+      const int nThreads = numThreads();
+      if (nThreads > 1) pa.prepareThreadForces(nThreads);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nThreads) if (nThreads > 1)
+#endif
+      {
+        Real3D *f = nThreads > 1 ?
+          pa.getThreadForce(esutil::threadNum()) : &pa.force[0];
+
+        // same pairs as CellListAllPairsIterator, but on the arrays
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (longint k = 0; k < ncells; ++k) {
+          Cell *cell = realCells[k];
+          longint c = cell - firstCell;
+          longint begin = pa.cellBegin(c), end = pa.cellEnd(c);
+
+          for (longint i = begin; i < end; ++i) {
+            const Real3D pi = pos[i];
+            const int typei = type[i];
+            Real3D fi(0.0, 0.0, 0.0);
+
+            for (longint j = i + 1; j < end; ++j) {
+              const Potential &potential = getPotential(typei, type[j]);
+              Real3D dist = pi - pos[j];
+              Real3D force(0.0, 0.0, 0.0);
+              if (PairForce< Potential >::compute(potential, force,
+                      *pa.particle[i], *pa.particle[j], dist)) {
+                fi += force;
+                f[j] -= force;
+              }
+            }
+
+            for (NeighborCellList::Iterator ncit(cell->neighborCells); ncit.isValid(); ++ncit) {
+              if (ncit->useForAllPairs) continue;
+              longint nc = ncit->cell - firstCell;
+              for (longint j = pa.cellBegin(nc), nend = pa.cellEnd(nc); j < nend; ++j) {
+                const Potential &potential = getPotential(typei, type[j]);
+                Real3D dist = pi - pos[j];
+                Real3D force(0.0, 0.0, 0.0);
+                if (PairForce< Potential >::compute(potential, force,
+                        *pa.particle[i], *pa.particle[j], dist)) {
+                  fi += force;
+                  f[j] -= force;
+                }
+              }
+            }
+
+            f[i] += fi;
+          }
+        }
+      }
+
+      if (nThreads > 1) pa.sumThreadForces(nThreads);
+      pa.addForcesToParticles();
+    }
+
     template < typename _Potential > inline real
     CellListAllPairsInteractionTemplate < _Potential >::
     computeEnergy() {
       LOG4ESPP_INFO(theLogger, "compute energy by the Verlet List");
 
-      real e = 0.0;
-      for (iterator::CellListAllPairsIterator it(storage->getRealCells()); it.isValid(); ++it) {
-        const Particle &p1 = *it->first;
-        const Particle &p2 = *it->second;
-        const Potential &potential = getPotential(p1.type(), p2.type());
-        e += potential._computeEnergy(p1, p2);
+      CellList &realCells = storage->getRealCells();
+      const longint ncells = realCells.size();
+
+      // per thread sums, added up in a fixed order
+      const int nThreads = numThreads();
+      std::vector< real > ethread(nThreads, 0.0);
+
+      // same pairs as CellListAllPairsIterator, split by cells
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nThreads) if (nThreads > 1)
+#endif
+      {
+        real et = 0.0;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (longint k = 0; k < ncells; ++k) {
+          ParticleList &pl = realCells[k]->particles;
+          NeighborCellList &ncl = realCells[k]->neighborCells;
+          for (size_t a = 0; a < pl.size(); ++a) {
+            const Particle &p1 = pl[a];
+            for (size_t b = a + 1; b < pl.size(); ++b) {
+              const Particle &p2 = pl[b];
+              et += getPotential(p1.type(), p2.type())._computeEnergy(p1, p2);
+            }
+            for (NeighborCellList::Iterator ncit(ncl); ncit.isValid(); ++ncit) {
+              if (ncit->useForAllPairs) continue;
+              ParticleList &npl = ncit->cell->particles;
+              for (size_t b = 0; b < npl.size(); ++b) {
+                const Particle &p2 = npl[b];
+                et += getPotential(p1.type(), p2.type())._computeEnergy(p1, p2);
+              }
+            }
+          }
+        }
+        ethread[esutil::threadNum()] = et;
       }
 
+      real e = 0.0;
+      for (int t = 0; t < nThreads; ++t) e += ethread[t];
+
       // reduce over all CPUs
       real esum;
       boost::mpi::all_reduce(*mpiWorld, e, esum, std::plus<real>());
@@ -175,19 +301,51 @@ namespace espressopp {
     computeVirialTensor(Tensor& wij) {
       LOG4ESPP_INFO(theLogger, "computed virial tensor for all pairs in the cell lists");
 
-      Tensor wlocal(0.0);
-      for (iterator::CellListAllPairsIterator it(storage->getRealCells());
-           it.isValid(); ++it) {
-        const Particle &p1 = *it->first;
-        const Particle &p2 = *it->second;
-        const Potential &potential = getPotential(p1.type(), p2.type());
+      CellList &realCells = storage->getRealCells();
+      const longint ncells = realCells.size();
 
-        Real3D force(0.0, 0.0, 0.0);
-        if(potential._computeForce(force, p1, p2)) {
-          Real3D dist = p1.position() - p2.position();
-          wlocal += Tensor(dist, force);
+      const int nThreads = numThreads();
+      std::vector< Tensor > wthread(nThreads, Tensor(0.0));
+
+      // same pairs as CellListAllPairsIterator, split by cells
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nThreads) if (nThreads > 1)
+#endif
+      {
+        Tensor wt(0.0);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (longint k = 0; k < ncells; ++k) {
+          ParticleList &pl = realCells[k]->particles;
+          NeighborCellList &ncl = realCells[k]->neighborCells;
+          for (size_t a = 0; a < pl.size(); ++a) {
+            const Particle &p1 = pl[a];
+            for (size_t b = a + 1; b < pl.size(); ++b) {
+              const Particle &p2 = pl[b];
+              Real3D force(0.0, 0.0, 0.0);
+              if (getPotential(p1.type(), p2.type())._computeForce(force, p1, p2)) {
+                wt += Tensor(p1.position() - p2.position(), force);
+              }
+            }
+            for (NeighborCellList::Iterator ncit(ncl); ncit.isValid(); ++ncit) {
+              if (ncit->useForAllPairs) continue;
+              ParticleList &npl = ncit->cell->particles;
+              for (size_t b = 0; b < npl.size(); ++b) {
+                const Particle &p2 = npl[b];
+                Real3D force(0.0, 0.0, 0.0);
+                if (getPotential(p1.type(), p2.type())._computeForce(force, p1, p2)) {
+                  wt += Tensor(p1.position() - p2.position(), force);
+                }
+              }
+            }
+          }
         }
+        wthread[esutil::threadNum()] = wt;
       }
+
+      Tensor wlocal(0.0);
+      for (int t = 0; t < nThreads; ++t) wlocal += wthread[t];
       
       // reduce over all CPUs
       Tensor wsum(0.0);
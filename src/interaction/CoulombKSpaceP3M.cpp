@@ -24,6 +24,7 @@
 //#include <boost/signals2.hpp>
 #include "CoulombKSpaceP3M.hpp"
 #include "CellListAllParticlesInteractionTemplate.hpp"
+#include <algorithm>
 
 namespace espressopp {
   namespace interaction {
@@ -193,10 +194,7 @@ namespace espressopp {
       
       getParticleNumber();
       preset();
-      
-      // first initialize
-      initialize();
-        
+
       // This function calculates the square of all particle charges. It should be called ones,
       // if the total number of particles doesn't change.
       count_charges(system->storage->getRealCells()); 
@@ -215,13 +213,134 @@ namespace espressopp {
     }
     
     CoulombKSpaceP3M::~CoulombKSpaceP3M(){
-      /*
-      delete [] sum;
-      delete [] totsum;
-      sum = NULL;
-      totsum = NULL;
-      */
-      clean_fftw();
+    }
+
+    /* Every x plane of a brick goes to the node that owns the plane in the
+       real space slabs of the FFT. Both sides know the geometry of all bricks,
+       so the counts follow without further communication, and the planes are
+       always ordered by their position in the brick. */
+    void CoulombKSpaceP3M::setExchangeCounts(int nComp, bool toSlabs) {
+      const mpi::communicator &comm = *system->comm;
+      int nNodes = comm.size();
+      int me = comm.rank();
+
+      sendCounts.assign(nNodes, 0);
+      recvCounts.assign(nNodes, 0);
+      sendDispls.resize(nNodes);
+      recvDispls.resize(nNodes);
+
+      // planes of my brick, by the owner of their slab
+      vector<int> &mine = toSlabs ? sendCounts : recvCounts;
+      int myPlane = nComp * brickN[1] * brickN[2];
+      for (int bx = 0; bx < brickN[0]; ++bx) {
+        mine[fft->getXOwner(wrap(brickLo[0] + bx, M[0]))] += myPlane;
+      }
+
+      // planes of all bricks on my slab, by their node
+      vector<int> &theirs = toSlabs ? recvCounts : sendCounts;
+      for (int r = 0; r < nNodes; ++r) {
+        const int *g = &brickGeom[6*r];
+        for (int bx = 0; bx < g[3]; ++bx) {
+          if (fft->getXOwner(wrap(g[0] + bx, M[0])) == me)
+            theirs[r] += nComp * g[4] * g[5];
+        }
+      }
+
+      int sendTotal = 0, recvTotal = 0;
+      for (int r = 0; r < nNodes; ++r) {
+        sendDispls[r] = sendTotal;
+        recvDispls[r] = recvTotal;
+        sendTotal += sendCounts[r];
+        recvTotal += recvCounts[r];
+      }
+      sendBuf.resize(std::max(sendTotal, 1));
+      recvBuf.resize(std::max(recvTotal, 1));
+    }
+
+    void CoulombKSpaceP3M::brickToSlabs() {
+      const mpi::communicator &comm = *system->comm;
+      int nNodes = comm.size();
+      int me = comm.rank();
+
+      setExchangeCounts(1, true);
+
+      longint planeSize = longint(brickN[1]) * brickN[2];
+      for (int s = 0; s < nNodes; ++s) {
+        // nodes without planes may start at the end of the buffer
+        real *b = &sendBuf[0] + sendDispls[s];
+        for (int bx = 0; bx < brickN[0]; ++bx) {
+          if (fft->getXOwner(wrap(brickLo[0] + bx, M[0])) != s) continue;
+          const real *plane = &brick[bx * planeSize];
+          b = std::copy(plane, plane + planeSize, b);
+        }
+      }
+
+      MPI_Datatype type = boost::mpi::get_mpi_datatype< real >(real());
+      MPI_Alltoallv(&sendBuf[0], &sendCounts[0], &sendDispls[0], type,
+                    &recvBuf[0], &recvCounts[0], &recvDispls[0], type,
+                    static_cast< MPI_Comm >(comm));
+
+      // add the planes up, wrapping the bricks around the periodic mesh
+      dcomplex *rs = fft->getRealSpace();
+      std::fill(rs, rs + fft->realSpaceSize(), dcomplex(0.0));
+      for (int r = 0; r < nNodes; ++r) {
+        const int *g = &brickGeom[6*r];
+        const real *b = &recvBuf[0] + recvDispls[r];
+        for (int bx = 0; bx < g[3]; ++bx) {
+          int x = wrap(g[0] + bx, M[0]);
+          if (fft->getXOwner(x) != me) continue;
+          x -= fft->getXBegin();
+          for (int by = 0; by < g[4]; ++by) {
+            dcomplex *row = rs + (longint(x) * M[1] + wrap(g[1] + by, M[1])) * M[2];
+            for (int bz = 0; bz < g[5]; ++bz) {
+              row[wrap(g[2] + bz, M[2])] += *b++;
+            }
+          }
+        }
+      }
+    }
+
+    void CoulombKSpaceP3M::slabsToBrick() {
+      const mpi::communicator &comm = *system->comm;
+      int nNodes = comm.size();
+      int me = comm.rank();
+
+      setExchangeCounts(3, false);
+
+      for (int r = 0; r < nNodes; ++r) {
+        const int *g = &brickGeom[6*r];
+        real *b = &sendBuf[0] + sendDispls[r];
+        for (int bx = 0; bx < g[3]; ++bx) {
+          int x = wrap(g[0] + bx, M[0]);
+          if (fft->getXOwner(x) != me) continue;
+          x -= fft->getXBegin();
+          for (int by = 0; by < g[4]; ++by) {
+            const real *row = &phi[3 * (longint(x) * M[1] + wrap(g[1] + by, M[1])) * M[2]];
+            for (int bz = 0; bz < g[5]; ++bz) {
+              const real *f = row + 3 * wrap(g[2] + bz, M[2]);
+              *b++ = f[0];
+              *b++ = f[1];
+              *b++ = f[2];
+            }
+          }
+        }
+      }
+
+      MPI_Datatype type = boost::mpi::get_mpi_datatype< real >(real());
+      MPI_Alltoallv(&sendBuf[0], &sendCounts[0], &sendDispls[0], type,
+                    &recvBuf[0], &recvCounts[0], &recvDispls[0], type,
+                    static_cast< MPI_Comm >(comm));
+
+      longint planeSize = 3 * longint(brickN[1]) * brickN[2];
+      brickPhi.resize(brickN[0] * planeSize);
+      for (int s = 0; s < nNodes; ++s) {
+        const real *b = &recvBuf[0] + recvDispls[s];
+        for (int bx = 0; bx < brickN[0]; ++bx) {
+          if (fft->getXOwner(wrap(brickLo[0] + bx, M[0])) != s) continue;
+          std::copy(b, b + planeSize, &brickPhi[bx * planeSize]);
+          b += planeSize;
+        }
+      }
     }
 
     //////////////////////////////////////////////////
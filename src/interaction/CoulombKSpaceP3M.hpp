@@ -27,13 +27,13 @@
 #include <cmath>
 #include <boost/signals2.hpp>
 
-#include <fftw3.h>
 
 #include "mpi.hpp"
 #include "Potential.hpp"
 #include "CellListAllParticlesInteractionTemplate.hpp"
 #include "iterator/CellListIterator.hpp"
 #include "esutil/Error.hpp"
+#include "esutil/SlabFFT.hpp"
 
 #include "bc/BC.hpp"
 
@@ -62,63 +62,87 @@ namespace espressopp {
      *  M. Deserno, C.Holm, J.Chem. Phys, 109[18] (1998) 7694
      */
     
-    // TODO this version is still under development. not parallel. doesn't work for several
-    // CPUs
+    /*  The mesh is distributed over the nodes. Every node assigns the charges
+     *  of its particles to a brick of the mesh that covers their assignment
+     *  stencils. The bricks are added into the x slabs of the distributed FFT
+     *  (esutil::SlabFFT), the influence function is applied on the local
+     *  k space planes, and the fields come back to the bricks by the reverse
+     *  plane exchange. No node holds the full mesh.
+     */
     // TODO should be optimized (force, energy and virial calculate the same stuff)
-    
+
     class CoulombKSpaceP3M : public PotentialTemplate< CoulombKSpaceP3M > {
     private:
       shared_ptr< System > system; // we need the system object to be able to access the box
                                    // dimensions, communicator, number of particles, signals
-      
+
       Real3D d_mesh; // distance between two meshpoints
       Real3D d_inv; // inverted distance between two meshpoints
-      
+
       real C_pref; // Coulomb prefactor
       real alpha; // Ewald splitting parameter
       Int3D M; // number of mesh-points
       int P; // charge assignment order
       real rc; // cutoff in real space
-      int interpolation; // number of interpolation points for the charge assignment 
+      int interpolation; // number of interpolation points for the charge assignment
                         // function
-      
+
       int MMM;  // MMM = M[0]*M[1]*M[2]
-      
+
       // Brillouin zones for the optimal influence function
       static const int brillouin = 1;
-      
+
       vector< vector<real> > precalc_interp_caf;
-      
+
       vector< vector<real> > mesh_shift;
-      
-      vector< vector<real> > d_op; 
-      
-      //vector< vector< vector<real> > >gf; // influence function
-      vector<real> gf; // influence function
-      
-      //vector< vector< vector< dcomplex > > > QQQ;
+
+      vector< vector<real> > d_op;
+
+      shared_ptr< esutil::SlabFFT > fft; // distributed FFT of the mesh
+
+      // influence function and transformed charges on the local k space planes
+      vector<real> gf;
       vector<  dcomplex > QQQ;
-      
-      vector<vector<dcomplex> > phi;
-        
-      // reference points in the lattice, needed for the charge assignment
+
+      // the 3 field components on the local real space planes, interleaved
+      vector<real> phi;
+
+      // reference points in the lattice and charge assignment weights of the local
+      // particles, in the order of the cell list iteration. The weight of the mesh point
+      // g_ca + (i,j,k) is w_ca[3P*n + i] * w_ca[3P*n + P + j] * w_ca[3P*n + 2P + k], the
+      // charge is included in the x weights.
       vector<Int3D> g_ca;
-      // mesh contributions of the charged particles
-      vector< vector< real > > q_l;
-      
-      vector< vector< vector< int > > > map_indx;
-      
+      vector<real> w_ca;
+
+      // brick of the mesh covering the charge assignment of the local particles,
+      // first with the charges, then with the 3 field components
+      Int3D brickLo, brickN;
+      vector<real> brick;
+      vector<real> brickPhi;
+      vector<int> brickGeom; // brickLo and brickN of all nodes
+
+      // buffers of the brick <-> slab exchange
+      vector<real> sendBuf, recvBuf;
+      vector<int> sendCounts, sendDispls, recvCounts, recvDispls;
+
       int nParticles;  // number of particles in system
       Real3D sysL;     // system size
       real sumq_2, sum_q2; // squared sum of charges and sum of squared charges
-      
+
       real af_coef[8][7][7]; // matrix of predefined assigned function coefficients
-      
-      // fftw elements
-      fftw_complex *in_array;
-      fftw_plan plan;
-      int MM[3]; // auxiliary array for plan generation
-      
+
+      static int wrap(int a, int m) { a %= m; return a < 0 ? a + m : a; }
+
+      // index of the mesh point i on the local k space planes
+      longint kIndex(const Int3D &i) const {
+        return (longint(i[1] - fft->getYBegin()) * M[0] + i[0]) * M[2] + i[2];
+      }
+
+      // exchange between the bricks and the slabs of the FFT
+      void setExchangeCounts(int nComp, bool toSlabs);
+      void brickToSlabs();
+      void slabsToBrick();
+
       //real oddeven1, oddeven2; // supporting variables odd/even interpolation order
     public:
       static void registerPython();
@@ -138,25 +162,15 @@ namespace espressopp {
       void preset(){
         sysL = system -> bc -> getBoxL();
         MMM = M[0] * M[1] * M[2];
-        for(int i=0; i<3; i++) MM[i] = M[i];
-        
-        // map xpos, ypos and zpos to index = zpos + M[2] * (ypos + M[1] * xpos)
-        map_indx = vector< vector< vector<int> > > (M[0],
-                           vector< vector<int> >   (M[1],
-                                   vector<int>     (M[2], 0) ));
-        for(int i=0; i<M[0]; i++){
-          int mi = M[1] * i;
-          for(int j=0; j<M[1]; j++){
-            int mj = M[2] * (j + mi);
-            for(int k=0; k<M[2]; k++){
-              map_indx[i][j][k] = k + mj;
-            }
-          }
-        }
-        
+
+        // the FFT plans depend on the mesh only
+        if (!fft || fft->getMesh() != M)
+          fft = make_shared< esutil::SlabFFT >(*system->comm, M);
+
         precalc_interp_caf = vector< vector<real> > (P, vector<real>(2*interpolation+1, 0.0) );
         precalc_interpol_charge_assignment_f();
-        
+
+        initialize();
       }
       
 /////////////////////////////////////////////////////////////////////////////////////////
@@ -193,10 +207,9 @@ namespace espressopp {
       int getInterpolation() const { return interpolation; }
 /////////////////////////////////////////////////////////////////////////////////////////
 
+      // influence function and operators, recalculated when the box or a parameter changes
       void initialize(){
-        
-        set_fftw_array();
-        
+
         mesh_shift = vector< vector<real> >(3, vector<real>() );
         d_op = vector< vector<real> >(3, vector<real>() );
         for(int i=0;i<3;i++){
@@ -208,22 +221,12 @@ namespace espressopp {
         
         calc_differential_operator();
         
-        gf = vector<real>(MMM, 0.0);
-        
+        gf = vector<real>(fft->kSpaceSize(), 0.0);
+
         calc_opt_influence_function();
-        
-        // -----------------------------------------
-        // charge assignment
-        QQQ = vector<dcomplex>(MMM, 0.0);
-        
-        
-        // TODO check double use in common part
-        g_ca = vector<Int3D>(0, Int3D(0) );
 
-        q_l = vector< vector<real> > (nParticles, vector<real>(MMM, 0.0) );
-        
-        // force specific
-        phi = vector<vector<dcomplex> > (3, vector<dcomplex> (MMM, dcomplex(0.0) ));
+        QQQ = vector<dcomplex>(fft->kSpaceSize(), 0.0);
+        phi = vector<real>(3 * fft->realSpaceSize(), 0.0);
       }
       
       // get the current particle number on the current node
@@ -280,18 +283,18 @@ namespace espressopp {
       void assign_charge_for_single_particle(real q, Real3D particle_pos){
       }
       
-      // calculates the optimal influence function
+      // calculates the optimal influence function on the local k space planes
       void calc_opt_influence_function(){
-        
+
         real coef  = 2.0 * MMM / (sysL[0]*sysL[1]);
 
         real denom;
         Real3D nom, D;
         Int3D i;
-        for ( i[0] = 0; i[0] < M[0]; i[0]++){
-          for ( i[1] = 0; i[1] < M[1]; i[1]++){
+        for ( i[1] = fft->getYBegin(); i[1] < fft->getYEnd(); i[1]++){
+          for ( i[0] = 0; i[0] < M[0]; i[0]++){
             for ( i[2] = 0; i[2] < M[2]; i[2]++){
-              int indx = map_indx[i[0]][i[1]][i[2]];
+              longint indx = kIndex(i);
               if ( i == Int3D(0) )
                 gf[ indx ] = 0.0;
               else{
@@ -410,32 +413,18 @@ namespace espressopp {
         return out;
       }
       
-      void set_fftw_array(){
-        in_array = (fftw_complex*) fftw_malloc( MMM * sizeof(fftw_complex));
-      }
-      void set_plan_frw(){
-        plan = fftw_plan_dft(3, MM, in_array, in_array, FFTW_FORWARD, FFTW_ESTIMATE);
-      }
-      void set_plan_bcw(){
-        plan = fftw_plan_dft(3, MM, in_array, in_array, FFTW_BACKWARD, FFTW_ESTIMATE);
-      }
-      void clean_fftw(){
-        fftw_destroy_plan(plan);
-        in_array = NULL;
-        fftw_free(in_array);
-      }
-      
-      
       real _computeEnergy(CellList realCells){
-        
-        common_part(realCells, 1);
-        
-        real energy = 0.0;
-        
-        for (int i=0; i<MMM; i++){
-          energy += gf[i] * norm( QQQ[i] );
+
+        common_part(realCells);
+
+        real node_energy = 0.0;
+        for (longint i=0; i<fft->kSpaceSize(); i++){
+          node_energy += gf[i] * norm( QQQ[i] );
         }
-        
+
+        real energy = 0.0;
+        mpi::all_reduce( *system -> comm, node_energy, energy, plus<real>() );
+
         // TODO sysL[0]?? what about [1] and [2]?
         energy *= ( C_pref * sysL[0] / (4.0*MMM*M_PIl) );
 
@@ -446,10 +435,9 @@ namespace espressopp {
         return energy;
       }
       
-      // TODO get rid of iii at the end
-      void common_part(CellList realCells, int iii){
-        initialize();
-        
+      // assigns the charges of the local particles to the brick, collects the bricks
+      // of all nodes on the slabs and transforms them to k space
+      void common_part(CellList realCells){
         real _2interp = 2.0 * interpolation;
         // TODO assignshift probably should be [3]
         int assignshift = M[0]- floor((real)(P-1)/2.0);
@@ -464,103 +452,111 @@ namespace espressopp {
         }
 
         g_ca.clear();
-        g_ca = vector<Int3D>(nParticles, Int3D(0) );
-        QQQ.clear();
-        QQQ = vector<dcomplex>(MMM, dcomplex(0.0));
-        
-        Int3D Gi, arg;
+        w_ca.clear();
+        Int3D lo(0), hi(0);
         for(iterator::CellListIterator it(realCells); it.isValid(); ++it){
-          Particle &p = *it;
-          Real3D ppos = p.position();
+          Real3D ppos = it->position();
           
           Real3D d1;
           for(int i=0; i<3; i++){
             d1[i] = ppos[i] * M[i] / sysL[i] + modadd1;
           }
-          Gi  = Int3D(d1 + modadd2) + assignshift;
-          arg = Int3D( (d1 - dround(d1) + 0.5)*_2interp );
+          Int3D Gi  = Int3D(d1 + modadd2) + assignshift;
+          Int3D arg = Int3D( (d1 - dround(d1) + 0.5)*_2interp );
 
-          // specific for force !!!!!!!!
-          g_ca[p.id()] = Gi;
-          
-          // Calculate the mesh based charges
-          real T1,T2,T3;
+          for(int i=0; i<3; i++){
+            if (g_ca.empty() || Gi[i] < lo[i]) lo[i] = Gi[i];
+            if (g_ca.empty() || Gi[i] + P > hi[i]) hi[i] = Gi[i] + P;
+          }
+          g_ca.push_back(Gi);
+
+          for(int l=0; l<3; l++){
+            real q = (l == 0) ? it->q() : 1.0;
+            for(int i=0; i<P; i++) w_ca.push_back(q * precalc_interp_caf[i][arg[l]]);
+          }
+        }
+        brickLo = lo;
+        brickN = hi - lo;
+        brick.assign(longint(brickN[0]) * brickN[1] * brickN[2], 0.0);
+
+        // Calculate the mesh based charges
+        for(size_t n = 0; n < g_ca.size(); n++){
+          Int3D b = g_ca[n] - brickLo;
+          const real *wx = &w_ca[3*P*n], *wy = wx + P, *wz = wy + P;
           for (int i = 0; i < P; i++) {
-            int xpos = (Gi[0] + i) % M[0];
-            T1 = p.q() * precalc_interp_caf[i][arg[0]];
             for (int j = 0; j < P; j++) {
-              int ypos = (Gi[1] + j) % M[1];
-              T2 = T1 * precalc_interp_caf[j][arg[1]];
+              real T2 = wx[i] * wy[j];
+              real *row = &brick[((longint(b[0] + i) * brickN[1]) + b[1] + j) * brickN[2] + b[2]];
               for (int k = 0; k < P; k++) {
-                int zpos = (Gi[2] + k) % M[2];
-                T3 = T2 * precalc_interp_caf[k][arg[2]];
-                
-                int indx = map_indx[xpos][ypos][zpos];
-                
-                // specific for force !!!!!!!!
-                q_l[p.id()][indx] = T3;
-                
-                QQQ[indx] += dcomplex(T3, 0.0);
+                row[k] += T2 * wz[k];
               }
             }
           }
-
         }
- 
-        in_array = reinterpret_cast<fftw_complex*>( &QQQ[0] );
-        set_plan_frw();
-        fftw_execute(plan);
+
+        // the bricks of all nodes determine the exchange with the slabs
+        int geom[6] = { brickLo[0], brickLo[1], brickLo[2], brickN[0], brickN[1], brickN[2] };
+        brickGeom.clear();
+        mpi::all_gather( *system -> comm, geom, 6, brickGeom );
+
+        brickToSlabs();
+        fft->forward();
+
+        const dcomplex *ks = fft->getKSpace();
+        QQQ.assign(ks, ks + fft->kSpaceSize());
       }
 
       // @TODO this function could be void, 
       bool _computeForce(CellList realCells){
 
-        common_part(realCells, 0);
+        common_part(realCells);
         
-        // Calculate the supporting arrays phi_?_??:
-        Int3D i;
-        for ( i[0]=0; i[0]<M[0]; i[0]++){
-          for ( i[1]=0; i[1]<M[1]; i[1]++){
-            for ( i[2]=0; i[2]<M[2]; i[2]++) {  
-              int indx = map_indx[i[0]][i[1]][i[2]];
-              dcomplex phi_aux = gf[indx] * swap_complex( conj( QQQ[indx] ) );
-              
-              for (int ii=0; ii<3; ii++) phi[ii][indx] = d_op[ii][i[ii]] * phi_aux;
+        // Calculate the supporting arrays phi_?_?? on the local k space planes and
+        // transform them back one by one
+        longint nReal = fft->realSpaceSize();
+        for(int l=0; l<3; l++){
+          dcomplex *ks = fft->getKSpace();
+          Int3D i;
+          for ( i[1]=fft->getYBegin(); i[1]<fft->getYEnd(); i[1]++){
+            for ( i[0]=0; i[0]<M[0]; i[0]++){
+              for ( i[2]=0; i[2]<M[2]; i[2]++) {
+                longint indx = kIndex(i);
+                ks[indx] = d_op[l][i[l]] * gf[indx] * swap_complex( conj( QQQ[indx] ) );
+              }
             }
           }
-        }
 
-        for(int l=0; l<3; l++){
-          in_array = reinterpret_cast<fftw_complex*>( &phi[l][0] );
-          set_plan_bcw();
-          fftw_execute(plan);
+          fft->backward();
+
+          const dcomplex *rs = fft->getRealSpace();
+          for (longint p=0; p<nReal; p++) phi[3*p + l] = rs[p].real();
         }
+
+        slabsToBrick();
         
         real C_MMM_inv = C_pref / (real)MMM;
-        for(iterator::CellListIterator it(realCells); it.isValid(); ++it){
+        size_t n = 0;
+        for(iterator::CellListIterator it(realCells); it.isValid(); ++it, ++n){
           Particle &p = *it;
           
-          int iii = p.id();
+          Int3D b = g_ca[n] - brickLo;
+          const real *wx = &w_ca[3*P*n], *wy = wx + P, *wz = wy + P;
           Real3D ff(0.0);
           for (int i = 0; i < P; i++) {
-            int xpos = (g_ca[iii][0] + i) % M[0];
             for (int j = 0; j < P; j++) {
-              int ypos = (g_ca[iii][1] + j) % M[1];
+              real T2 = wx[i] * wy[j];
+              const real *row = &brickPhi[3 * (((longint(b[0] + i) * brickN[1]) + b[1] + j) * brickN[2] + b[2])];
               for (int k = 0; k < P; k++) {
-                int zpos = (g_ca[iii][2] + k) % M[2];
-                
-                int indx = map_indx[xpos][ypos][zpos];
+                real T3 = T2 * wz[k];
                 
-                Real3D f_add( phi[0][indx].real(),
-                              phi[1][indx].real(),
-                              phi[2][indx].real());
+                Real3D f_add( row[3*k], row[3*k + 1], row[3*k + 2] );
 
-                ff += C_MMM_inv * q_l[iii][indx]  *  f_add ;
+                ff += T3  *  f_add ;
               }
             }
           }
 
-          p.force() -= ff;
+          p.force() -= C_MMM_inv * ff;
         }
         
         // usual return from espressopp
@@ -109,6 +109,12 @@ namespace espressopp {
       }
 
     };
+
+    // the force depends on particle properties
+    template <>
+    struct PotentialTraits< CoulombRSpace > {
+      enum { distanceOnly = 0, threadSafe = 1 };
+    };
   }
 }
 
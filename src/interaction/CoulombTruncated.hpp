@@ -104,6 +104,12 @@ namespace espressopp {
       }
 
     };
+
+    // the force depends on particle properties
+    template <>
+    struct PotentialTraits< CoulombTruncated > {
+      enum { distanceOnly = 0, threadSafe = 1 };
+    };
   }
 }
 
@@ -32,8 +32,11 @@
 #include "FixedPairList.hpp"
 #include "FixedPairListAdress.hpp"
 #include "esutil/Array2D.hpp"
+#include "esutil/Threads.hpp"
 #include "bc/BC.hpp"
 #include "SystemAccess.hpp"
+#include "System.hpp"
+#include "Potential.hpp"
 #include "Interaction.hpp"
 #include "types.hpp"
 
@@ -95,8 +98,17 @@ namespace espressopp {
       virtual int bondType() { return Pair; }
 
     protected:
+      /// number of threads for the loops, 1 if the potential is not thread safe
+      int numThreads() {
+        return PotentialTraits< Potential >::threadSafe ?
+          getSystemRef().getNumThreads() : 1;
+      }
+
       int ntypes;
       shared_ptr < FixedPairList > fixedpairList;
+      // per pair forces of the threaded addForces
+      std::vector< Real3D > pairForce;
+      std::vector< char > pairHasForce;
       shared_ptr < Potential > potential;
     };
 
@@ -108,6 +120,52 @@ namespace espressopp {
       LOG4ESPP_INFO(_Potential::theLogger, "adding forces of FixedPairList");
       const bc::BC& bc = *getSystemRef().bc;  // boundary conditions
       real ltMaxBondSqr = fixedpairList->getLongtimeMaxBondSqr();
+
+      const int nThreads = numThreads();
+      if (nThreads > 1) {
+        // the threads compute the force of each pair into a buffer, which
+        // is then applied in the order of the list, so particles shared
+        // by several bonds are never written concurrently
+        FixedPairList &pairs = *fixedpairList;
+        const longint npairs = pairs.size();
+        pairForce.resize(npairs);
+        pairHasForce.resize(npairs);
+        std::vector< real > maxSqr(nThreads, ltMaxBondSqr);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nThreads)
+#endif
+        {
+          real maxSqrT = ltMaxBondSqr;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+          for (longint k = 0; k < npairs; ++k) {
+            Real3D dist;
+            bc.getMinimumImageVectorBox(dist, pairs[k].first->position(), pairs[k].second->position());
+            real d = dist.sqr();
+            if (d > maxSqrT) maxSqrT = d;
+            pairHasForce[k] = potential->_computeForce(pairForce[k], dist);
+          }
+          maxSqr[esutil::threadNum()] = maxSqrT;
+        }
+
+        for (int t = 0; t < nThreads; ++t) {
+          if (maxSqr[t] > ltMaxBondSqr) ltMaxBondSqr = maxSqr[t];
+        }
+        if (ltMaxBondSqr > fixedpairList->getLongtimeMaxBondSqr()) {
+          fixedpairList->setLongtimeMaxBondSqr(ltMaxBondSqr);
+        }
+
+        for (longint k = 0; k < npairs; ++k) {
+          if (pairHasForce[k]) {
+            pairs[k].first->force() += pairForce[k];
+            pairs[k].second->force() -= pairForce[k];
+          }
+        }
+        return;
+      }
+
       for (FixedPairList::PairList::Iterator it(*fixedpairList); it.isValid(); ++it) {
         Particle &p1 = *it->first;
         Particle &p2 = *it->second;
@@ -136,16 +194,34 @@ namespace espressopp {
 
       LOG4ESPP_INFO(theLogger, "compute energy of the FixedPairList pairs");
 
-      real e = 0.0;
       const bc::BC& bc = *getSystemRef().bc;  // boundary conditions
-      for (FixedPairList::PairList::Iterator it(*fixedpairList);
-	   it.isValid(); ++it) {
-        const Particle &p1 = *it->first;
-        const Particle &p2 = *it->second;
-        Real3D r21;
-        bc.getMinimumImageVectorBox(r21, p1.position(), p2.position());
-        e += potential->_computeEnergy(r21);
+      FixedPairList &pairs = *fixedpairList;
+      const longint npairs = pairs.size();
+
+      // per thread sums, added up in a fixed order
+      const int nThreads = numThreads();
+      std::vector< real > ethread(nThreads, 0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nThreads) if (nThreads > 1)
+#endif
+      {
+        real et = 0.0;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (longint k = 0; k < npairs; ++k) {
+          const Particle &p1 = *pairs[k].first;
+          const Particle &p2 = *pairs[k].second;
+          Real3D r21;
+          bc.getMinimumImageVectorBox(r21, p1.position(), p2.position());
+          et += potential->_computeEnergy(r21);
+        }
+        ethread[esutil::threadNum()] = et;
       }
+
+      real e = 0.0;
+      for (int t = 0; t < nThreads; ++t) e += ethread[t];
       real esum;
       boost::mpi::all_reduce(*mpiWorld, e, esum, std::plus<real>());
       return esum;
@@ -284,19 +360,36 @@ namespace espressopp {
     FixedPairListInteractionTemplate < _Potential >::computeVirialTensor(Tensor& w){
       LOG4ESPP_INFO(theLogger, "compute the virial tensor for the FixedPair List");
 
-      Tensor wlocal(0.0);
       const bc::BC& bc = *getSystemRef().bc;  // boundary conditions
-      for (FixedPairList::PairList::Iterator it(*fixedpairList);
-           it.isValid(); ++it) {
-        const Particle &p1 = *it->first;
-        const Particle &p2 = *it->second;
-        Real3D r21;
-        bc.getMinimumImageVectorBox(r21, p1.position(), p2.position());
-        Real3D force;
-        if(potential->_computeForce(force, r21)) { 
-          wlocal += Tensor(r21, force);
+      FixedPairList &pairs = *fixedpairList;
+      const longint npairs = pairs.size();
+
+      const int nThreads = numThreads();
+      std::vector< Tensor > wthread(nThreads, Tensor(0.0));
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nThreads) if (nThreads > 1)
+#endif
+      {
+        Tensor wt(0.0);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (longint k = 0; k < npairs; ++k) {
+          const Particle &p1 = *pairs[k].first;
+          const Particle &p2 = *pairs[k].second;
+          Real3D r21;
+          bc.getMinimumImageVectorBox(r21, p1.position(), p2.position());
+          Real3D force;
+          if(potential->_computeForce(force, r21)) { 
+            wt += Tensor(r21, force);
+          }
         }
+        wthread[esutil::threadNum()] = wt;
       }
+
+      Tensor wlocal(0.0);
+      for (int t = 0; t < nThreads; ++t) wlocal += wthread[t];
       
       // reduce over all CPUs
       Tensor wsum(0.0);
@@ -92,6 +92,12 @@ namespace espressopp {
         return false;
       }
     };
+
+    // the force depends on particle properties
+    template <>
+    struct PotentialTraits< GravityTruncated > {
+      enum { distanceOnly = 0, threadSafe = 1 };
+    };
   }
 }
 #endif
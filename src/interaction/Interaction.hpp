@@ -33,6 +33,8 @@ namespace espressopp {
 
     enum bondTypes {unused, Nonbonded, Single, Pair, Angular, Dihedral};
 
+    class PairExtension;
+
     /** Interaction base class. */
 
     class Interaction {
@@ -40,6 +42,14 @@ namespace espressopp {
     public:
       virtual ~Interaction() {};
       virtual void addForces() = 0;
+
+      /** Split form of addForces() used to overlap the ghost update with
+          the force computation. addForcesInterior() adds the forces that
+          do not depend on ghost particles and is called before the ghosts
+          are updated, addForcesBoundary() adds all the others. By default,
+          everything is done in addForcesBoundary(). */
+      virtual void addForcesInterior() {}
+      virtual void addForcesBoundary() { addForces(); }
       virtual real computeEnergy() = 0;
       virtual real computeEnergyAA() = 0;
       virtual real computeEnergyCG() = 0;
@@ -56,6 +66,17 @@ namespace espressopp {
       virtual real getMaxCutoff() = 0;
       virtual int bondType() = 0;
 
+      /** Evaluate the pair term ext in the pair loop of the force
+          computation, or none if ext is empty. Returns false if the
+          interaction does not support pair extensions. */
+      virtual bool setPairExtension(shared_ptr< PairExtension > ext) { return false; }
+
+      /** The Verlet list whose pairs a pair extension gets, none if the
+          interaction does not support pair extensions. */
+      virtual shared_ptr< VerletList > getPairExtensionList() {
+        return shared_ptr< VerletList >();
+      }
+
       static void registerPython();
 
     protected:
@@ -105,6 +105,25 @@ namespace espressopp {
         return energy;
       }
 
+      static void _computeForceBatch(const LJcos *const *pot,
+                                     const real *dx, const real *dy, const real *dz,
+                                     real *fx, real *fy, real *fz, int n) {
+        // both branches are evaluated and selected, so that the loop vectorizes
+        for (int k = 0; k < n; ++k) {
+          const LJcos &p = *pot[k];
+          real distSqr = dx[k] * dx[k] + dy[k] * dy[k] + dz[k] * dz[k];
+          real frac2 = p.auxCoef / distSqr;
+          real frac6 = frac2 * frac2 * frac2;
+          real ljFactor = frac6 * ( 48.0 * frac6 - 24.0 ) * frac2;
+          real cosFactor = p.phi_alpha * sin( p.alpha * distSqr + p.beta );
+          real ffactor = distSqr <= p.sqr_pot_border ? ljFactor : cosFactor;
+          ffactor = distSqr > p.cutoffSqr ? 0.0 : ffactor;
+          fx[k] = dx[k] * ffactor;
+          fy[k] = dy[k] * ffactor;
+          fz[k] = dz[k] * ffactor;
+        }
+      }
+
       bool _computeForceRaw(Real3D& force,
                             const Real3D& r21,
                             real distSqr) const {
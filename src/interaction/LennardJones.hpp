@@ -129,6 +129,22 @@ namespace espressopp {
         
       }
 
+      static void _computeForceBatch(const LennardJones *const *pot,
+                                     const real *dx, const real *dy, const real *dz,
+                                     real *fx, real *fy, real *fz, int n) {
+        // branch free, so that the loop vectorizes
+        for (int k = 0; k < n; ++k) {
+          real distSqr = dx[k] * dx[k] + dy[k] * dy[k] + dz[k] * dz[k];
+          real frac2 = 1.0 / distSqr;
+          real frac6 = frac2 * frac2 * frac2;
+          real ffactor = frac6 * (pot[k]->ff1 * frac6 - pot[k]->ff2) * frac2;
+          ffactor = distSqr > pot[k]->cutoffSqr ? 0.0 : ffactor;
+          fx[k] = dx[k] * ffactor;
+          fy[k] = dy[k] * ffactor;
+          fz[k] = dz[k] * ffactor;
+        }
+      }
+
       bool _computeForceRaw(Real3D& force,
                             const Real3D& dist,
                             real distSqr) const {
@@ -219,6 +219,12 @@ namespace espressopp {
         return true;
       }
     };
+
+    // the force depends on particle properties and creates bonds
+    template <>
+    struct PotentialTraits< LennardJonesAutoBonds > {
+      enum { distanceOnly = 0, threadSafe = 0 };
+    };
   }
 }
 
@@ -88,6 +88,23 @@ namespace espressopp {
 	return energy;
       }
 
+      static void _computeForceBatch(const Morse *const *pot,
+                                     const real *dx, const real *dy, const real *dz,
+                                     real *fx, real *fy, real *fz, int n) {
+        for (int k = 0; k < n; ++k) {
+          const Morse &p = *pot[k];
+          real distSqr = dx[k] * dx[k] + dy[k] * dy[k] + dz[k] * dz[k];
+          real r = sqrt(distSqr);
+          real e = exp(-p.alpha * (r - p.rMin));
+          // exp(-2 a (r - rMin)) = e * e
+          real ffactor = p.epsilon * 2.0 * p.alpha * (e * e - e) / r;
+          ffactor = distSqr > p.cutoffSqr ? 0.0 : ffactor;
+          fx[k] = dx[k] * ffactor;
+          fy[k] = dy[k] * ffactor;
+          fz[k] = dz[k] * ffactor;
+        }
+      }
+
       bool _computeForceRaw(Real3D& force,
                             const Real3D& dist,
                             real distSqr) const {
@@ -0,0 +1,58 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// ESPP_CLASS
+#ifndef _INTERACTION_PAIREXTENSION_HPP
+#define _INTERACTION_PAIREXTENSION_HPP
+
+#include "types.hpp"
+#include "Real3D.hpp"
+#include "Particle.hpp"
+
+namespace espressopp {
+  namespace interaction {
+
+    /** Pair term that is evaluated inside the pair loop of an
+        interaction, see Interaction::setPairExtension(). Pairwise
+        thermostats use it so that the pairs of a Verlet list are
+        traversed only once per force computation. The interaction hands
+        over all pairs of its list, the extension applies its own cutoff.
+    */
+    class PairExtension {
+
+    public:
+      virtual ~PairExtension() {};
+
+      /** Called by the interaction before it starts a force computation,
+          i.e. at the beginning of addForces() or addForcesInterior(). */
+      virtual void beginPairs() {}
+
+      /** Adds the force on p1 of the pair (p1, p2) with distance vector
+          dist = p1 - p2 to force; p2 gets the opposite force. */
+      virtual void addPairForce(Real3D& force, const Particle &p1,
+                                const Particle &p2, const Real3D& dist) = 0;
+
+      /** true if addPairForce() may be called by several threads at once */
+      virtual bool isThreadSafe() const = 0;
+    };
+  }
+}
+
+#endif
@@ -98,6 +98,16 @@ namespace espressopp {
 			 const Real3D& dist) const;
       bool _computeForce(Real3D& force,
                          const Particle &p1, const Particle &p2, const Real3D& dist) const;
+
+      // Batched interface (used by the compressed Verlet list loop):
+      // forces of n <= pairBatchSize pairs, pair k interacting via *pot[k]
+      // at distance (dx[k], dy[k], dz[k]); pairs beyond the cutoff get
+      // zero force. The default calls _computeForce for every pair;
+      // potentials with a closed form hide it by a plain loop over the
+      // batch that the compiler can vectorize.
+      static void _computeForceBatch(const Derived *const *pot,
+                                     const real *dx, const real *dy, const real *dz,
+                                     real *fx, real *fy, real *fz, int n);
       
       //bool _computeForce(CellList realcells) const;
       
@@ -146,6 +156,72 @@ namespace espressopp {
     //   }
     // };
 
+    /** Compile time properties of a potential. distanceOnly is 1 if the
+    force only depends on the distance vector, so that loops working on
+    the storage's particle arrays need not touch the Particle. Potentials
+    that use other particle properties (charge, radius, state) specialize
+    this to 0. threadSafe is 1 if the force and energy may be computed
+    by several threads at the same time, i.e. the computation does not
+    modify any state.
+    */
+    template < class _Potential >
+    struct PotentialTraits {
+      enum { distanceOnly = 1, threadSafe = 1 };
+    };
+
+    /** Number of pairs handed to _computeForceBatch at once. */
+    const int pairBatchSize = 8;
+
+    /** Computes the pair force for a pair whose distance vector is
+    already known, calling the cheapest interface the potential allows.
+    */
+    template < class _Potential, bool distanceOnly = PotentialTraits< _Potential >::distanceOnly >
+    struct PairForce {
+      static bool compute(const _Potential &potential, Real3D& force,
+                          const Particle &p1, const Particle &p2, const Real3D& dist) {
+        return potential._computeForce(force, dist);
+      }
+    };
+
+    template < class _Potential >
+    struct PairForce< _Potential, false > {
+      static bool compute(const _Potential &potential, Real3D& force,
+                          const Particle &p1, const Particle &p2, const Real3D& dist) {
+        return potential._computeForce(force, p1, p2);
+      }
+    };
+
+    /** Computes the forces of a batch of pairs of particle p1 with the
+    particles p2[k], calling the batched kernel if the potential only
+    depends on the distance.
+    */
+    template < class _Potential, bool distanceOnly = PotentialTraits< _Potential >::distanceOnly >
+    struct PairForceBatch {
+      static void compute(const _Potential *const *pot,
+                          const Particle &p1, const Particle *const *p2,
+                          const real *dx, const real *dy, const real *dz,
+                          real *fx, real *fy, real *fz, int n) {
+        _Potential::_computeForceBatch(pot, dx, dy, dz, fx, fy, fz, n);
+      }
+    };
+
+    template < class _Potential >
+    struct PairForceBatch< _Potential, false > {
+      static void compute(const _Potential *const *pot,
+                          const Particle &p1, const Particle *const *p2,
+                          const real *dx, const real *dy, const real *dz,
+                          real *fx, real *fy, real *fz, int n) {
+        for (int k = 0; k < n; ++k) {
+          Real3D force(0.0, 0.0, 0.0);
+          PairForce< _Potential, false >::compute(*pot[k], force, p1, *p2[k],
+                                                  Real3D(dx[k], dy[k], dz[k]));
+          fx[k] = force[0];
+          fy[k] = force[1];
+          fz[k] = force[2];
+        }
+      }
+    };
+
     //////////////////////////////////////////////////
     // INLINE IMPLEMENTATION
     //////////////////////////////////////////////////
@@ -310,6 +386,21 @@ namespace espressopp {
       return _computeForce(force, dist);
     }
 
+    template < class Derived >
+    inline void
+    PotentialTemplate< Derived >::
+    _computeForceBatch(const Derived *const *pot,
+                       const real *dx, const real *dy, const real *dz,
+                       real *fx, real *fy, real *fz, int n) {
+      for (int k = 0; k < n; ++k) {
+        Real3D force(0.0, 0.0, 0.0);
+        pot[k]->_computeForce(force, Real3D(dx[k], dy[k], dz[k]));
+        fx[k] = force[0];
+        fy[k] = force[1];
+        fz[k] = force[2];
+      }
+    }
+
     template < class Derived > 
     inline bool
     PotentialTemplate< Derived >::
@@ -241,6 +241,12 @@ namespace espressopp {
           }
         };
 
+        // the force depends on particle properties
+        template <>
+        struct PotentialTraits< ReactionFieldGeneralized > {
+          enum { distanceOnly = 0, threadSafe = 1 };
+        };
+
     }
 }
 
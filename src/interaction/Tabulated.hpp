@@ -98,6 +98,27 @@ namespace espressopp {
                 }*/
             }
          
+            static void _computeForceBatch(const Tabulated *const *pot,
+                                           const real *dx, const real *dy, const real *dz,
+                                           real *fx, real *fy, real *fz, int n) {
+                // distances of the whole batch first, then the table lookups
+                real distSqr[pairBatchSize], r[pairBatchSize];
+                for (int k = 0; k < n; ++k) {
+                    distSqr[k] = dx[k] * dx[k] + dy[k] * dy[k] + dz[k] * dz[k];
+                    r[k] = sqrt(distSqr[k]);
+                }
+                for (int k = 0; k < n; ++k) {
+                    const Tabulated &p = *pot[k];
+                    real ffactor = 0.0;
+                    if (p.interpolationType != 0 && distSqr[k] <= p.cutoffSqr) {
+                        ffactor = p.table->getForce(r[k]) / r[k];
+                    }
+                    fx[k] = dx[k] * ffactor;
+                    fy[k] = dy[k] * ffactor;
+                    fz[k] = dz[k] * ffactor;
+                }
+            }
+
             bool _computeForceRaw(Real3D& force, const Real3D& dist, real distSqr) const {
                 real ffactor;
                 if (interpolationType!=0){ 
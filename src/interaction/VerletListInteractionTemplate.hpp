@@ -29,12 +29,16 @@
 
 #include "types.hpp"
 #include "Interaction.hpp"
+#include "Potential.hpp"
+#include "PairExtension.hpp"
 #include "Real3D.hpp"
 #include "Tensor.hpp"
 #include "Particle.hpp"
 #include "VerletList.hpp"
 #include "esutil/Array2D.hpp"
+#include "esutil/Threads.hpp"
 #include "bc/BC.hpp"
+#include "System.hpp"
 
 #include "storage/Storage.hpp"
 
@@ -49,7 +53,7 @@ namespace espressopp {
     public:
       VerletListInteractionTemplate
           (shared_ptr<VerletList> _verletList)
-          : verletList(_verletList) {
+          : verletList(_verletList), interiorDone(false) {
     	  potentialArray    = esutil::Array2D<Potential, esutil::enlarge>(0, 0, Potential());
         ntypes = 0;
       }
@@ -82,6 +86,16 @@ namespace espressopp {
         return potentialArray.at(type1, type2);
       }
 
+      // as getPotential(), but without enlarging the array, so that it
+      // can be used by several threads: types beyond the array have the
+      // default potential, as they would get by enlarging
+      const Potential &findPotential(int type1, int type2) const {
+        if (size_t(type1) < potentialArray.size_n() && size_t(type2) < potentialArray.size_m()) {
+          return potentialArray(type1, type2);
+        }
+        return defaultPotential;
+      }
+
       // this is mainly used to access the potential from Python (e.g. to change parameters of the potential)
       shared_ptr<Potential> getPotentialPtr(int type1, int type2) {
     	return  make_shared<Potential>(potentialArray.at(type1, type2));
@@ -89,6 +103,8 @@ namespace espressopp {
 
 
       virtual void addForces();
+      virtual void addForcesInterior();
+      virtual void addForcesBoundary();
       virtual real computeEnergy();
       virtual real computeEnergyAA();
       virtual real computeEnergyCG();      
@@ -100,10 +116,32 @@ namespace espressopp {
       virtual real getMaxCutoff();
       virtual int bondType() { return Nonbonded; }
 
+      virtual bool setPairExtension(shared_ptr< PairExtension > ext) {
+        pairExtension = ext;
+        return true;
+      }
+
+      virtual shared_ptr< VerletList > getPairExtensionList() { return verletList; }
+
     protected:
+      /** addForces on the compressed Verlet list and the particle arrays,
+          for the neighbors k of particle i with begin[i] <= k < end[i] */
+      void addForcesCompressed(const longint *begin, const longint *end);
+
+      /// number of threads for the loops, 1 if the potential or the
+      /// pair extension is not thread safe
+      int numThreads() {
+        return PotentialTraits< Potential >::threadSafe &&
+          (!pairExtension || pairExtension->isThreadSafe()) ?
+          verletList->getSystemRef().getNumThreads() : 1;
+      }
+
       int ntypes;
       shared_ptr<VerletList> verletList;
+      shared_ptr<PairExtension> pairExtension;  // evaluated along with the potential
+      bool interiorDone;  // addForcesInterior() did the pairs without ghosts
       esutil::Array2D<Potential, esutil::enlarge> potentialArray;
+      Potential defaultPotential;  // of the type pairs without one
       // not needed esutil::Array2D<shared_ptr<Potential>, esutil::enlarge> potentialArrayPtr;
     };
 
@@ -115,6 +153,15 @@ namespace espressopp {
     addForces() {
       LOG4ESPP_DEBUG(_Potential::theLogger, "loop over verlet list pairs and add forces");
 
+      PairExtension *ext = pairExtension.get();
+      if (ext) ext->beginPairs();
+
+      if (verletList->isCompressed()) {
+        const longint *offset = &verletList->getNeighborOffsets()[0];
+        addForcesCompressed(offset, offset + 1);
+        return;
+      }
+
       for (PairList::Iterator it(verletList->getPairs()); it.isValid(); ++it) {
         Particle &p1 = *it->first;
         Particle &p2 = *it->second;
@@ -124,7 +171,12 @@ namespace espressopp {
         // shared_ptr<Potential> potential = getPotential(type1, type2);
 
         Real3D force(0.0);
-        if(potential._computeForce(force, p1, p2)) {
+        bool hasForce = potential._computeForce(force, p1, p2);
+        if (ext) {
+          ext->addPairForce(force, p1, p2, p1.position() - p2.position());
+          hasForce = true;
+        }
+        if(hasForce) {
         //if(potential->_computeForce(force, p1, p2)) {
           p1.force() += force;
           p2.force() -= force;
@@ -133,27 +185,150 @@ namespace espressopp {
       }
     }
     
+    template < typename _Potential > inline void
+    VerletListInteractionTemplate < _Potential >::
+    addForcesInterior() {
+      // the ghost positions are not valid yet, so the list must not be
+      // rebuilt here
+      interiorDone = verletList->isCompressedCurrent();
+      if (interiorDone) {
+        LOG4ESPP_DEBUG(_Potential::theLogger, "add forces of pairs without ghosts");
+        if (pairExtension) pairExtension->beginPairs();
+        addForcesCompressed(&verletList->getNeighborOffsets()[0],
+                            &verletList->getGhostNeighborOffsets()[0]);
+      }
+    }
+
+    template < typename _Potential > inline void
+    VerletListInteractionTemplate < _Potential >::
+    addForcesBoundary() {
+      if (!interiorDone) {
+        addForces();
+        return;
+      }
+      LOG4ESPP_DEBUG(_Potential::theLogger, "add forces of pairs with ghosts");
+      interiorDone = false;
+      addForcesCompressed(&verletList->getGhostNeighborOffsets()[0],
+                          &verletList->getNeighborOffsets()[0] + 1);
+    }
+
+    template < typename _Potential > inline void
+    VerletListInteractionTemplate < _Potential >::
+    addForcesCompressed(const longint *begin, const longint *end) {
+      storage::ParticleArrays &pa = verletList->getSystem()->storage->getParticleArrays();
+      if (pa.size() == 0) return;
+
+      const int *neighbor = verletList->getNeighborIndices().empty() ?
+        0 : &verletList->getNeighborIndices()[0];
+      const Real3D *pos = &pa.position[0];
+      const int *type = &pa.type[0];
+      const longint n = pa.size();
+      PairExtension *ext = pairExtension.get();
+
+      // enlarge the potential array to all present types beforehand, so
+      // that it does not move while the loop holds pointers into it
+      getPotential(pa.getMaxType(), pa.getMaxType());
+
+      // with several threads, each one accumulates into its own force
+      // buffer, which are summed up afterwards
+      const int nThreads = numThreads();
+      if (nThreads > 1) pa.prepareThreadForces(nThreads);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nThreads) if (nThreads > 1)
+#endif
+      {
+        Real3D *f = nThreads > 1 ?
+          pa.getThreadForce(esutil::threadNum()) : &pa.force[0];
+
+        // the neighbors of i are handed to the potential in batches
+        const Potential *pot[pairBatchSize];
+        const Particle *pj[pairBatchSize];
+        real dx[pairBatchSize], dy[pairBatchSize], dz[pairBatchSize];
+        real fx[pairBatchSize], fy[pairBatchSize], fz[pairBatchSize];
+
+        // i outer, j inner: the force on i is summed up locally and
+        // written once
+#ifdef _OPENMP
+#pragma omp for schedule(static, 64)
+#endif
+        for (longint i = 0; i < n; ++i) {
+          const Real3D pi = pos[i];
+          const int typei = type[i];
+          Real3D fi(0.0, 0.0, 0.0);
+
+          for (longint k = begin[i], kend = end[i]; k < kend; k += pairBatchSize) {
+            const int nb = std::min(longint(pairBatchSize), kend - k);
+
+            // gather
+            for (int b = 0; b < nb; ++b) {
+              const int j = neighbor[k + b];
+              pot[b] = &getPotential(typei, type[j]);
+              if (!PotentialTraits< Potential >::distanceOnly) pj[b] = pa.particle[j];
+              dx[b] = pi[0] - pos[j][0];
+              dy[b] = pi[1] - pos[j][1];
+              dz[b] = pi[2] - pos[j][2];
+            }
+
+            PairForceBatch< Potential >::compute(pot, *pa.particle[i], pj,
+                                                 dx, dy, dz, fx, fy, fz, nb);
+
+            // scatter, the pair extension is evaluated while the pair
+            // is at hand
+            for (int b = 0; b < nb; ++b) {
+              Real3D force(fx[b], fy[b], fz[b]);
+              if (ext) {
+                ext->addPairForce(force, *pa.particle[i], *pa.particle[neighbor[k + b]],
+                                  Real3D(dx[b], dy[b], dz[b]));
+              }
+              fi += force;
+              f[neighbor[k + b]] -= force;
+            }
+          }
+
+          f[i] += fi;
+        }
+      }
+
+      if (nThreads > 1) pa.sumThreadForces(nThreads);
+      pa.addForcesToParticles();
+    }
+
     template < typename _Potential >
     inline real
     VerletListInteractionTemplate < _Potential >::
     computeEnergy() {
       LOG4ESPP_DEBUG(_Potential::theLogger, "loop over verlet list pairs and sum up potential energies");
 
-      real e = 0.0;
-      real es = 0.0;
-      for (PairList::Iterator it(verletList->getPairs()); it.isValid(); ++it) {
-        Particle &p1 = *it->first;
-        Particle &p2 = *it->second;
-        int type1 = p1.type();
-        int type2 = p2.type();
-        const Potential &potential = getPotential(type1, type2);
-        // shared_ptr<Potential> potential = getPotential(type1, type2);
-        e   = potential._computeEnergy(p1, p2);
-        // e   = potential->_computeEnergy(p1, p2);
-        es += e;
-        LOG4ESPP_TRACE(_Potential::theLogger, "id1=" << p1.id() << " id2=" << p2.id() << " potential energy=" << e);
+      PairList &pairs = verletList->getPairs();
+      const longint npairs = pairs.size();
+
+      // per thread sums, added up in a fixed order
+      const int nThreads = numThreads();
+      std::vector< real > ethread(nThreads, 0.0);
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nThreads) if (nThreads > 1)
+#endif
+      {
+        real es = 0.0;
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (longint k = 0; k < npairs; ++k) {
+          Particle &p1 = *pairs[k].first;
+          Particle &p2 = *pairs[k].second;
+          int type1 = p1.type();
+          int type2 = p2.type();
+          const Potential &potential = findPotential(type1, type2);
+          es += potential._computeEnergy(p1, p2);
+        }
+        ethread[esutil::threadNum()] = es;
       }
 
+      real es = 0.0;
+      for (int t = 0; t < nThreads; ++t) es += ethread[t];
+
       // reduce over all CPUs
       real esum;
       boost::mpi::all_reduce(*getVerletList()->getSystem()->comm, es, esum, std::plus<real>());
@@ -215,23 +390,38 @@ namespace espressopp {
     computeVirialTensor(Tensor& w) {
       LOG4ESPP_DEBUG(_Potential::theLogger, "loop over verlet list pairs and sum up virial tensor");
 
-      Tensor wlocal(0.0);
-      for (PairList::Iterator it(verletList->getPairs());
-           it.isValid(); ++it) {
-        Particle &p1 = *it->first;
-        Particle &p2 = *it->second;
-        int type1 = p1.type();
-        int type2 = p2.type();
-        const Potential &potential = getPotential(type1, type2);
-        // shared_ptr<Potential> potential = getPotential(type1, type2);
+      PairList &pairs = verletList->getPairs();
+      const longint npairs = pairs.size();
 
-        Real3D force(0.0, 0.0, 0.0);
-        if(potential._computeForce(force, p1, p2)) {
-        // if(potential->_computeForce(force, p1, p2)) {
-          Real3D r21 = p1.position() - p2.position();
-          wlocal += Tensor(r21, force);
+      const int nThreads = numThreads();
+      std::vector< Tensor > wthread(nThreads, Tensor(0.0));
+
+#ifdef _OPENMP
+#pragma omp parallel num_threads(nThreads) if (nThreads > 1)
+#endif
+      {
+        Tensor wt(0.0);
+#ifdef _OPENMP
+#pragma omp for schedule(static)
+#endif
+        for (longint k = 0; k < npairs; ++k) {
+          Particle &p1 = *pairs[k].first;
+          Particle &p2 = *pairs[k].second;
+          int type1 = p1.type();
+          int type2 = p2.type();
+          const Potential &potential = findPotential(type1, type2);
+
+          Real3D force(0.0, 0.0, 0.0);
+          if(potential._computeForce(force, p1, p2)) {
+            Real3D r21 = p1.position() - p2.position();
+            wt += Tensor(r21, force);
+          }
         }
+        wthread[esutil::threadNum()] = wt;
       }
+
+      Tensor wlocal(0.0);
+      for (int t = 0; t < nThreads; ++t) wlocal += wthread[t];
       
       // reduce over all CPUs
       Tensor wsum(0.0);
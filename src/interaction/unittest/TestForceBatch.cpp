@@ -0,0 +1,89 @@
+/*
+  Copyright (C) 2012,2013
+      Max Planck Institute for Polymer Research
+  Copyright (C) 2008,2009,2010,2011
+      Max-Planck-Institute for Polymer Research & Fraunhofer SCAI
+  
+  This file is part of ESPResSo++.
+  
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>. 
+*/
+
+#define BOOST_TEST_MODULE ForceBatch
+#include "ut.hpp"
+#include "interaction/LennardJones.hpp"
+#include "interaction/LJcos.hpp"
+#include "interaction/Morse.hpp"
+#include "interaction/SoftCosine.hpp"
+
+using namespace espressopp;
+using namespace interaction;
+
+// distances inside and beyond the cutoffs, and across the LJcos border
+static const real dists[] = { 0.9, 1.0, 1.05, 1.12, 1.2, 1.45, 1.6, 2.2, 2.6, 3.5 };
+static const int nDists = sizeof(dists) / sizeof(dists[0]);
+
+// compares _computeForceBatch with _computeForce for pairs alternating
+// between the two potentials, for a full and a partial batch
+template < class _Potential >
+static void checkForceBatch(const _Potential &pot1, const _Potential &pot2)
+{
+  for (int n = pairBatchSize; n > 0; n -= pairBatchSize / 2 + 1) {
+    for (int start = 0; start + n <= nDists; ++start) {
+      const _Potential *pot[pairBatchSize];
+      real dx[pairBatchSize], dy[pairBatchSize], dz[pairBatchSize];
+      real fx[pairBatchSize], fy[pairBatchSize], fz[pairBatchSize];
+      for (int k = 0; k < n; ++k) {
+        pot[k] = k % 2 ? &pot2 : &pot1;
+        // spread the distance over all components
+        real d = dists[start + k];
+        dx[k] = 0.6 * d;
+        dy[k] = -0.48 * d;
+        dz[k] = 0.64 * d;
+      }
+
+      _Potential::_computeForceBatch(pot, dx, dy, dz, fx, fy, fz, n);
+
+      for (int k = 0; k < n; ++k) {
+        Real3D f(0.0, 0.0, 0.0);
+        pot[k]->_computeForce(f, Real3D(dx[k], dy[k], dz[k]));
+        BOOST_CHECK_SMALL(fx[k] - f[0], 1e-10 * (1.0 + fabs(f[0])));
+        BOOST_CHECK_SMALL(fy[k] - f[1], 1e-10 * (1.0 + fabs(f[1])));
+        BOOST_CHECK_SMALL(fz[k] - f[2], 1e-10 * (1.0 + fabs(f[2])));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE(LJBatch)
+{
+  checkForceBatch(LennardJones(1.0, 1.0, 2.5), LennardJones(0.5, 1.1, 1.5));
+}
+
+BOOST_AUTO_TEST_CASE(LJcosBatch)
+{
+  // the default constructed potential is the empty one
+  checkForceBatch(LJcos(0.5), LJcos());
+}
+
+BOOST_AUTO_TEST_CASE(MorseBatch)
+{
+  checkForceBatch(Morse(1.0, 1.0, 1.1, 2.5), Morse(2.0, 1.5, 1.0, 1.5));
+}
+
+BOOST_AUTO_TEST_CASE(DefaultBatch)
+{
+  // SoftCosine has no kernel of its own and uses the per pair loop
+  checkForceBatch(SoftCosine(1.0, 2.5), SoftCosine(2.0, 1.5));
+}
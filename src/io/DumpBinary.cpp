@@ -0,0 +1,267 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "python.hpp"
+#include <cstring>
+#include "DumpBinary.hpp"
+#include "storage/Storage.hpp"
+#include "iterator/CellListIterator.hpp"
+#include "bc/BC.hpp"
+#include "esutil/Error.hpp"
+
+using namespace espressopp;
+using namespace espressopp::iterator;
+using namespace std;
+
+namespace espressopp {
+  namespace io {
+
+    namespace {
+      const char MAGIC[8] = { 'E', 'S', 'P', 'P', 'T', 'R', 'J', '\0' };
+      const int VERSION = 1;
+    }
+
+    DumpBinary::DumpBinary(shared_ptr<System> system,
+                           shared_ptr<integrator::MDIntegrator> _integrator,
+                           std::string _file_name,
+                           bool _unfolded,
+                           bool _velocities,
+                           bool _forces,
+                           bool _single,
+                           bool _nonblocking,
+                           bool _append) :
+                        ParticleAccess(system),
+                        integrator(_integrator),
+                        file_name(_file_name),
+                        unfolded(_unfolded),
+                        velocities(_velocities),
+                        forces(_forces),
+                        single(_single),
+                        nonblocking(_nonblocking),
+                        offset(0),
+                        numFrames(0) {
+      if (system->comm->rank() == 0 && !_append)
+        FileBackup backup(file_name);
+      system->comm->barrier();
+      open(_append);
+    }
+
+    DumpBinary::~DumpBinary() {
+      int finalized;
+      MPI_Finalized(&finalized);
+      if (!finalized) {
+        wait();
+        MPI_File_close(&file);
+      }
+    }
+
+    int DumpBinary::flags() const {
+      return (single ? SINGLE_PRECISION : 0) | (velocities ? HAS_VELOCITY : 0) |
+             (forces ? HAS_FORCE : 0) | (unfolded ? UNFOLDED : 0);
+    }
+
+    /* The file header is: magic[8], version, flags, headerSize,
+       frameHeaderSize (int32 each) and 8 reserved bytes. When appending
+       to an existing file its header has to match the settings. */
+    void DumpBinary::open(bool append) {
+      shared_ptr< mpi::communicator > comm = getSystem()->comm;
+      esutil::Error err(comm);
+
+      if (MPI_File_open(static_cast< MPI_Comm >(*comm),
+                        const_cast< char* >(file_name.c_str()),
+                        MPI_MODE_CREATE | MPI_MODE_RDWR, MPI_INFO_NULL,
+                        &file) != MPI_SUCCESS) {
+        err.setException("DumpBinary: unable to open file " + file_name);
+      }
+      err.checkException();
+
+      MPI_Offset size;
+      MPI_File_get_size(file, &size);
+
+      char header[headerSize];
+      memset(header, 0, headerSize);
+      memcpy(header, MAGIC, sizeof(MAGIC));
+      int info[4] = { VERSION, flags(), headerSize, frameHeaderSize };
+      memcpy(header + sizeof(MAGIC), info, sizeof(info));
+
+      if (size == 0) {
+        if (comm->rank() == 0)
+          MPI_File_write_at(file, 0, header, headerSize, MPI_BYTE, MPI_STATUS_IGNORE);
+        offset = headerSize;
+      } else {
+        char existing[headerSize];
+        MPI_File_read_at_all(file, 0, existing, headerSize, MPI_BYTE, MPI_STATUS_IGNORE);
+        if (size < headerSize || memcmp(existing, header, sizeof(MAGIC) + sizeof(info)) != 0) {
+          err.setException("DumpBinary: " + file_name +
+                           " is no trajectory with the same settings, can not append");
+        }
+        offset = size;
+      }
+      err.checkException();
+    }
+
+    void DumpBinary::wait() {
+      if (!requests.empty()) {
+        MPI_Waitall(requests.size(), &requests[0], MPI_STATUSES_IGNORE);
+        requests.clear();
+      }
+    }
+
+    void DumpBinary::flush() {
+      wait();
+      MPI_File_sync(file);
+    }
+
+    void DumpBinary::write(MPI_Offset at, void *buf, int count, MPI_Datatype type) {
+      if (nonblocking) {
+        if (count > 0) {
+          requests.push_back(MPI_REQUEST_NULL);
+          MPI_File_iwrite_at(file, at, buf, count, type, &requests.back());
+        }
+      } else {
+        // every CPU takes part in the collective write, also without data
+        MPI_File_write_at_all(file, at, count > 0 ? buf : frameHeader, count,
+                              type, MPI_STATUS_IGNORE);
+      }
+    }
+
+    template< typename T >
+    void DumpBinary::pack() {
+      System& system = getSystemRef();
+      int myN = system.storage->getNRealParticles();
+
+      idBuf.resize(myN);
+      vecBuf[0].resize(3 * myN * sizeof(T));
+      vecBuf[1].resize(velocities ? 3 * myN * sizeof(T) : 0);
+      vecBuf[2].resize(forces ? 3 * myN * sizeof(T) : 0);
+      if (myN == 0) return;
+
+      T *pos = reinterpret_cast< T* >(&vecBuf[0][0]);
+      T *vel = velocities ? reinterpret_cast< T* >(&vecBuf[1][0]) : 0;
+      T *force = forces ? reinterpret_cast< T* >(&vecBuf[2][0]) : 0;
+
+      Real3D L = system.bc->getBoxL();
+      CellList realCells = system.storage->getRealCells();
+      int i = 0;
+      for (CellListIterator cit(realCells); !cit.isDone(); ++cit, ++i) {
+        idBuf[i] = cit->id();
+
+        const Real3D& p = cit->position();
+        if (unfolded) {
+          const Int3D& img = cit->image();
+          for (int k = 0; k < 3; ++k) pos[3*i + k] = T(p[k] + img[k] * L[k]);
+        } else {
+          for (int k = 0; k < 3; ++k) pos[3*i + k] = T(p[k]);
+        }
+        if (vel) {
+          const Real3D& v = cit->velocity();
+          for (int k = 0; k < 3; ++k) vel[3*i + k] = T(v[k]);
+        }
+        if (force) {
+          const Real3D& f = cit->force();
+          for (int k = 0; k < 3; ++k) force[3*i + k] = T(f[k]);
+        }
+      }
+    }
+
+    /* Every CPU writes its particles at the position given by the
+       number of particles on the CPUs with lower rank. The frame header
+       (step, time, box[3], N) is written by rank 0. */
+    void DumpBinary::dump() {
+      System& system = getSystemRef();
+
+      // the buffers of the last frame are reused
+      wait();
+
+      long long myN = system.storage->getNRealParticles();
+      long long first = 0;
+      long long totalN;
+      MPI_Exscan(&myN, &first, 1, MPI_LONG_LONG, MPI_SUM,
+                 static_cast< MPI_Comm >(*system.comm));
+      if (system.comm->rank() == 0) first = 0;
+      boost::mpi::all_reduce(*system.comm, myN, totalN, std::plus<long long>());
+
+      if (single) pack<float>();
+      else pack<double>();
+
+      if (system.comm->rank() == 0) {
+        long long step = integrator->getStep();
+        double data[4];
+        data[0] = step * integrator->getTimeStep();
+        Real3D L = system.bc->getBoxL();
+        for (int k = 0; k < 3; ++k) data[k + 1] = L[k];
+        memcpy(frameHeader, &step, 8);
+        memcpy(frameHeader + 8, data, 32);
+        memcpy(frameHeader + 40, &totalN, 8);
+        if (nonblocking) {
+          requests.push_back(MPI_REQUEST_NULL);
+          MPI_File_iwrite_at(file, offset, frameHeader, frameHeaderSize, MPI_BYTE,
+                             &requests.back());
+        } else {
+          MPI_File_write_at(file, offset, frameHeader, frameHeaderSize, MPI_BYTE,
+                            MPI_STATUS_IGNORE);
+        }
+      }
+
+      MPI_Offset at = offset + frameHeaderSize;
+      write(at + first * 8, idBuf.empty() ? 0 : &idBuf[0], myN, MPI_LONG_LONG);
+      at += totalN * 8;
+
+      MPI_Offset es = single ? sizeof(float) : sizeof(double);
+      MPI_Datatype type = single ? MPI_FLOAT : MPI_DOUBLE;
+      for (int k = 0; k < 3; ++k) {
+        if ((k == 1 && !velocities) || (k == 2 && !forces)) continue;
+        write(at + first * 3 * es, vecBuf[k].empty() ? 0 : &vecBuf[k][0], 3 * myN, type);
+        at += totalN * 3 * es;
+      }
+
+      offset = at;
+      ++numFrames;
+    }
+
+    // Python wrapping
+    void DumpBinary::registerPython() {
+
+      using namespace espressopp::python;
+
+      class_<DumpBinary, bases<ParticleAccess>, boost::noncopyable >
+      ("io_DumpBinary", init< shared_ptr< System >,
+                              shared_ptr< integrator::MDIntegrator >,
+                              std::string,
+                              bool,
+                              bool,
+                              bool,
+                              bool,
+                              bool,
+                              bool>())
+        .add_property("filename", &DumpBinary::getFilename)
+        .add_property("unfolded", &DumpBinary::getUnfolded)
+        .add_property("velocities", &DumpBinary::getVelocities)
+        .add_property("forces", &DumpBinary::getForces)
+        .add_property("single", &DumpBinary::getSingle)
+        .add_property("nonblocking", &DumpBinary::getNonblocking,
+                                     &DumpBinary::setNonblocking)
+        .add_property("num_frames", &DumpBinary::getNumFrames)
+        .def("dump", &DumpBinary::dump)
+        .def("flush", &DumpBinary::flush)
+      ;
+    }
+  }
+}
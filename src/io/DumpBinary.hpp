@@ -0,0 +1,137 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// ESPP_CLASS
+#ifndef _IO_DUMPBINARY_HPP
+#define _IO_DUMPBINARY_HPP
+
+#include "mpi.h"
+#include "integrator/MDIntegrator.hpp"
+#include "io/FileBackup.hpp"
+
+#include <string>
+#include <vector>
+#include "ParticleAccess.hpp"
+
+namespace espressopp {
+  namespace io{
+
+    /** Parallel binary trajectory writer.
+
+        Unlike DumpXYZ and DumpGRO the configuration is not gathered on
+        rank 0: every CPU writes the particles it owns directly into its
+        slice of the file with MPI-IO. The file starts with a header of
+        headerSize bytes, followed by the frames. A frame consists of a
+        header of frameHeaderSize bytes and of the blocks
+
+          id[N] (int64), pos[N][3], vel[N][3], force[N][3]
+
+        where vel and force are only present if they were requested and
+        the vectors are stored in single or double precision. Within the
+        blocks the particles are ordered by CPU, not by id. All numbers
+        are stored in the byte order of the machine that writes them.
+
+        With nonblocking the writes of a frame are only started by dump()
+        and completed at the beginning of the next dump(), by flush() or
+        when the writer is destroyed, so that they overlap with the
+        integration. Otherwise every block is written collectively.
+    */
+    class DumpBinary : public ParticleAccess {
+
+    public:
+
+      /** flags in the file header */
+      enum {
+        SINGLE_PRECISION = 1,
+        HAS_VELOCITY = 2,
+        HAS_FORCE = 4,
+        UNFOLDED = 8
+      };
+
+      static const int headerSize = 32;
+      static const int frameHeaderSize = 48;
+
+      DumpBinary(shared_ptr<System> system,
+                 shared_ptr<integrator::MDIntegrator> _integrator,
+                 std::string _file_name,
+                 bool _unfolded,
+                 bool _velocities,
+                 bool _forces,
+                 bool _single,
+                 bool _nonblocking,
+                 bool _append);
+      ~DumpBinary();
+
+      void perform_action(){
+        dump();
+      }
+
+      /** writes the current configuration as a new frame */
+      void dump();
+
+      /** waits until the last frame has been written and flushes the file */
+      void flush();
+
+      std::string getFilename(){return file_name;}
+      bool getUnfolded(){return unfolded;}
+      bool getVelocities(){return velocities;}
+      bool getForces(){return forces;}
+      bool getSingle(){return single;}
+      bool getNonblocking(){return nonblocking;}
+      void setNonblocking(bool v){wait(); nonblocking = v;}
+      longint getNumFrames(){return numFrames;}
+
+      static void registerPython();
+
+    private:
+
+      // integrator we need to know an integration step
+      shared_ptr<integrator::MDIntegrator> integrator;
+
+      std::string file_name;
+
+      bool unfolded;
+      bool velocities;
+      bool forces;
+      bool single;
+      bool nonblocking;
+
+      MPI_File file;
+      MPI_Offset offset;   // end of the last frame, same on all CPUs
+      longint numFrames;
+
+      // local data of a frame, must stay alive until the writes are done
+      std::vector<long long> idBuf;
+      std::vector<char> vecBuf[3];
+      char frameHeader[frameHeaderSize];
+      std::vector<MPI_Request> requests;
+
+      int flags() const;
+      void open(bool append);
+      void wait();
+      void write(MPI_Offset at, void *buf, int count, MPI_Datatype type);
+
+      template< typename T >
+      void pack();
+    };
+  }
+}
+
+#endif
@@ -0,0 +1,140 @@
+#  Copyright (C) 2015
+#      Max Planck Institute for Polymer Research
+#
+#  This file is part of ESPResSo++.
+#
+#  ESPResSo++ is free software: you can redistribute it and/or modify
+#  it under the terms of the GNU General Public License as published by
+#  the Free Software Foundation, either version 3 of the License, or
+#  (at your option) any later version.
+#
+#  ESPResSo++ is distributed in the hope that it will be useful,
+#  but WITHOUT ANY WARRANTY; without even the implied warranty of
+#  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+#  GNU General Public License for more details.
+#
+#  You should have received a copy of the GNU General Public License
+#  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+r"""
+*********************************************
+**DumpBinary** - IO Object
+*********************************************
+
+Parallel binary trajectory writer. In contrast to DumpXYZ and DumpGRO the
+configuration is not collected on one CPU, every CPU writes its own
+particles into the file with MPI-IO.
+
+* `dump()`
+  append the current configuration as a new frame
+
+* `flush()`
+  wait until all frames are written and flush the file
+
+  Properties
+
+* `filename`
+  Name of trajectory file. By default "out.trj"
+
+* `unfolded`
+  False if coordinates are folded, True if unfolded. By default - False
+
+* `velocities`, `forces`
+  write velocities and forces as well. By default - False
+
+* `single`
+  store positions, velocities and forces in single precision. By default - False
+
+* `nonblocking`
+  if True, `dump()` only starts writing the frame and returns, the writes
+  complete at the next `dump()`, `flush()` or when the object is deleted.
+  Otherwise the frame is written collectively before `dump()` returns. By default - True
+
+* `append`
+  True if new frames are appended to an existing trajectory file written
+  with the same settings. By default - False
+
+* `num_frames`
+  number of frames written by this object (read only)
+
+File layout (byte order of the writing machine)::
+
+  header (32 bytes): magic 'ESPPTRJ\0', int32 version, int32 flags
+                     (1 single, 2 velocities, 4 forces, 8 unfolded),
+                     int32 header size, int32 frame header size, 8 bytes reserved
+  per frame:         int64 step, float64 time, float64 box[3], int64 N,
+                     int64 id[N], pos[N][3], [vel[N][3]], [force[N][3]]
+
+The particles of a frame are ordered by CPU, not by id. A frame can be read
+with numpy, e.g. for double precision positions only
+
+>>> hdr = numpy.fromfile(f, dtype=[('step','i8'),('time','f8'),('box','3f8'),('N','i8')], count=1)[0]
+>>> ids = numpy.fromfile(f, dtype='i8', count=hdr['N'])
+>>> pos = numpy.fromfile(f, dtype='f8', count=3*hdr['N']).reshape(-1, 3)
+
+usage:
+
+>>> dump_trj = espressopp.io.DumpBinary(system, integrator, filename='trajectory.trj', velocities=True, single=True)
+>>> ext_analyze = espressopp.integrator.ExtAnalyze(dump_trj, 1000)
+>>> integrator.addExtension(ext_analyze)
+>>> integrator.run(100000)
+>>> dump_trj.flush()
+
+.. function:: espressopp.io.DumpBinary(system, integrator, filename, unfolded, velocities, forces, single, nonblocking, append)
+
+		:param system:
+		:param integrator:
+		:param filename: (default: 'out.trj')
+		:param unfolded: (default: False)
+		:param velocities: (default: False)
+		:param forces: (default: False)
+		:param single: (default: False)
+		:param nonblocking: (default: True)
+		:param append: (default: False)
+		:type system:
+		:type integrator:
+		:type filename:
+		:type unfolded: bool
+		:type velocities: bool
+		:type forces: bool
+		:type single: bool
+		:type nonblocking: bool
+		:type append: bool
+
+.. function:: espressopp.io.DumpBinary.dump()
+
+		:rtype:
+
+.. function:: espressopp.io.DumpBinary.flush()
+
+		:rtype:
+"""
+
+from espressopp.esutil import cxxinit
+from espressopp import pmi
+
+from espressopp.ParticleAccess import *
+from _espressopp import io_DumpBinary
+
+class DumpBinaryLocal(ParticleAccessLocal, io_DumpBinary):
+
+  def __init__(self, system, integrator, filename='out.trj', unfolded=False, velocities=False, forces=False, single=False, nonblocking=True, append=False):
+    cxxinit(self, io_DumpBinary, system, integrator, filename, unfolded, velocities, forces, single, nonblocking, append)
+
+  def dump(self):
+    if not (pmi._PMIComm and pmi._PMIComm.isActive()) or pmi._MPIcomm.rank in pmi._PMIComm.getMPIcpugroup():
+      self.cxxclass.dump(self)
+
+  def flush(self):
+    if not (pmi._PMIComm and pmi._PMIComm.isActive()) or pmi._MPIcomm.rank in pmi._PMIComm.getMPIcpugroup():
+      self.cxxclass.flush(self)
+
+
+if pmi.isController :
+  class DumpBinary(ParticleAccess):
+    __metaclass__ = pmi.Proxy
+    pmiproxydefs = dict(
+      cls =  'espressopp.io.DumpBinaryLocal',
+      pmicall = [ 'dump', 'flush' ],
+      pmiproperty = ['filename', 'unfolded', 'velocities', 'forces', 'single', 'nonblocking', 'num_frames']
+    )
@@ -23,5 +23,6 @@ from espressopp.esutil import pmiimport
 pmiimport('espressopp.io')
 
 from espressopp.io.DumpXYZ import *
+from espressopp.io.DumpBinary import *
 from espressopp.io.DumpGRO import *
 from espressopp.io.DumpGROAdress import *
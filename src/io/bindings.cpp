@@ -22,6 +22,7 @@
 
 #include "bindings.hpp"
 #include "DumpXYZ.hpp"
+#include "DumpBinary.hpp"
 #include "DumpGRO.hpp"
 #include "DumpGROAdress.hpp"
 #include "FileBackup.hpp"
@@ -30,6 +31,7 @@ namespace espressopp {
   namespace io{
     void registerPython() {
       DumpXYZ::registerPython();
+      DumpBinary::registerPython();
       DumpGRO::registerPython();
       DumpGROAdress::registerPython();
     }
@@ -39,6 +39,7 @@
 #include "esutil/Error.hpp"
 
 #include "boost/serialization/vector.hpp"
+#include <boost/cstdint.hpp>
 
 using namespace boost;
 using namespace std;
@@ -48,6 +49,8 @@ namespace espressopp {
 
 
   const int DD_COMM_TAG = 0xab;
+  // the nonblocking ghost update sends with DD_GHOST_TAG + direction
+  const int DD_GHOST_TAG = 0xb0;
 
   LOG4ESPP_LOGGER(DomainDecomposition::logger, "DomainDecomposition");
 
@@ -68,8 +71,11 @@ namespace espressopp {
   DomainDecomposition::
   DomainDecomposition(shared_ptr< System > _system,
           const Int3D& _nodeGrid,
-          const Int3D& _cellGrid)
-    : Storage(_system), exchangeBufferSize(0) {
+          const Int3D& _cellGrid,
+          bool useParticleArrays)
+    : Storage(_system), exchangeBufferSize(0), mortonOrder(false),
+      balanceInterval(0), balanceTolerance(1.1), fixedBoundaries(false), decomposeCount(0),
+      pendingGhostCoord(-1) {
     LOG4ESPP_INFO(logger, "node grid = "
           << _nodeGrid[0] << "x" << _nodeGrid[1] << "x" << _nodeGrid[2]
           << " cell grid = "
@@ -78,13 +84,14 @@ namespace espressopp {
     createCellGrid(_nodeGrid, _cellGrid);
     initCellInteractions();
     prepareGhostCommunication();
+    if (useParticleArrays) {
+      LOG4ESPP_INFO(logger, "keeping particle arrays for the force kernels");
+      particleArrays = make_shared< ParticleArrays >();
+    }
     LOG4ESPP_DEBUG(logger, "done");
   }
 
   void DomainDecomposition:: createCellGrid(const Int3D& _nodeGrid, const Int3D& _cellGrid) {
-    real myLeft[3];
-    real myRight[3];
-
     nodeGrid = NodeGrid(_nodeGrid, getSystem()->comm->rank(), getSystem()->bc->getBoxL());
 
     if (nodeGrid.getNumberOfCells() != getSystem()->comm->size()) {
@@ -105,6 +112,13 @@ namespace espressopp {
            << nodeGrid.getNodeNeighborIndex(4) << "<->"
            << nodeGrid.getNodeNeighborIndex(5));
 
+    createCells(_cellGrid);
+  }
+
+  void DomainDecomposition::createCells(const Int3D& _cellGrid) {
+    real myLeft[3];
+    real myRight[3];
+
     for (int i = 0; i < 3; ++i) {
       myLeft[i] = nodeGrid.getMyLeft(i);
       myRight[i] = nodeGrid.getMyRight(i);
@@ -130,6 +144,7 @@ namespace espressopp {
     ghostCells.reserve(nLocalCells - nRealCells);
 
     markCells();
+    orderCells();
 
     LOG4ESPP_DEBUG(logger, "total # cells=" << nLocalCells
            << ", # real cells=" << nRealCells
@@ -159,6 +174,119 @@ namespace espressopp {
     }
   }
 
+  namespace {
+    // spread the lowest 21 bits of x to every third bit
+    boost::uint64_t spreadBits(boost::uint64_t x) {
+      x &= 0x1fffff;
+      x = (x | x << 32) & UINT64_C(0x1f00000000ffff);
+      x = (x | x << 16) & UINT64_C(0x1f0000ff0000ff);
+      x = (x | x << 8)  & UINT64_C(0x100f00f00f00f00f);
+      x = (x | x << 4)  & UINT64_C(0x10c30c30c30c30c3);
+      x = (x | x << 2)  & UINT64_C(0x1249249249249249);
+      return x;
+    }
+
+    // position along the Morton curve
+    boost::uint64_t mortonKey(boost::uint64_t x, boost::uint64_t y, boost::uint64_t z) {
+      return spreadBits(x) | spreadBits(y) << 1 | spreadBits(z) << 2;
+    }
+
+    struct CompareCellKeys {
+      const Cell *firstCell;
+      const std::vector< boost::uint64_t > *keys;
+      bool operator()(const Cell *a, const Cell *b) const {
+        return (*keys)[a - firstCell] < (*keys)[b - firstCell];
+      }
+    };
+  }
+
+  void DomainDecomposition::setMortonOrder(bool order) {
+    mortonOrder = order;
+    orderCells();
+    // the particles are sorted within the cells with the next decompose
+  }
+
+  void DomainDecomposition::orderCells() {
+    if (mortonOrder) {
+      std::vector< boost::uint64_t > keys(cells.size());
+      for (size_t i = 0; i < cells.size(); ++i) {
+        int m, n, o;
+        cellGrid.mapIndexToPosition(m, n, o, i);
+        keys[i] = mortonKey(m, n, o);
+      }
+      CompareCellKeys byKey = { getFirstCell(), &keys };
+      std::sort(realCells.begin(), realCells.end(), byKey);
+      std::sort(ghostCells.begin(), ghostCells.end(), byKey);
+      std::sort(localCells.begin(), localCells.end(), byKey);
+    } else {
+      // lexicographic is the order of the cell array
+      std::sort(realCells.begin(), realCells.end());
+      std::sort(ghostCells.begin(), ghostCells.end());
+      std::sort(localCells.begin(), localCells.end());
+    }
+    rebuildParticleArrays();
+  }
+
+  /* The particles are sorted along the Morton curve of their positions,
+     discretized to 1024 steps per cell. Only the particles that change
+     their place are copied and reindexed. */
+  void DomainDecomposition::sortParticlesInCells() {
+    const boost::uint64_t maxQ = 0x1fffff;
+    real scale[3];
+    for (int i = 0; i < 3; ++i) {
+      scale[i] = 1024 * cellGrid.getInverseCellSize(i);
+    }
+
+    std::vector< std::pair< boost::uint64_t, size_t > > keys;
+    std::vector< Particle > tmp;
+    for (CellList::Iterator it(realCells); it.isValid(); ++it) {
+      ParticleList &pl = (*it)->particles;
+      size_t n = pl.size();
+      if (n < 2) continue;
+
+      keys.resize(n);
+      bool sorted = true;
+      for (size_t p = 0; p < n; ++p) {
+        boost::uint64_t q[3];
+        for (int i = 0; i < 3; ++i) {
+          real x = (pl[p].position()[i] - cellGrid.getMyLeft(i)) * scale[i];
+          q[i] = (x <= 0) ? 0 : std::min(boost::uint64_t(x), maxQ);
+        }
+        keys[p] = std::make_pair(mortonKey(q[0], q[1], q[2]), p);
+        if (p > 0 && keys[p] < keys[p - 1]) sorted = false;
+      }
+      if (sorted) continue;
+
+      std::sort(keys.begin(), keys.end());
+      tmp.assign(pl.begin(), pl.end());
+      for (size_t p = 0; p < n; ++p) {
+        if (keys[p].second != p) {
+          pl[p] = tmp[keys[p].second];
+          updateInLocalParticles(&pl[p]);
+        }
+      }
+    }
+  }
+
+  real DomainDecomposition::getOrderDistance() {
+    real sum = 0.0;
+    longint count = 0;
+    const Particle *last = 0;
+    for (iterator::CellListIterator cit(realCells); !cit.isDone(); ++cit) {
+      if (last) {
+        sum += (cit->position() - last->position()).abs();
+        ++count;
+      }
+      last = &(*cit);
+    }
+
+    real sumAll;
+    longint countAll;
+    mpi::all_reduce(*getSystem()->comm, sum, sumAll, std::plus<real>());
+    mpi::all_reduce(*getSystem()->comm, count, countAll, std::plus<longint>());
+    return (countAll > 0) ? sumAll / countAll : 0.0;
+  }
+
   // TODO one should take care of rc and system size
   /** scale position coordinates of all real particles by factor s */
   void DomainDecomposition::scaleVolume(real s, bool particleCoordinates){
@@ -234,16 +362,40 @@ namespace espressopp {
     Real3D box_sizeL = getSystem() -> bc -> getBoxL();
     real skinL = getSystem() -> getSkin();
     real maxCutoffL = getSystem() -> maxCutoff;
-            
-    // nodeGrid is already defined
-    Int3D _nodeGrid(nodeGrid.getGridSize());
-    // new cellGrid
+
+    // the node domains follow the box, which may leave a balanced domain
+    // narrower than a cell
+    esutil::Error err(getSystemRef().comm);
     real rc_skin = maxCutoffL + skinL;
-    int ix = (int)(box_sizeL[0] / (rc_skin * _nodeGrid[0]));
-    int iy = (int)(box_sizeL[1] / (rc_skin * _nodeGrid[1]));
-    int iz = (int)(box_sizeL[2] / (rc_skin * _nodeGrid[2]));
+    Real3D scale;
+    for (int i = 0; i < 3; ++i) {
+      scale[i] = box_sizeL[i] / nodeGrid.getBoundaries(i).back();
+      if (scale[i] * nodeGrid.getLocalBoxSize(i) < rc_skin) {
+        stringstream msg;
+        msg << "Error. The local box size " << scale[i] * nodeGrid.getLocalBoxSize(i)
+            << " in direction " << i << " is smaller than cutoff+skin " << rc_skin;
+        err.setException(msg.str());
+      }
+    }
+    err.checkException();
+    nodeGrid.scaleVolume(scale);
+
+    // new cellGrid
+    int ix = std::max(1, (int)(nodeGrid.getLocalBoxSize(0) / rc_skin));
+    int iy = std::max(1, (int)(nodeGrid.getLocalBoxSize(1) / rc_skin));
+    int iz = std::max(1, (int)(nodeGrid.getLocalBoxSize(2) / rc_skin));
     Int3D _newCellGrid(ix, iy, iz);
 
+    rebuildCells(_newCellGrid);
+
+    // like decompose(), so the particles are on their nodes afterwards
+    decomposeRealParticles();
+    exchangeGhosts();
+    rebuildParticleArrays();
+    onParticlesChanged();
+  }
+
+  void DomainDecomposition::rebuildCells(const Int3D& _newCellGrid){
     // save all particles to temporary vector
     std::vector<ParticleList> tmp_pl;
     size_t _N = realCells.size();
@@ -264,7 +416,7 @@ namespace espressopp {
     }
     
     // creating new grids
-    createCellGrid(_nodeGrid, _newCellGrid);
+    createCells(_newCellGrid);
     initCellInteractions();
     prepareGhostCommunication();
     
@@ -281,9 +433,132 @@ namespace espressopp {
     for(CellList::Iterator it(realCells); it.isValid(); ++it) {
       updateLocalParticles((*it)->particles);
     }
-    
+  }
+
+  void DomainDecomposition::setBalanceInterval(int interval) {
+    esutil::Error err(getSystemRef().comm);
+    if (interval > 0 && fixedBoundaries) {
+      err.setException("DomainDecomposition: the node boundaries are fixed, "
+                       "e.g. by LatticeBoltzmann, and cannot be balanced");
+    }
+    err.checkException();
+    balanceInterval = interval;
+  }
+
+  void DomainDecomposition::setFixedBoundaries(bool fixed) {
+    esutil::Error err(getSystemRef().comm);
+    if (fixed && balanceInterval > 0) {
+      err.setException("DomainDecomposition: the node boundaries cannot be "
+                       "fixed while the load is balanced, set balanceInterval to 0");
+    }
+    err.checkException();
+    fixedBoundaries = fixed;
+  }
+
+  real DomainDecomposition::getLoadImbalance() {
+    const mpi::communicator &comm = *getSystem()->comm;
+    longint n = getNRealParticles(), nMax, nSum;
+    mpi::all_reduce(comm, n, nMax, mpi::maximum<longint>());
+    mpi::all_reduce(comm, n, nSum, std::plus<longint>());
+    return (nSum > 0) ? real(nMax) * comm.size() / real(nSum) : 1.0;
+  }
+
+  /* The particles are binned along each axis into bins of a quarter of
+     the minimal domain width, and the boundaries are placed where the
+     cumulative number of particles reaches equal shares, interpolating
+     linearly within the bins. */
+  bool DomainDecomposition::balanceLoad() {
+    if (fixedBoundaries) return false;
+
+    System& system = getSystemRef();
+    const mpi::communicator &comm = *system.comm;
+    real minWidth = system.maxCutoff + system.getSkin();
+    Real3D box = system.bc->getBoxL();
+
+    int nBins[3], offset[4];
+    offset[0] = 0;
+    for (int i = 0; i < 3; ++i) {
+      nBins[i] = (nodeGrid.getGridSize(i) > 1) ? std::max(1, int(4 * box[i] / minWidth)) : 0;
+      offset[i + 1] = offset[i] + nBins[i];
+    }
+    if (offset[3] == 0) return false;
+
+    std::vector< longint > hist(offset[3], 0), total(offset[3]);
+    for (iterator::CellListIterator cit(realCells); !cit.isDone(); ++cit) {
+      const Real3D& pos = cit->position();
+      for (int i = 0; i < 3; ++i) {
+        if (nBins[i] == 0) continue;
+        int b = int(pos[i] / box[i] * nBins[i]);
+        hist[offset[i] + std::min(std::max(b, 0), nBins[i] - 1)]++;
+      }
+    }
+    mpi::all_reduce(comm, &hist[0], offset[3], &total[0], std::plus<longint>());
+
+    bool changed = false;
+    for (int i = 0; i < 3; ++i) {
+      int nNodes = nodeGrid.getGridSize(i);
+      if (nNodes == 1 || nNodes * minWidth > box[i]) continue;
+
+      longint n = 0;
+      for (int b = 0; b < nBins[i]; ++b) n += total[offset[i] + b];
+      if (n == 0) continue;
+
+      std::vector< real > bounds(nNodes + 1);
+      bounds[0] = 0.0;
+      bounds[nNodes] = box[i];
+
+      real binWidth = box[i] / nBins[i];
+      longint below = 0;
+      int b = 0;
+      for (int k = 1; k < nNodes; ++k) {
+        real share = real(n) * k / nNodes;
+        while (b < nBins[i] - 1 && below + total[offset[i] + b] < share) {
+          below += total[offset[i] + b++];
+        }
+        longint inBin = total[offset[i] + b];
+        real frac = (inBin > 0) ? (share - below) / inBin : 0.0;
+        bounds[k] = (b + std::min(std::max(frac, real(0.0)), real(1.0))) * binWidth;
+      }
+
+      // keep every domain at least minWidth wide
+      for (int k = 1; k < nNodes; ++k) {
+        bounds[k] = std::max(bounds[k], bounds[k - 1] + minWidth);
+      }
+      for (int k = nNodes - 1; k > 0; --k) {
+        bounds[k] = std::min(bounds[k], bounds[k + 1] - minWidth);
+      }
+
+      if (bounds != nodeGrid.getBoundaries(i)) {
+        nodeGrid.setBoundaries(i, bounds);
+        changed = true;
+      }
+    }
+    if (!changed) return false;
+
+    Int3D newCellGrid;
+    for (int i = 0; i < 3; ++i) {
+      newCellGrid[i] = std::max(1, int(nodeGrid.getLocalBoxSize(i) / minWidth));
+    }
+    LOG4ESPP_INFO(logger, "balanced local box "
+          << nodeGrid.getMyLeft(0) << "-" << nodeGrid.getMyRight(0) << ", "
+          << nodeGrid.getMyLeft(1) << "-" << nodeGrid.getMyRight(1) << ", "
+          << nodeGrid.getMyLeft(2) << "-" << nodeGrid.getMyRight(2));
+
+    // the particles outside the new domain are migrated like after moving
+    rebuildCells(newCellGrid);
+    decomposeRealParticles();
     exchangeGhosts();
+    rebuildParticleArrays();
     onParticlesChanged();
+    return true;
+  }
+
+  void DomainDecomposition::decompose() {
+    if (balanceInterval > 0 && ++decomposeCount % balanceInterval == 0 &&
+        getLoadImbalance() > balanceTolerance && balanceLoad()) {
+      return;
+    }
+    Storage::decompose();
   }
 
   void DomainDecomposition::initCellInteractions() {
@@ -534,6 +809,8 @@ namespace espressopp {
 
     LOG4ESPP_DEBUG(logger, "finished exchanging particles, new send/recv buffer size " << exchangeBufferSize);
 
+    if (mortonOrder) sortParticlesInCells();
+
     LOG4ESPP_DEBUG(logger, "done");
   }
 
@@ -546,6 +823,89 @@ namespace espressopp {
   void DomainDecomposition::updateGhosts() {
     LOG4ESPP_DEBUG(logger, "updateGhosts -> ghost communication no sizes, real->ghost");
     doGhostCommunication(false, true, dataOfUpdateGhosts);
+    if (particleArrays) {
+      particleArrays->reload();
+    }
+  }
+
+  void DomainDecomposition::beginUpdateGhosts() {
+    LOG4ESPP_DEBUG(logger, "beginUpdateGhosts -> posting ghost communication, real->ghost");
+    pendingGhostCoord = -1;
+    for (int coord = 0; coord < 3; ++coord) {
+      if (postGhostUpdate(coord)) {
+        pendingGhostCoord = coord;
+        break;
+      }
+    }
+    // the reals are current, the ghosts are reloaded in finishUpdateGhosts
+    // unless they are already complete
+    if (particleArrays) {
+      if (pendingGhostCoord < 0) particleArrays->reload();
+      else particleArrays->reload(realCells);
+    }
+  }
+
+  void DomainDecomposition::finishUpdateGhosts() {
+    if (pendingGhostCoord < 0) return;
+
+    LOG4ESPP_DEBUG(logger, "finishUpdateGhosts -> waiting for direction " << pendingGhostCoord);
+    completeGhostUpdate(pendingGhostCoord);
+    // the later directions forward the ghosts received before
+    for (int coord = pendingGhostCoord + 1; coord < 3; ++coord) {
+      if (postGhostUpdate(coord)) {
+        completeGhostUpdate(coord);
+      }
+    }
+    pendingGhostCoord = -1;
+
+    if (particleArrays) {
+      particleArrays->reload(ghostCells);
+    }
+  }
+
+  bool DomainDecomposition::postGhostUpdate(int coord) {
+    const int extradata = dataOfUpdateGhosts;
+    real curCoordBoxL = getSystem()->bc->getBoxL()[coord];
+
+    for (int lr = 0; lr < 2; ++lr) {
+      int dir         = 2 * coord + lr;
+      int oppositeDir = 2 * coord + (1 - lr);
+
+      Real3D shift(0, 0, 0);
+      shift[coord] = nodeGrid.getBoundary(dir) * curCoordBoxL;
+
+      if (nodeGrid.getGridSize(coord) == 1) {
+        if (commCells[dir].ghosts.size() != commCells[dir].reals.size()) {
+          throw std::runtime_error("DomainDecomposition::postGhostUpdate: send/recv cell structure mismatch during local copy");
+        }
+        for (int i = 0, end = commCells[dir].ghosts.size(); i < end; ++i) {
+          copyRealsToGhosts(*commCells[dir].reals[i], *commCells[dir].ghosts[i], extradata, shift);
+        }
+        continue;
+      }
+
+      // dataOfUpdateGhosts is 0, so the positions are all to send
+      checkRealCount(commCells[dir]);
+      const mpi::communicator &comm = *getSystem()->comm;
+      ghostRequests[2 * lr] = ghostRecvBuffer[dir].irecv(comm, nodeGrid.getNodeNeighborIndex(oppositeDir),
+          DD_GHOST_TAG + dir, GhostBuffer::positionSize * commCells[dir].nGhosts);
+
+      ghostSendBuffer[dir].packPositions(commCells[dir].reals, shift);
+      ghostRequests[2 * lr + 1] = ghostSendBuffer[dir].isend(comm, nodeGrid.getNodeNeighborIndex(dir),
+          DD_GHOST_TAG + dir);
+    }
+
+    return nodeGrid.getGridSize(coord) > 1;
+  }
+
+  void DomainDecomposition::completeGhostUpdate(int coord) {
+    mpi::wait_all(ghostRequests, ghostRequests + 4, ghostStatus);
+
+    for (int lr = 0; lr < 2; ++lr) {
+      int dir = 2 * coord + lr;
+      ghostRecvBuffer[dir].checkReceived(ghostStatus[2 * lr]);
+      ghostRecvBuffer[dir].unpackPositions(commCells[dir].ghosts);
+    }
   }
 
   void DomainDecomposition::updateGhostsV() {
@@ -689,46 +1049,22 @@ namespace espressopp {
             }
           }
         }
+        else if (!sizesFirst && (!realToGhosts || extradata == 0)) {
+          doTypedGhostCommunication(dir, realToGhosts, shift);
+        }
         else {
-          // exchange size information, if necessary
-          if (sizesFirst) {
-            LOG4ESPP_DEBUG(logger, "exchanging ghost cell sizes");
-
-            // prepare buffers
-            std::vector<longint> sendSizes, recvSizes;
-            sendSizes.reserve(commCells[dir].reals.size());
-            for (int i = 0, end = commCells[dir].reals.size(); i < end; ++i) {
-              sendSizes.push_back(commCells[dir].reals[i]->particles.size());
-            }
-            recvSizes.resize(commCells[dir].ghosts.size());
-
-            // exchange sizes, odd-even rule
-            if (nodeGrid.getNodePosition(coord) % 2 == 0) {
-              LOG4ESPP_DEBUG(logger, "sending to node " << nodeGrid.getNodeNeighborIndex(dir)
-                        << ", then receiving from node " << nodeGrid.getNodeNeighborIndex(oppositeDir));
-              getSystem()->comm->send(nodeGrid.getNodeNeighborIndex(dir), DD_COMM_TAG, &(sendSizes[0]), sendSizes.size());
-              getSystem()->comm->recv(nodeGrid.getNodeNeighborIndex(oppositeDir), DD_COMM_TAG, &(recvSizes[0]), recvSizes.size());
-            }
-            else {
-              LOG4ESPP_DEBUG(logger, "receiving from node " << nodeGrid.getNodeNeighborIndex(oppositeDir)
-                        << ", then sending to node " << nodeGrid.getNodeNeighborIndex(dir));
-              getSystem()->comm->recv(nodeGrid.getNodeNeighborIndex(oppositeDir), DD_COMM_TAG, &(recvSizes[0]), recvSizes.size());
-              getSystem()->comm->send(nodeGrid.getNodeNeighborIndex(dir), DD_COMM_TAG, &(sendSizes[0]), sendSizes.size());
-            }
-
-            // resize according to received information
-            for (int i = 0, end = commCells[dir].ghosts.size(); i < end; ++i) {
-              commCells[dir].ghosts[i]->particles.resize(recvSizes[i]);
-            }
-            LOG4ESPP_DEBUG(logger, "exchanging ghost cell sizes done");
-          }
-
           // prepare send and receive buffers
           longint receiver, sender;
           outBuffer.reset();
           if (realToGhosts) {
             receiver = nodeGrid.getNodeNeighborIndex(dir);
             sender = nodeGrid.getNodeNeighborIndex(oppositeDir);
+            // the sizes go in front of the particle data
+            if (sizesFirst) {
+              packCellSizes(outBuffer, commCells[dir]);
+            } else {
+              checkRealCount(commCells[dir]);
+            }
             for (int i = 0, end = commCells[dir].reals.size(); i < end; ++i) {
               packPositionsEtc(outBuffer, *commCells[dir].reals[i], extradata, shift);
             }
@@ -741,17 +1077,29 @@ namespace espressopp {
             }
           }
 
-          // exchange particles, odd-even rule
+          // exchange particles, odd-even rule. Without sizes, the size of
+          // the message is known from the last exchange of the sizes.
           if (nodeGrid.getNodePosition(coord) % 2 == 0) {
             outBuffer.send(receiver, DD_COMM_TAG);
-            inBuffer.recv(sender, DD_COMM_TAG);
+            if (sizesFirst) {
+              inBuffer.recv(sender, DD_COMM_TAG);
+            } else {
+              inBuffer.recv(sender, DD_COMM_TAG, ghostMessageSize(commCells[dir], extradata));
+            }
           } else {
-            inBuffer.recv(sender, DD_COMM_TAG);
+            if (sizesFirst) {
+              inBuffer.recv(sender, DD_COMM_TAG);
+            } else {
+              inBuffer.recv(sender, DD_COMM_TAG, ghostMessageSize(commCells[dir], extradata));
+            }
             outBuffer.send(receiver, DD_COMM_TAG);
           }
 
           // unpack received data
           if (realToGhosts) {
+            if (sizesFirst) {
+              unpackCellSizes(commCells[dir], inBuffer);
+            }
             for (int i = 0, end = commCells[dir].reals.size(); i < end; ++i) {
               unpackPositionsEtc(*commCells[dir].ghosts[i], inBuffer, extradata);
             }
@@ -767,6 +1115,79 @@ namespace espressopp {
     LOG4ESPP_DEBUG(logger, "ghost communication finished");
   }
 
+  void DomainDecomposition::packCellSizes(OutBuffer &buf, CommCells &comm) {
+    LOG4ESPP_DEBUG(logger, "packing ghost cell sizes");
+    comm.nReals = 0;
+    for (int i = 0, end = comm.reals.size(); i < end; ++i) {
+      int size = comm.reals[i]->particles.size();
+      buf.write(size);
+      comm.nReals += size;
+    }
+  }
+
+  void DomainDecomposition::unpackCellSizes(CommCells &comm, InBuffer &buf) {
+    LOG4ESPP_DEBUG(logger, "resizing ghost cells");
+    comm.nGhosts = 0;
+    for (int i = 0, end = comm.ghosts.size(); i < end; ++i) {
+      int size;
+      buf.read(size);
+      comm.ghosts[i]->particles.resize(size);
+      comm.nGhosts += size;
+    }
+  }
+
+  int DomainDecomposition::ghostMessageSize(const CommCells &comm, int extradata) const {
+    return comm.nGhosts * Buffer::particleDataSize(extradata);
+  }
+
+  void DomainDecomposition::checkRealCount(const CommCells &comm) const {
+    // the receiver sized its receive by the counts of the last exchange
+    longint n = 0;
+    for (int i = 0, end = comm.reals.size(); i < end; ++i) {
+      n += comm.reals[i]->particles.size();
+    }
+    if (n != comm.nReals) {
+      throw std::runtime_error("DomainDecomposition: the particles have changed since the last ghost exchange, decompose first");
+    }
+  }
+
+  void DomainDecomposition::
+  doTypedGhostCommunication(int dir, bool realToGhosts, const Real3D& shift) {
+    int oppositeDir = dir ^ 1;
+    CommCells &cc = commCells[dir];
+    GhostBuffer &sendBuf = ghostSendBuffer[dir];
+    GhostBuffer &recvBuf = ghostRecvBuffer[dir];
+    const mpi::communicator &comm = *getSystem()->comm;
+
+    // ghost forces travel against the direction of the positions
+    longint receiver, sender, nRecv;
+    if (realToGhosts) {
+      receiver = nodeGrid.getNodeNeighborIndex(dir);
+      sender = nodeGrid.getNodeNeighborIndex(oppositeDir);
+      nRecv = GhostBuffer::positionSize * cc.nGhosts;
+      checkRealCount(cc);
+      sendBuf.packPositions(cc.reals, shift);
+    } else {
+      receiver = nodeGrid.getNodeNeighborIndex(oppositeDir);
+      sender = nodeGrid.getNodeNeighborIndex(dir);
+      nRecv = GhostBuffer::forceSize * cc.nReals;
+      sendBuf.packForces(cc.ghosts);
+    }
+
+    mpi::request reqs[2];
+    mpi::status stats[2];
+    reqs[0] = recvBuf.irecv(comm, sender, DD_GHOST_TAG + dir, nRecv);
+    reqs[1] = sendBuf.isend(comm, receiver, DD_GHOST_TAG + dir);
+    mpi::wait_all(reqs, reqs + 2, stats);
+    recvBuf.checkReceived(stats[0]);
+
+    if (realToGhosts) {
+      recvBuf.unpackPositions(cc.ghosts);
+    } else {
+      recvBuf.unpackAndAddForces(cc.reals);
+    }
+  }
+
   //////////////////////////////////////////////////
   // REGISTRATION WITH PYTHON
   //////////////////////////////////////////////////
@@ -774,10 +1195,17 @@ namespace espressopp {
     using namespace espressopp::python;
     class_< DomainDecomposition, bases< Storage >, boost::noncopyable >
     ("storage_DomainDecomposition", init< shared_ptr< System >, const Int3D&, const Int3D& >())
+    .def(init< shared_ptr< System >, const Int3D&, const Int3D&, bool >())
     .def("mapPositionToNodeClipped", &DomainDecomposition::mapPositionToNodeClipped)
     .def("getCellGrid", &DomainDecomposition::getInt3DCellGrid)
     .def("getNodeGrid", &DomainDecomposition::getInt3DNodeGrid)
     .def("cellAdjust", &DomainDecomposition::cellAdjust)
+    .def("balanceLoad", &DomainDecomposition::balanceLoad)
+    .def("getLoadImbalance", &DomainDecomposition::getLoadImbalance)
+    .add_property("balanceInterval", &DomainDecomposition::getBalanceInterval, &DomainDecomposition::setBalanceInterval)
+    .add_property("balanceTolerance", &DomainDecomposition::getBalanceTolerance, &DomainDecomposition::setBalanceTolerance)
+    .add_property("mortonOrder", &DomainDecomposition::getMortonOrder, &DomainDecomposition::setMortonOrder)
+    .def("getOrderDistance", &DomainDecomposition::getOrderDistance)
     ;
   }
 
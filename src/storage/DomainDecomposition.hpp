@@ -27,6 +27,7 @@
 #include "types.hpp"
 #include "CellGrid.hpp"
 #include "NodeGrid.hpp"
+#include "GhostBuffer.hpp"
 
 
 namespace espressopp {
@@ -39,9 +40,14 @@ namespace espressopp {
 
     class DomainDecomposition: public Storage {
     public:
+      /** if useParticleArrays is set, a structure-of-arrays copy of the
+          local particles is kept alongside the cells for the force kernels,
+          see ParticleArrays.
+      */
       DomainDecomposition(shared_ptr< System > system,
               const Int3D& _nodeGrid,
-			  const Int3D& _cellGrid);
+			  const Int3D& _cellGrid,
+			  bool useParticleArrays = false);
 
       virtual ~DomainDecomposition() {}
 
@@ -57,6 +63,50 @@ namespace espressopp {
       // as a consequence of the system resizing
       virtual void cellAdjust();
 
+      /** Moves the boundaries between the node domains along each axis
+          such that all layers of nodes along the axis hold about the same
+          number of real particles, and redistributes the particles.
+          Domains stay at least cutoff+skin wide. Since the boundaries are
+          shared by all nodes in a layer, this balances inhomogeneities
+          along the axes, e.g. slabs or interfaces. Collective, returns
+          whether the boundaries have changed.
+      */
+      bool balanceLoad();
+
+      /** ratio of the largest number of real particles on a node to the
+          average number, collective */
+      real getLoadImbalance();
+
+      /** If the balance interval is larger than 0, every balanceInterval-th
+          decompose() calls balanceLoad() first if the load imbalance
+          exceeds the balance tolerance. */
+      void setBalanceInterval(int interval);
+      int getBalanceInterval() { return balanceInterval; }
+      void setBalanceTolerance(real tolerance) { balanceTolerance = tolerance; }
+      real getBalanceTolerance() { return balanceTolerance; }
+
+      /** Set by extensions that decompose their own data along the node
+          domains, e.g. the LatticeBoltzmann lattice. Then balanceLoad()
+          leaves the boundaries where they are, and the balance interval
+          has to be 0. */
+      void setFixedBoundaries(bool fixed);
+      bool getFixedBoundaries() { return fixedBoundaries; }
+
+      virtual void decompose();
+
+      /** If set, the local cells are ordered along a Morton (Z-order)
+          space-filling curve instead of lexicographically, which also
+          orders the particle arrays, and every decompose() sorts the
+          real particles within their cells along the same curve. Then
+          particles close in space are also close in memory. */
+      void setMortonOrder(bool order);
+      bool getMortonOrder() { return mortonOrder; }
+
+      /** mean distance between the real particles that follow each other
+          in memory, over all nodes. The smaller, the better the locality
+          of the particle data. Collective. */
+      real getOrderDistance();
+
       virtual Cell *mapPositionToCell(const Real3D& pos);
       virtual Cell *mapPositionToCellClipped(const Real3D& pos);
       virtual Cell *mapPositionToCellChecked(const Real3D& pos);
@@ -74,6 +124,11 @@ namespace espressopp {
       virtual real getLocalBoxZMax() { return nodeGrid.getMyRight(2); }
 
       virtual void updateGhosts();
+      /** nonblocking ghost update: the messages of the first direction
+          that needs communication are posted here, and all following
+          directions are exchanged in finishUpdateGhosts(). */
+      virtual void beginUpdateGhosts();
+      virtual void finishUpdateGhosts();
       virtual void updateGhostsV();
       virtual void collectGhostForces();
 
@@ -90,12 +145,28 @@ namespace espressopp {
 
       void prepareGhostCommunication();
 
+      /** start the ghost update in one coordinate direction. Returns
+          false if it was completed right away because it is local. */
+      bool postGhostUpdate(int coord);
+      /// wait for the messages posted by postGhostUpdate() and unpack them
+      void completeGhostUpdate(int coord);
+
       /// init global Verlet list
       void initCellInteractions();
       /// set the grids and allocate space accordingly
       void createCellGrid(const Int3D& nodeGrid, const Int3D& cellGrid);
+      /// set the cell grid of the current node domain and allocate space accordingly
+      void createCells(const Int3D& cellGrid);
+      /** replace the cell grid and put the real particles into the new
+          cells, clipped to the node domain. The ghosts are not
+          exchanged. */
+      void rebuildCells(const Int3D& cellGrid);
       /// sort cells into local/ghost cell arrays
       void markCells();
+      /// order the cell lists along the Morton curve or lexicographically, see setMortonOrder()
+      void orderCells();
+      /// sort the real particles within their cells along the Morton curve
+      void sortParticlesInCells();
       /// fill a list of cells with the cells from a certain region of the domain grid
       void fillCells(std::vector<Cell *> &,
 		     const int leftBoundary[3],
@@ -123,12 +194,54 @@ namespace espressopp {
       struct CommCells {
         std::vector<Cell *> reals;
         std::vector<Cell *> ghosts;
+        /** number of particles in the cells as of the last
+            exchangeGhosts(), which fixes the sizes of all messages
+            until the next one */
+        longint nReals;
+        longint nGhosts;
+
+        CommCells() : nReals(0), nGhosts(0) {}
       };
       /** which cells to send left, right, up, down, ...
 	  For the order, see NodeGrid.
       */
       CommCells commCells[6];
 
+      /** with sizesFirst, write the particle numbers of the cells to send
+          to the buffer, which go along with the particle data */
+      void packCellSizes(OutBuffer &buf, CommCells &comm);
+      /** read the particle numbers written by packCellSizes() and resize
+          the ghost cells accordingly */
+      void unpackCellSizes(CommCells &comm, InBuffer &buf);
+      /** size of the message to receive in a ghost update of reals to
+          ghosts without sizes */
+      int ghostMessageSize(const CommCells &comm, int extradata) const;
+      /** throw if the reals to send in a ghost update without sizes are
+          not as many as the receiver expects, i.e. comm.nReals */
+      void checkRealCount(const CommCells &comm) const;
+      /** exchange positions (realToGhosts) or forces in direction dir
+          through the typed ghost buffers */
+      void doTypedGhostCommunication(int dir, bool realToGhosts, const Real3D& shift);
+
+      /// send and receive buffers for positions and forces, per direction
+      GhostBuffer ghostSendBuffer[6];
+      GhostBuffer ghostRecvBuffer[6];
+
+      /// see setMortonOrder()
+      bool mortonOrder;
+
+      /// see setBalanceInterval()
+      int balanceInterval;
+      real balanceTolerance;
+      /// see setFixedBoundaries()
+      bool fixedBoundaries;
+      longint decomposeCount;
+
+      /// coordinate of the ghost update in progress, -1 if there is none
+      int pendingGhostCoord;
+      mpi::request ghostRequests[4];
+      mpi::status ghostStatus[4];
+
       static LOG4ESPP_DECL_LOGGER(logger);
     };
   }
@@ -25,14 +25,21 @@ r"""
 ******************************************
 
 
-.. function:: espressopp.storage.DomainDecomposition(system, nodeGrid, cellGrid)
+.. function:: espressopp.storage.DomainDecomposition(system, nodeGrid, cellGrid, nocheck, particleArrays)
 
 		:param system: 
 		:param nodeGrid: 
 		:param cellGrid: 
+		:param nocheck: (default: False) skip the sanity checks of the grids
+		:param particleArrays: (default: False) keep a structure-of-arrays copy of
+		  the positions and types of the local particles, into which the force
+		  loops that support it accumulate the forces. The particles stay the
+		  owners of the data, the positions are copied once per ghost update
 		:type system: 
 		:type nodeGrid: 
 		:type cellGrid: 
+		:type nocheck: bool
+		:type particleArrays: bool
 
 .. function:: espressopp.storage.DomainDecomposition.getCellGrid()
 
@@ -41,6 +48,47 @@ r"""
 .. function:: espressopp.storage.DomainDecomposition.getNodeGrid()
 
 		:rtype: 
+
+.. function:: espressopp.storage.DomainDecomposition.balanceLoad()
+
+		Moves the boundaries between the node domains along each axis such
+		that every layer of nodes along the axis holds about the same number
+		of real particles, and redistributes the particles. Domains stay at
+		least cutoff+skin wide. This balances systems that are inhomogeneous
+		along an axis, e.g. slabs, walls or liquid-vapour interfaces.
+		Does nothing while a LatticeBoltzmann extension exists, since its
+		lattice is distributed along the node domains.
+
+		:rtype: bool, whether the boundaries have changed
+
+.. function:: espressopp.storage.DomainDecomposition.getLoadImbalance()
+
+		:rtype: real, largest number of real particles on a node divided by
+		  the average number
+
+.. function:: espressopp.storage.DomainDecomposition.getOrderDistance()
+
+		:rtype: real, mean distance between the real particles that follow
+		  each other in memory. The smaller, the better the cache locality of
+		  the particle data.
+
+Properties
+
+* `mortonOrder`
+  if True, the cells are ordered along a Morton (Z-order) space-filling
+  curve instead of lexicographically, and every resort sorts the particles
+  within the cells along the same curve, so that particles close in space
+  stay close in memory (default: False)
+
+* `balanceInterval`
+  if larger than 0, every balanceInterval-th resort balances the load first
+  if the load imbalance exceeds `balanceTolerance` (default: 0, off).
+  Must be 0 while a LatticeBoltzmann extension exists
+
+* `balanceTolerance`
+  load imbalance tolerated without balancing (default: 1.1)
+
+>>> system.storage.balanceInterval = 10
 """
 from espressopp import pmi
 from espressopp.esutil import cxxinit
@@ -54,9 +102,9 @@ from espressopp.storage.Storage import *
 
 class DomainDecompositionLocal(StorageLocal, storage_DomainDecomposition):
 
-    def __init__(self, system, nodeGrid, cellGrid):
+    def __init__(self, system, nodeGrid, cellGrid, particleArrays=False):
         if not (pmi._PMIComm and pmi._PMIComm.isActive()) or pmi._MPIcomm.rank in pmi._PMIComm.getMPIcpugroup():
-            cxxinit(self, storage_DomainDecomposition, system, nodeGrid, cellGrid)
+            cxxinit(self, storage_DomainDecomposition, system, nodeGrid, cellGrid, particleArrays)
     
     def getCellGrid(self):
         if not (pmi._PMIComm and pmi._PMIComm.isActive()) or pmi._MPIcomm.rank in pmi._PMIComm.getMPIcpugroup():
@@ -70,16 +118,19 @@ if pmi.isController:
     class DomainDecomposition(Storage):
         pmiproxydefs = dict(
           cls = 'espressopp.storage.DomainDecompositionLocal',  
-          pmicall = ['getCellGrid', 'getNodeGrid', 'cellAdjust']
+          pmicall = ['getCellGrid', 'getNodeGrid', 'cellAdjust', 'balanceLoad', 'getLoadImbalance',
+                     'getOrderDistance'],
+          pmiproperty = ['balanceInterval', 'balanceTolerance', 'mortonOrder']
         )
         def __init__(self, system, 
                      nodeGrid='auto', 
                      cellGrid='auto',
-                     nocheck=False):
+                     nocheck=False,
+                     particleArrays=False):
             # do sanity checks for the system first
             if nocheck:
               self.next_id = 0
-              self.pmiinit(system, nodeGrid, cellGrid)                
+              self.pmiinit(system, nodeGrid, cellGrid, particleArrays)
             else:
               if check.System(system, 'bc'):
                 if nodeGrid == 'auto':
@@ -97,6 +148,6 @@ if pmi.isController:
                            "adjusted to 2 (was={})".format(k, cellGrid[k])))
                     cellGrid[k] = 2
                 self.next_id = 0
-                self.pmiinit(system, nodeGrid, cellGrid)
+                self.pmiinit(system, nodeGrid, cellGrid, particleArrays)
               else:
                 print 'Error: could not create DomainDecomposition object'
@@ -227,6 +227,9 @@ namespace espressopp {
         updateLocalParticles((*it)->particles);
       }
 
+      // like decompose(), so the particles are on their nodes afterwards
+      decomposeRealParticles();
+      onTuplesChanged();
       exchangeGhosts();
       onParticlesChanged();
   }
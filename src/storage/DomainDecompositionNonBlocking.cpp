@@ -224,6 +224,8 @@ namespace espressopp {
 
     LOG4ESPP_DEBUG(logger, "finished exchanging particles, new send/recv buffer size " << exchangeBufferSize);
 
+    if (mortonOrder) sortParticlesInCells();
+
     LOG4ESPP_DEBUG(logger, "done");
   }
 
@@ -273,50 +275,22 @@ namespace espressopp {
             }
           }
         }
+        else if (!sizesFirst && (!realToGhosts || extradata == 0)) {
+          doTypedGhostCommunication(dir, realToGhosts, shift);
+        }
         else {
-          // exchange size information, if necessary
-          if (sizesFirst) {
-            LOG4ESPP_DEBUG(logger, "exchanging ghost cell sizes");
-
-            // prepare buffers
-            std::vector<longint> sendSizes, recvSizes;
-            sendSizes.reserve(commCells[dir].reals.size());
-            for (int i = 0, end = commCells[dir].reals.size(); i < end; ++i) {
-              sendSizes.push_back(commCells[dir].reals[i]->particles.size());
-            }
-            recvSizes.resize(commCells[dir].ghosts.size());
-
-            mpi::request reqs[2];
-
-            // exchange sizes, odd-even rule
-            if (nodeGrid.getNodePosition(coord) % 2 == 0) {
-              LOG4ESPP_DEBUG(logger, "sending to node " << nodeGrid.getNodeNeighborIndex(dir)
-                        << ", then receiving from node " << nodeGrid.getNodeNeighborIndex(oppositeDir));
-              reqs[0]=getSystem()->comm->isend(nodeGrid.getNodeNeighborIndex(dir), DD_COMM_TAG, &(sendSizes[0]), sendSizes.size());
-              reqs[1]=getSystem()->comm->irecv(nodeGrid.getNodeNeighborIndex(oppositeDir), DD_COMM_TAG, &(recvSizes[0]), recvSizes.size());
-            }
-            else {
-              LOG4ESPP_DEBUG(logger, "receiving from node " << nodeGrid.getNodeNeighborIndex(oppositeDir)
-                        << ", then sending to node " << nodeGrid.getNodeNeighborIndex(dir));
-              reqs[0]=getSystem()->comm->irecv(nodeGrid.getNodeNeighborIndex(oppositeDir), DD_COMM_TAG, &(recvSizes[0]), recvSizes.size());
-              reqs[1]=getSystem()->comm->isend(nodeGrid.getNodeNeighborIndex(dir), DD_COMM_TAG, &(sendSizes[0]), sendSizes.size());
-            }
-
-            mpi::wait_all(reqs, reqs + 2);
-
-            // resize according to received information
-            for (int i = 0, end = commCells[dir].ghosts.size(); i < end; ++i) {
-              commCells[dir].ghosts[i]->particles.resize(recvSizes[i]);
-            }
-            LOG4ESPP_DEBUG(logger, "exchanging ghost cell sizes done");
-          }
-
           // prepare send and receive buffers
           longint receiver, sender;
           outBufferG.reset();
           if (realToGhosts) {
             receiver = nodeGrid.getNodeNeighborIndex(dir);
             sender = nodeGrid.getNodeNeighborIndex(oppositeDir);
+            // the sizes go in front of the particle data
+            if (sizesFirst) {
+              packCellSizes(outBufferG, commCells[dir]);
+            } else {
+              checkRealCount(commCells[dir]);
+            }
             for (int i = 0, end = commCells[dir].reals.size(); i < end; ++i) {
               packPositionsEtc(outBufferG, *commCells[dir].reals[i], extradata, shift);
             }
@@ -330,20 +304,37 @@ namespace espressopp {
           }
 
           mpi::request reqs[2];
+          mpi::status stats[2];
+          int recvReq;
 
-          // exchange particles, odd-even rule
+          // exchange particles, odd-even rule. Without sizes, the size of
+          // the message is known, so the receive does not block.
           if (nodeGrid.getNodePosition(coord) % 2 == 0) {
+            recvReq = 1;
             reqs[0]=outBufferG.isend(receiver, DD_COMM_TAG);
-            reqs[1]=inBufferG.irecv(sender, DD_COMM_TAG);
+            if (sizesFirst) {
+              reqs[1]=inBufferG.irecv(sender, DD_COMM_TAG);
+            } else {
+              reqs[1]=inBufferG.irecv(sender, DD_COMM_TAG, ghostMessageSize(commCells[dir], extradata));
+            }
           } else {
-            reqs[0]=inBufferG.irecv(sender, DD_COMM_TAG);
+            recvReq = 0;
+            if (sizesFirst) {
+              reqs[0]=inBufferG.irecv(sender, DD_COMM_TAG);
+            } else {
+              reqs[0]=inBufferG.irecv(sender, DD_COMM_TAG, ghostMessageSize(commCells[dir], extradata));
+            }
             reqs[1]=outBufferG.isend(receiver, DD_COMM_TAG);
           }
 
-          mpi::wait_all(reqs, reqs + 2);
+          mpi::wait_all(reqs, reqs + 2, stats);
+          if (!sizesFirst) inBufferG.checkReceived(stats[recvReq]);
 
           // unpack received data
           if (realToGhosts) {
+            if (sizesFirst) {
+              unpackCellSizes(commCells[dir], inBufferG);
+            }
             for (int i = 0, end = commCells[dir].reals.size(); i < end; ++i) {
               unpackPositionsEtc(*commCells[dir].ghosts[i], inBufferG, extradata);
             }
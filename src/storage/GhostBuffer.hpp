@@ -0,0 +1,159 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// ESPP_CLASS
+#ifndef _STORAGE_GHOSTBUFFER_HPP
+#define _STORAGE_GHOSTBUFFER_HPP
+
+#include <vector>
+#include <stdexcept>
+#include "mpi.hpp"
+#include "types.hpp"
+#include "Real3D.hpp"
+#include "Particle.hpp"
+#include "Cell.hpp"
+
+namespace espressopp {
+  namespace storage {
+
+    /** Communication buffer for the positions and forces of the ghost
+        communication.
+
+        Unlike InBuffer/OutBuffer, the buffer holds only the fields that
+        are needed as plain reals: positionSize reals per particle for a
+        position update, forceSize reals for the ghost forces. The data is
+        packed directly from the cells and handed to MPI as is. The buffer
+        keeps its capacity, so that a storage holding one buffer per
+        direction does not allocate after the first steps.
+    */
+    class GhostBuffer {
+    public:
+      enum { positionSize = 3, forceSize = 4 };
+
+      /** pack the positions of the particles in cells, shifted by shift */
+      void packPositions(const std::vector< Cell* > &cells, const Real3D& shift) {
+        buf.resize(positionSize * countParticles(cells));
+        real *b = data();
+        for (size_t c = 0; c < cells.size(); ++c) {
+          ParticleList &pl = cells[c]->particles;
+          for (ParticleList::iterator it = pl.begin(), end = pl.end(); it != end; ++it) {
+            const Real3D &pos = it->position();
+            b[0] = pos[0] + shift[0];
+            b[1] = pos[1] + shift[1];
+            b[2] = pos[2] + shift[2];
+            b += positionSize;
+          }
+        }
+      }
+
+      /** set the positions of the particles in cells from the buffer */
+      void unpackPositions(const std::vector< Cell* > &cells) const {
+        checkSize(positionSize * countParticles(cells));
+        const real *b = data();
+        for (size_t c = 0; c < cells.size(); ++c) {
+          ParticleList &pl = cells[c]->particles;
+          for (ParticleList::iterator it = pl.begin(), end = pl.end(); it != end; ++it) {
+            it->position() = Real3D(b[0], b[1], b[2]);
+            b += positionSize;
+          }
+        }
+      }
+
+      /** pack the forces of the particles in cells */
+      void packForces(const std::vector< Cell* > &cells) {
+        buf.resize(forceSize * countParticles(cells));
+        real *b = data();
+        for (size_t c = 0; c < cells.size(); ++c) {
+          ParticleList &pl = cells[c]->particles;
+          for (ParticleList::iterator it = pl.begin(), end = pl.end(); it != end; ++it) {
+            const Real3D &f = it->force();
+            b[0] = f[0];
+            b[1] = f[1];
+            b[2] = f[2];
+            b[3] = it->fradius();
+            b += forceSize;
+          }
+        }
+      }
+
+      /** add the forces from the buffer to the particles in cells */
+      void unpackAndAddForces(const std::vector< Cell* > &cells) const {
+        checkSize(forceSize * countParticles(cells));
+        const real *b = data();
+        for (size_t c = 0; c < cells.size(); ++c) {
+          ParticleList &pl = cells[c]->particles;
+          for (ParticleList::iterator it = pl.begin(), end = pl.end(); it != end; ++it) {
+            it->force() += Real3D(b[0], b[1], b[2]);
+            it->fradius() += b[3];
+            b += forceSize;
+          }
+        }
+      }
+
+      void send(const mpi::communicator &comm, longint receiver, int tag) const {
+        comm.send(receiver, tag, data(), buf.size());
+      }
+
+      mpi::request isend(const mpi::communicator &comm, longint receiver, int tag) const {
+        return comm.isend(receiver, tag, data(), buf.size());
+      }
+
+      /** receive n reals, the size of the message must be known */
+      void recv(const mpi::communicator &comm, longint sender, int tag, longint n) {
+        buf.resize(n);
+        comm.recv(sender, tag, data(), n);
+      }
+
+      mpi::request irecv(const mpi::communicator &comm, longint sender, int tag, longint n) {
+        buf.resize(n);
+        return comm.irecv(sender, tag, data(), n);
+      }
+
+      /** check that the message of an irecv() had the size it was
+          posted with */
+      void checkReceived(const mpi::status &status) const {
+        if (*status.count< real >() != int(buf.size())) {
+          throw std::runtime_error("GhostBuffer: received message does not have the expected size");
+        }
+      }
+
+    private:
+      std::vector< real > buf;
+
+      real *data() { return buf.empty() ? 0 : &buf[0]; }
+      const real *data() const { return buf.empty() ? 0 : &buf[0]; }
+
+      static longint countParticles(const std::vector< Cell* > &cells) {
+        longint n = 0;
+        for (size_t c = 0; c < cells.size(); ++c) {
+          n += cells[c]->particles.size();
+        }
+        return n;
+      }
+
+      void checkSize(longint n) const {
+        if (longint(buf.size()) != n) {
+          throw std::runtime_error("GhostBuffer: message size does not match the ghost cells");
+        }
+      }
+    };
+  }
+}
+#endif
@@ -20,6 +20,7 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>. 
 */
 
+#include <algorithm>
 #include "log4espp.hpp"
 
 #include "Real3D.hpp"
@@ -47,9 +48,38 @@ namespace espressopp {
         localBoxSize[i] = domainSize[i]/static_cast<real>(getGridSize(i));
         invLocalBoxSize[i] = 1.0/localBoxSize[i];
       }
-      smallestLocalBoxDiameter = std::min(std::min(localBoxSize[0], localBoxSize[1]), localBoxSize[2]);
 
       calcNodeNeighbors(nodeId);
+
+      for(int i = 0; i < 3; ++i) {
+        // equal domains
+        std::vector<real> b(getGridSize(i) + 1);
+        for (int k = 0; k < getGridSize(i); ++k) {
+          b[k] = k*localBoxSize[i];
+        }
+        b[getGridSize(i)] = domainSize[i];
+        setBoundaries(i, b);
+      }
+    }
+
+    void NodeGrid::setBoundaries(int axis, const std::vector<real> &b)
+    {
+      if (b.size() != static_cast<size_t>(getGridSize(axis) + 1)) {
+        throw std::invalid_argument("NodeGrid::setBoundaries: wrong number of boundaries");
+      }
+      for (size_t k = 1; k < b.size(); ++k) {
+        if (!(b[k] > b[k - 1])) {
+          throw std::invalid_argument("NodeGrid::setBoundaries: boundaries have to increase");
+        }
+      }
+      bounds[axis] = b;
+
+      localBoxSize[axis] = getMyRight(axis) - getMyLeft(axis);
+      invLocalBoxSize[axis] = 1.0/localBoxSize[axis];
+      smallestLocalBoxDiameter = std::min(std::min(localBoxSize[0], localBoxSize[1]), localBoxSize[2]);
+
+      LOG4ESPP_DEBUG(logger, "local box along axis " << axis << ": "
+                     << getMyLeft(axis) << " - " << getMyRight(axis));
     }
 
     longint NodeGrid::
@@ -58,13 +88,9 @@ namespace espressopp {
       Int3D cpos;
     
       for (int i = 0; i < 3; ++i) {
-        cpos[i] = static_cast< int >(pos[i]*invLocalBoxSize[i]);
-        if (cpos[i] < 0) {
-          cpos[i] = 0;
-        }
-        else if (cpos[i] >= getGridSize(i)) {
-          cpos[i] = getGridSize(i) - 1;
-        }
+        // first domain whose right boundary lies beyond pos
+        cpos[i] = std::upper_bound(bounds[i].begin() + 1, bounds[i].end() - 1, pos[i])
+          - (bounds[i].begin() + 1);
       }
       return mapPositionToIndex(cpos);
     }
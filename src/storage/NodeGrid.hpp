@@ -29,6 +29,7 @@
 */
 
 #include <stdexcept>
+#include <vector>
 #include "types.hpp"
 #include "logging.hpp"
 #include "esutil/Grid.hpp"
@@ -44,7 +45,11 @@ namespace espressopp {
 
     /** Node grid point. This represents the node grid of the domain
 	decomposition, as well as the location of this processor in the
-	grid.
+	grid. Initially the box is split into equal node domains, but the
+	boundaries between the domains can be moved along each axis, see
+	setBoundaries(). All nodes with the same position along an axis
+	share the same boundaries, so that neighboring domains always
+	match in the perpendicular directions.
     */
     class NodeGrid: public esutil::Grid
     {
@@ -78,14 +83,23 @@ namespace espressopp {
       /// inverse of the size of a cell
       real getInverseLocalBoxSize(int axis) const { return invLocalBoxSize[axis]; }
 
+      /** boundaries of the node domains along an axis, i.e. the
+	  getGridSize(axis) + 1 left edges of the domains and the box
+	  length */
+      const std::vector<real> &getBoundaries(int axis) const { return bounds[axis]; }
+      /** set the boundaries of the node domains along an axis. They have
+	  to start at 0, end at the box length and increase. Has to be
+	  called with the same values on all nodes. */
+      void setBoundaries(int axis, const std::vector<real> &b);
+
       /// calculate start of local box
-      real getMyLeft(int axis) const { return nodePos[axis]*localBoxSize[axis]; }
+      real getMyLeft(int axis) const { return bounds[axis][nodePos[axis]]; }
       Real3D getMyLeft() const { 
         return Real3D(getMyLeft(0), getMyLeft(1), getMyLeft(2));
       }
 
       /// calculate end of local box
-      real getMyRight(int axis) const { return (nodePos[axis] + 1)*localBoxSize[axis]; }
+      real getMyRight(int axis) const { return bounds[axis][nodePos[axis] + 1]; }
       Real3D getMyRight() const { 
         return Real3D(getMyRight(0), getMyRight(1), getMyRight(2));
       }
@@ -121,6 +135,7 @@ namespace espressopp {
           for (int i=0; i<3; ++i) {
             localBoxSize[i] *= s;
             invLocalBoxSize[i] /= s;
+            scaleBoundaries(i, s);
           }
           smallestLocalBoxDiameter *= s;
         }
@@ -134,6 +149,7 @@ namespace espressopp {
           for (int i=0; i<3; ++i) {
             localBoxSize[i] *= s[i];
             invLocalBoxSize[i] /= s[i];
+            scaleBoundaries(i, s[i]);
           }
           smallestLocalBoxDiameter = std::min(std::min(localBoxSize[0], localBoxSize[1]), localBoxSize[2]);
         }
@@ -146,6 +162,12 @@ namespace espressopp {
     private:
       void calcNodeNeighbors(longint node);
 
+      void scaleBoundaries(int axis, real s) {
+        for (size_t k = 0; k < bounds[axis].size(); ++k) {
+          bounds[axis][k] *= s;
+        }
+      }
+
       /// position of this node in node grid
       Int3D nodePos;
       /// the six nearest neighbors of a node in the node grid
@@ -161,6 +183,9 @@ namespace espressopp {
       /// smallest diameter of the local box
       real smallestLocalBoxDiameter;
 
+      /// boundaries of the node domains, see getBoundaries()
+      std::vector<real> bounds[3];
+
       static LOG4ESPP_DECL_LOGGER(logger);
     };
   }
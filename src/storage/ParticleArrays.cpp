@@ -0,0 +1,156 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "ParticleArrays.hpp"
+
+namespace espressopp {
+  namespace storage {
+
+    LOG4ESPP_LOGGER(ParticleArrays::logger, "ParticleArrays");
+
+    ParticleArrays::ParticleArrays()
+      : firstCell(0), layoutVersion(0), maxType(-1) {}
+
+    void ParticleArrays::build(const Cell *_firstCell, CellList &localCells) {
+      firstCell = _firstCell;
+      cells = localCells;
+
+      fill();
+    }
+
+    void ParticleArrays::clear() {
+      firstCell = 0;
+      cells.clear();
+      cellOffset.clear();
+      cellEndOffset.clear();
+      position.clear();
+      force.clear();
+      type.clear();
+      particle.clear();
+      maxType = -1;
+      ++layoutVersion;
+    }
+
+    void ParticleArrays::fill() {
+      // index the cells by their offset in the storage's cell array
+      longint nCells = 0;
+      for (CellList::Iterator it(cells); it.isValid(); ++it) {
+        nCells = std::max(nCells, longint(*it - firstCell) + 1);
+      }
+      cellOffset.assign(nCells, 0);
+      cellEndOffset.assign(nCells, 0);
+
+      longint n = 0;
+      for (CellList::Iterator it(cells); it.isValid(); ++it) {
+        longint c = *it - firstCell;
+        cellOffset[c] = n;
+        n += (*it)->particles.size();
+        cellEndOffset[c] = n;
+      }
+
+      position.resize(n);
+      force.assign(n, Real3D(0.0));
+      type.resize(n);
+      particle.resize(n);
+
+      maxType = -1;
+      longint i = 0;
+      for (CellList::Iterator it(cells); it.isValid(); ++it) {
+        ParticleList &pl = (*it)->particles;
+        for (ParticleList::iterator pit = pl.begin(), end = pl.end(); pit != end; ++pit, ++i) {
+          particle[i] = &(*pit);
+          position[i] = pit->position();
+          type[i] = pit->type();
+          maxType = std::max(maxType, type[i]);
+        }
+      }
+
+      ++layoutVersion;
+
+      LOG4ESPP_DEBUG(logger, "built arrays for " << n << " particles in "
+                     << nCells << " cells, layout version " << layoutVersion);
+    }
+
+    bool ParticleArrays::layoutMatches() const {
+      for (CellList::const_iterator it = cells.begin(), end = cells.end(); it != end; ++it) {
+        longint c = *it - firstCell;
+        const ParticleList &pl = (*it)->particles;
+        if (longint(pl.size()) != cellEndOffset[c] - cellOffset[c]) return false;
+        // the cell's vector might have been reallocated
+        if (!pl.empty() && particle[cellOffset[c]] != &pl[0]) return false;
+      }
+      return true;
+    }
+
+    void ParticleArrays::reload(CellList &reloadCells) {
+      if (!firstCell) return;
+
+      if (!layoutMatches()) {
+        LOG4ESPP_DEBUG(logger, "particles have changed, rebuilding arrays");
+        fill();
+        return;
+      }
+
+      // maxType is only an upper bound between two fills
+      for (CellList::Iterator it(reloadCells); it.isValid(); ++it) {
+        longint c = *it - firstCell;
+        for (longint i = cellOffset[c], end = cellEndOffset[c]; i < end; ++i) {
+          const Particle &p = *particle[i];
+          position[i] = p.position();
+          type[i] = p.type();
+          maxType = std::max(maxType, type[i]);
+        }
+      }
+    }
+
+    void ParticleArrays::prepareThreadForces(int nThreads) {
+      size_t n = particle.size();
+      if (threadForce.size() < size_t(nThreads)) {
+        threadForce.resize(nThreads);
+      }
+      for (int t = 0; t < nThreads; ++t) {
+        // the buffers are reset after use, so only new space is zeroed
+        if (threadForce[t].size() != n) threadForce[t].assign(n, Real3D(0.0));
+      }
+    }
+
+    void ParticleArrays::sumThreadForces(int nThreads) {
+      longint n = particle.size();
+#ifdef _OPENMP
+#pragma omp parallel for num_threads(nThreads) schedule(static)
+#endif
+      for (longint i = 0; i < n; ++i) {
+        Real3D sum = force[i];
+        for (int t = 0; t < nThreads; ++t) {
+          sum += threadForce[t][i];
+          threadForce[t][i] = 0.0;
+        }
+        force[i] = sum;
+      }
+    }
+
+    void ParticleArrays::addForcesToParticles() {
+      for (longint i = 0, n = particle.size(); i < n; ++i) {
+        particle[i]->force() += force[i];
+        force[i] = 0.0;
+      }
+    }
+  }
+}
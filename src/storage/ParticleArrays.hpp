@@ -0,0 +1,132 @@
+/*
+  Copyright (C) 2015
+      Max Planck Institute for Polymer Research
+
+  This file is part of ESPResSo++.
+
+  ESPResSo++ is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+
+  ESPResSo++ is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+// ESPP_CLASS
+#ifndef _STORAGE_PARTICLEARRAYS_HPP
+#define _STORAGE_PARTICLEARRAYS_HPP
+
+#include <vector>
+#include "types.hpp"
+#include "log4espp.hpp"
+#include "Real3D.hpp"
+#include "Particle.hpp"
+#include "Cell.hpp"
+
+namespace espressopp {
+  namespace storage {
+
+    /** Structure-of-arrays copy of the particle data used by the force
+        kernels.
+
+        The arrays contain all local (real and ghost) particles of a
+        storage, ordered by cells in the order of the storage's local
+        cells, i.e. the particles of one cell occupy the contiguous index
+        range [cellBegin(c), cellEnd(c)). The arrays hold only what the
+        force kernels read, position and type, and the forces they
+        accumulate.
+
+        The arrays are a mirror, not the storage of these fields: the
+        Particle objects remain the owners of all data, and the
+        positions are copied from them once per ghost update, see
+        reload(). Writing to position or type does not change the
+        particles. A force kernel accumulates into force and hands the
+        result back to the particles via addForcesToParticles() when it
+        is done, so the integrator and all code that is not performance
+        critical keep working on Particle, which is reachable from an
+        index via particle[i].
+    */
+    class ParticleArrays {
+    public:
+      ParticleArrays();
+
+      /** set up the layout for the given cells and load all data, in
+          the order of localCells. firstCell is the start of the storage's
+          cell array, which is used to map cells to indices. */
+      void build(const Cell *firstCell, CellList &localCells);
+
+      /** drop the layout, e.g. if the cell structure is recreated */
+      void clear();
+
+      /** copy the positions and types from the particles. If the number
+          of particles in any of the cells changed since the last build,
+          the layout is rebuilt. */
+      void reload() { reload(cells); }
+
+      /** as reload(), but only for the particles of reloadCells, e.g.
+          the real or the ghost cells after their update */
+      void reload(CellList &reloadCells);
+
+      /** add the forces accumulated in the arrays to the particles and
+          reset them to zero */
+      void addForcesToParticles();
+
+      /** make sure that there are nThreads zeroed force buffers of the
+          size of the arrays, one for each thread of a force loop */
+      void prepareThreadForces(int nThreads);
+
+      /** force buffer of a thread, see prepareThreadForces() */
+      Real3D *getThreadForce(int thread) { return &threadForce[thread][0]; }
+
+      /** add the forces of the first nThreads thread buffers to force
+          and reset the buffers to zero */
+      void sumThreadForces(int nThreads);
+
+      /** largest particle type in the arrays, -1 if they are empty. As
+          reload() only raises it, it may be too large if types have
+          been lowered since the last build. */
+      int getMaxType() const { return maxType; }
+
+      /** number of local particles in the arrays */
+      longint size() const { return particle.size(); }
+
+      /** first index of a cell, cellIdx is the offset of the cell in
+          the storage's cell array */
+      longint cellBegin(longint cellIdx) const { return cellOffset[cellIdx]; }
+
+      /** one past the last index of a cell */
+      longint cellEnd(longint cellIdx) const { return cellEndOffset[cellIdx]; }
+
+      /** increased whenever the layout changes, so that clients holding
+          indices can detect that they have to rebuild */
+      int getLayoutVersion() const { return layoutVersion; }
+
+      std::vector< Real3D > position;
+      std::vector< Real3D > force;
+      std::vector< int > type;
+      std::vector< Particle* > particle;
+
+    private:
+      const Cell *firstCell;
+      /// the cells in layout order
+      CellList cells;
+      /// index range of the cells, by offset in the storage's cell array
+      std::vector< longint > cellOffset, cellEndOffset;
+      std::vector< std::vector< Real3D > > threadForce;
+      int layoutVersion;
+      int maxType;
+
+      bool layoutMatches() const;
+      void fill();
+
+      static LOG4ESPP_DECL_LOGGER(logger);
+    };
+  }
+}
+#endif
@@ -37,6 +37,11 @@
 #include "esutil/Error.hpp"
 
 #include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 #include <boost/unordered/unordered_map.hpp>
 using namespace std;
 
@@ -56,7 +61,9 @@ namespace espressopp {
     Storage::Storage(shared_ptr< System > system)
       : SystemAccess(system),
         inBuffer(*system->comm),
-        outBuffer(*system->comm)
+        outBuffer(*system->comm),
+        recordChanges(false),
+        changesKnown(false)
     {
       //logger.setLevel(log4espp::Logger::TRACE);
       LOG4ESPP_INFO(logger, "Created new storage object for a system, has buffers");
@@ -76,6 +83,14 @@ namespace espressopp {
       return cnt;
     }
     
+    real Storage::getMinCellSize() {
+      Int3D cellGrid = getInt3DCellGrid();
+      real size[3] = { (getLocalBoxXMax() - getLocalBoxXMin()) / cellGrid[0],
+                       (getLocalBoxYMax() - getLocalBoxYMin()) / cellGrid[1],
+                       (getLocalBoxZMax() - getLocalBoxZMin()) / cellGrid[2] };
+      return std::min(size[0], std::min(size[1], size[2]));
+    }
+
     longint Storage::getNLocalParticles() const {
       longint cnt = 0;
       for (CellList::const_iterator it = localCells.begin(), end = localCells.end(); it != end; ++it) {
@@ -111,6 +126,274 @@ namespace espressopp {
       return pids;
     }
 
+    longint Storage::importParticles(const ParticleImport &in) {
+      const mpi::communicator &comm = *getSystem()->comm;
+      const longint n = in.n;
+
+      // all id checks in one collective: ids given twice (checked on one
+      // CPU, the input is the same everywhere) or present on any CPU
+      longint conflicts = 0;
+      if (comm.rank() == 0) {
+        std::vector< longint > ids(in.id, in.id + n);
+        std::sort(ids.begin(), ids.end());
+        for (longint i = 1; i < n; ++i) {
+          if (ids[i] == ids[i - 1]) ++conflicts;
+        }
+      }
+      for (longint i = 0; i < n; ++i) {
+        if (lookupRealParticle(in.id[i])) ++conflicts;
+      }
+      longint totalConflicts;
+      mpi::all_reduce(comm, conflicts, totalConflicts, std::plus< longint >());
+      if (totalConflicts > 0) {
+        std::ostringstream msg;
+        msg << "importParticles: " << totalConflicts
+            << " particle ids are given twice or exist already, no particle was added";
+        throw std::runtime_error(msg.str());
+      }
+
+      // keep the particles of this domain
+      std::vector< longint > mine;
+      for (longint i = 0; i < n; ++i) {
+        const real *p = in.pos + 3 * i;
+        if (checkIsRealParticle(in.id[i], Real3D(p[0], p[1], p[2]))) mine.push_back(i);
+      }
+
+      for (std::vector< longint >::const_iterator it = mine.begin(); it != mine.end(); ++it) {
+        const longint i = *it;
+        Particle pt;
+        pt.init();
+        pt.id() = in.id[i];
+        pt.position() = Real3D(in.pos[3 * i], in.pos[3 * i + 1], in.pos[3 * i + 2]);
+        pt.image() = Int3D(0);
+        if (in.v) pt.velocity() = Real3D(in.v[3 * i], in.v[3 * i + 1], in.v[3 * i + 2]);
+        if (in.f) pt.force() = Real3D(in.f[3 * i], in.f[3 * i + 1], in.f[3 * i + 2]);
+        if (in.type) pt.type() = in.type[i];
+        if (in.state) pt.state() = in.state[i];
+        if (in.mass) pt.mass() = in.mass[i];
+        if (in.q) pt.q() = in.q[i];
+        if (in.radius) pt.radius() = in.radius[i];
+        if (in.fradius) pt.fradius() = in.fradius[i];
+        if (in.vradius) pt.vradius() = in.vradius[i];
+        if (in.lambda_adr) pt.lambda() = in.lambda_adr[i];
+        if (in.lambda_adrd) pt.lambdaDeriv() = in.lambda_adrd[i];
+        getSystem()->bc->foldPosition(pt.position(), pt.image());
+        appendIndexedParticle(mapPositionToCellClipped(pt.position())->particles, pt);
+      }
+
+      LOG4ESPP_INFO(logger, "imported " << mine.size() << " of " << n << " particles");
+
+      longint added = mine.size(), totalAdded;
+      mpi::all_reduce(comm, added, totalAdded, std::plus< longint >());
+      return totalAdded;
+    }
+
+    namespace {
+      /* The columns of an import by property name, see Storage.py.
+         Vectors have 3 numbers, the other properties 1. */
+      struct ImportColumns {
+        std::vector< longint > id;
+        std::vector< int > type, state;
+        std::vector< real > pos, v, f, mass, q, radius, fradius, vradius, lambda_adr, lambda_adrd;
+
+        static int width(const std::string &name) {
+          return (name == "pos" || name == "v" || name == "f") ? 3 : 1;
+        }
+
+        std::vector< real > *realColumn(const std::string &name) {
+          if (name == "pos") return &pos;
+          if (name == "v") return &v;
+          if (name == "f") return &f;
+          if (name == "mass") return &mass;
+          if (name == "q") return &q;
+          if (name == "radius") return &radius;
+          if (name == "fradius") return &fradius;
+          if (name == "vradius") return &vradius;
+          if (name == "lambda_adr") return &lambda_adr;
+          if (name == "lambda_adrd") return &lambda_adrd;
+          return 0;
+        }
+
+        std::vector< int > *intColumn(const std::string &name) {
+          if (name == "type") return &type;
+          if (name == "state") return &state;
+          return 0;
+        }
+
+        static void checkName(const std::string &name) {
+          if (name != "id" && !ImportColumns().realColumn(name) && !ImportColumns().intColumn(name)) {
+            throw std::runtime_error("importParticles: unknown particle property " + name);
+          }
+        }
+
+        template < class T >
+        static const T *data(const std::vector< T > &c, longint n, int w, const char *name) {
+          if (c.empty()) return 0;
+          if (longint(c.size()) != n * w) {
+            std::ostringstream msg;
+            msg << "importParticles: property " << name << " has " << c.size() / w
+                << " entries, but there are " << n << " particles";
+            throw std::runtime_error(msg.str());
+          }
+          return &c[0];
+        }
+
+        ParticleImport get() const {
+          ParticleImport in;
+          if (id.empty()) return in;
+          if (pos.empty()) {
+            throw std::runtime_error("importParticles: particle properties id and pos are mandatory");
+          }
+          in.n = id.size();
+          in.id = &id[0];
+          in.pos = data(pos, in.n, 3, "pos");
+          in.v = data(v, in.n, 3, "v");
+          in.f = data(f, in.n, 3, "f");
+          in.type = data(type, in.n, 1, "type");
+          in.state = data(state, in.n, 1, "state");
+          in.mass = data(mass, in.n, 1, "mass");
+          in.q = data(q, in.n, 1, "q");
+          in.radius = data(radius, in.n, 1, "radius");
+          in.fradius = data(fradius, in.n, 1, "fradius");
+          in.vradius = data(vradius, in.n, 1, "vradius");
+          in.lambda_adr = data(lambda_adr, in.n, 1, "lambda_adr");
+          in.lambda_adrd = data(lambda_adrd, in.n, 1, "lambda_adrd");
+          return in;
+        }
+      };
+
+      template < class T, class S >
+      void copyItems(const void *buf, Py_ssize_t count, std::vector< T > &out) {
+        const S *s = static_cast< const S* >(buf);
+        out.resize(count);
+        for (Py_ssize_t i = 0; i < count; ++i) out[i] = T(s[i]);
+      }
+
+      /* Copies the numbers of obj to out: from its buffer if it has one
+         (e.g. a NumPy array, in C order), else from a sequence of numbers
+         or, for width 3, of sequences of 3 numbers. */
+      template < class T >
+      void readColumn(python::object obj, int width, std::vector< T > &out) {
+        PyObject *o = obj.ptr();
+        if (PyObject_CheckBuffer(o)) {
+          Py_buffer view;
+          if (PyObject_GetBuffer(o, &view, PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) != 0) {
+            python::throw_error_already_set();
+          }
+          const Py_ssize_t count = view.len / view.itemsize;
+          // the type code is the last character, after byte order marks
+          const char code = view.format ? view.format[strlen(view.format) - 1] : 'B';
+          bool known = true;
+          switch (code) {
+          case 'd': copyItems< T, double >(view.buf, count, out); break;
+          case 'f': copyItems< T, float >(view.buf, count, out); break;
+          case 'b': copyItems< T, signed char >(view.buf, count, out); break;
+          case 'B': copyItems< T, unsigned char >(view.buf, count, out); break;
+          case 'h': copyItems< T, short >(view.buf, count, out); break;
+          case 'i': copyItems< T, int >(view.buf, count, out); break;
+          case 'I': copyItems< T, unsigned int >(view.buf, count, out); break;
+          case 'l': copyItems< T, long >(view.buf, count, out); break;
+          case 'L': copyItems< T, unsigned long >(view.buf, count, out); break;
+          case 'q': copyItems< T, long long >(view.buf, count, out); break;
+          case 'Q': copyItems< T, unsigned long long >(view.buf, count, out); break;
+          default: known = false;
+          }
+          PyBuffer_Release(&view);
+          if (!known) {
+            throw std::runtime_error(std::string("importParticles: unsupported array type ") + code);
+          }
+          return;
+        }
+
+        const long n = python::len(obj);
+        out.resize(n * width);
+        for (long i = 0; i < n; ++i) {
+          if (width == 1) {
+            out[i] = python::extract< T >(obj[i]);
+          } else {
+            python::object item = obj[i];
+            for (int k = 0; k < width; ++k) out[i * width + k] = python::extract< T >(item[k]);
+          }
+        }
+      }
+    }
+
+    longint Storage::pyImportParticles(python::object id, python::object pos,
+                                       python::dict properties) {
+      ImportColumns columns;
+      readColumn(id, 1, columns.id);
+      readColumn(pos, 3, columns.pos);
+
+      python::list names = properties.keys();
+      for (long k = 0; k < python::len(names); ++k) {
+        std::string name = python::extract< std::string >(names[k]);
+        ImportColumns::checkName(name);
+        if (name == "id" || name == "pos") {
+          throw std::runtime_error("importParticles: id and pos are given as arguments");
+        }
+        if (std::vector< real > *rc = columns.realColumn(name)) {
+          readColumn(properties[name], ImportColumns::width(name), *rc);
+        } else if (std::vector< int > *ic = columns.intColumn(name)) {
+          readColumn(properties[name], 1, *ic);
+        }
+      }
+      return importParticles(columns.get());
+    }
+
+    longint Storage::importParticlesFromFile(const std::string &filename,
+                                             python::list properties) {
+      std::vector< std::string > names;
+      for (long k = 0; k < python::len(properties); ++k) {
+        names.push_back(python::extract< std::string >(properties[k]));
+        ImportColumns::checkName(names.back());
+      }
+
+      // every CPU reads the whole file, which also keeps the input the
+      // same everywhere
+      std::ifstream file(filename.c_str());
+      if (!file) throw std::runtime_error("importParticles: cannot open " + filename);
+
+      ImportColumns columns;
+      std::string line;
+      longint lineNo = 0;
+      while (std::getline(file, line)) {
+        ++lineNo;
+        std::istringstream fields(line);
+        std::string first;
+        if (!(fields >> first) || first[0] == '#') continue;
+        fields.clear();
+        fields.str(line);
+
+        for (size_t k = 0; k < names.size(); ++k) {
+          const std::string &name = names[k];
+          bool ok = true;
+          if (name == "id") {
+            longint v;
+            ok = bool(fields >> v);
+            columns.id.push_back(v);
+          } else if (std::vector< int > *ic = columns.intColumn(name)) {
+            int v;
+            ok = bool(fields >> v);
+            ic->push_back(v);
+          } else {
+            std::vector< real > *rc = columns.realColumn(name);
+            for (int w = 0; w < ImportColumns::width(name) && ok; ++w) {
+              real v;
+              ok = bool(fields >> v);
+              rc->push_back(v);
+            }
+          }
+          if (!ok) {
+            std::ostringstream msg;
+            msg << "importParticles: " << filename << ", line " << lineNo
+                << ": cannot read property " << name;
+            throw std::runtime_error(msg.str());
+          }
+        }
+      }
+      return importParticles(columns.get());
+    }
+
     // TODO find out why python crashes if inlined
     //inline
     void Storage::removeFromLocalParticles(Particle *p, bool weak) {
@@ -124,6 +407,7 @@ namespace espressopp {
         LOG4ESPP_TRACE(logger, "removing local pointer for particle id="
                   << p->id() << " @ " << p);
         localParticles.erase(p->id());
+        if (recordChanges && !weak) changedParticles.insert(p->id());
       }
       else {
         LOG4ESPP_TRACE(logger, "NOT removing local pointer for particle id="
@@ -193,6 +477,7 @@ namespace espressopp {
 
 
           localParticles[p->id()] = p;
+          if (recordChanges && !weak) changedParticles.insert(p->id());
 
           /*
           // AdResS testing TODO
@@ -297,6 +582,7 @@ namespace espressopp {
         
         updateLocalParticles( cell->particles );
 
+        rebuildParticleArrays();
         onParticlesChanged();
         Particle* p1 = lookupRealParticle(id);
         if(p1){
@@ -317,6 +603,7 @@ namespace espressopp {
       for (CellList::iterator it = localCells.begin(), end = localCells.end(); it != end; ++it) {
         (*it)->particles.clear();
       }
+      rebuildParticleArrays();
       onParticlesChanged();
     }
     
@@ -552,13 +839,34 @@ namespace espressopp {
       }
     }
 
+    namespace {
+      // sets a flag for the lifetime of the object, also if an exception is thrown
+      struct FlagScope {
+        bool &flag;
+        FlagScope(bool &_flag) : flag(_flag) { flag = true; }
+        ~FlagScope() { flag = false; }
+      };
+    }
+
     void Storage::decompose() {
-      invalidateGhosts();
-      decomposeRealParticles();
-      exchangeGhosts();
+      changedParticles.clear();
+      {
+        FlagScope recording(recordChanges);
+        invalidateGhosts();
+        decomposeRealParticles();
+        exchangeGhosts();
+        rebuildParticleArrays();
+      }
+      FlagScope known(changesKnown);
       onParticlesChanged();
     }
 
+    void Storage::rebuildParticleArrays() {
+      if (particleArrays) {
+        particleArrays->build(getFirstCell(), localCells);
+      }
+    }
+
     void Storage::packPositionsEtc(OutBuffer &buf,
 				   Cell &_reals, int extradata, const Real3D& shift) {
       ParticleList &reals  = _reals.particles;
@@ -764,6 +1072,8 @@ namespace espressopp {
 	    .def("lookupRealParticle", &Storage::lookupRealParticle, return_value_policy< reference_existing_object >())
 	    .def("decompose", &Storage::decompose)
 	    .def("getRealParticleIDs", &Storage::getRealParticleIDs)
+	    .def("importParticles", &Storage::pyImportParticles)
+	    .def("importParticlesFromFile", &Storage::importParticlesFromFile)
         .add_property("system", &Storage::getSystem)
 	    ;
     }
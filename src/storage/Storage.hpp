@@ -28,17 +28,34 @@
 #include "mpi.hpp"
 //#include <vector>
 #include <boost/unordered_map.hpp>
+#include <boost/unordered_set.hpp>
 #include <boost/signals2.hpp>
 #include <list>
 #include "log4espp.hpp"
 #include "FixedTupleListAdress.hpp"
 #include "Cell.hpp"
 #include "Buffer.hpp"
+#include "ParticleArrays.hpp"
 #include "types.hpp"
 
 namespace espressopp {
 
   namespace storage {
+    /** Particle data for Storage::importParticles(): n particles as
+        contiguous arrays, vectors as 3 consecutive reals. id and pos
+        are mandatory, properties left 0 keep their default values. */
+    struct ParticleImport {
+      longint n;
+      const longint *id;
+      const real *pos, *v, *f;
+      const int *type, *state;
+      const real *mass, *q, *radius, *fradius, *vradius, *lambda_adr, *lambda_adrd;
+
+      ParticleImport()
+        : n(0), id(0), pos(0), v(0), f(0), type(0), state(0), mass(0), q(0),
+          radius(0), fradius(0), vradius(0), lambda_adr(0), lambda_adrd(0) {}
+    };
+
     /** represents the particle storage of one system. */
     class Storage : public SystemAccess {
     public:
@@ -59,7 +76,8 @@ namespace espressopp {
        *  Anisotropic case */
       virtual void scaleVolume(Real3D s, bool pS) = 0;
       
-      /** It should be used at the place where is the possibility of cell size<cutoff+skin*/
+      /** It should be used at the place where is the possibility of cell size<cutoff+skin.
+          Redistributes the particles like decompose(). */
       virtual void cellAdjust() = 0;
       
       /** It should return cell grid as an integer vector*/
@@ -72,6 +90,10 @@ namespace espressopp {
       virtual real getLocalBoxYMax() =0;
       virtual real getLocalBoxZMax() =0;
 
+      /** smallest edge length of the local cells; all pairs closer than
+          this are found between a cell and its neighbor cells. */
+      real getMinCellSize();
+
       /** add a particle with given id and position. Note that this is a
 	  local operation, and therefore cannot check whether a particle
 	  with the given id already exists.  This is left to the parallel
@@ -170,8 +192,31 @@ namespace espressopp {
 
       python::list getRealParticleIDs();
 
+      /** Bulk import of in.n particles. All CPUs have to call this with
+          the same particles, each one keeps the particles in its domain.
+          Fails on all CPUs, without adding any particle, if an id is
+          given twice or exists already. Returns the number of particles
+          added on all CPUs. */
+      longint importParticles(const ParticleImport &in);
+
+      /** importParticles() from Python, for arrays (anything with the
+          buffer interface, like NumPy arrays, or sequences) and for a
+          text file with one particle per line, see Storage.py */
+      longint pyImportParticles(python::object id, python::object pos,
+                                python::dict properties);
+      longint importParticlesFromFile(const std::string &filename,
+                                      python::list properties);
+
       const Cell* getFirstCell() const { return &(cells[0]); }
 
+      /** whether the storage keeps a structure-of-arrays copy of the
+          local particles for the force kernels */
+      bool hasParticleArrays() const { return bool(particleArrays); }
+
+      /** the structure-of-arrays copy of the local particles; only
+          valid if hasParticleArrays() */
+      ParticleArrays &getParticleArrays() { return *particleArrays; }
+
       /** map a position to a valid cell on this node. Used for AdResS */
       virtual Cell* mapPositionToCell(const Real3D& pos) = 0;
 
@@ -211,6 +256,18 @@ namespace espressopp {
       */
       virtual void updateGhosts() = 0;
 
+      /** split form of updateGhosts() that allows overlapping the
+          communication with computation. beginUpdateGhosts() starts
+          the update; afterwards the positions of all real particles
+          are current, also in the particle arrays, but the ghosts are
+          not before finishUpdateGhosts() returned. By default, the
+          whole update is done in beginUpdateGhosts().
+      */
+      virtual void beginUpdateGhosts() { updateGhosts(); }
+
+      /** complete the update started by beginUpdateGhosts() */
+      virtual void finishUpdateGhosts() {}
+
 
       /**
        * Copies just velocites of real particles to their ghosts.
@@ -233,6 +290,19 @@ namespace espressopp {
 	  lookupLocalParticle() and lookupRealParticle().
        */
       boost::signals2::signal0 <void> onParticlesChanged;
+
+      /** While onParticlesChanged is emitted at the end of decompose(),
+	  this returns the ids of the real particles whose pointers have
+	  changed during the decompose(), because they were moved within
+	  the cells, received or sent away. The pointers to all other real
+	  particles are still valid, so that lists of particles only have
+	  to look up these and the ghosts again. For any other emission of
+	  onParticlesChanged this returns 0, all pointers are invalid then.
+       */
+      const boost::unordered_set<longint>* getChangedParticles() const {
+        return changesKnown ? &changedParticles : 0;
+      }
+
       boost::signals2::signal2 <void, ParticleList&, class OutBuffer&> 
         beforeSendParticles;
       boost::signals2::signal2 <void, ParticleList&, class InBuffer&> 
@@ -296,6 +366,9 @@ namespace espressopp {
       /// remove ghost particles from the localParticles index
       virtual void invalidateGhosts();
 
+      /// rebuild the particle arrays, if any, after the particles were redistributed
+      void rebuildParticleArrays();
+
       /** pack real particle data for sending. At least positions, maybe
 	  shifted, and possibly additional data according to extradata.
 
@@ -388,6 +461,9 @@ namespace espressopp {
       /** here the local particles are actually stored */
       LocalCellList cells;
 
+      /** structure-of-arrays copy of the local particles, 0 if not used */
+      shared_ptr< ParticleArrays > particleArrays;
+
       /** list of real cells */
       CellList realCells;
       /** list of ghost cells */
@@ -418,6 +494,10 @@ namespace espressopp {
       // map particle id to Particle * for all particles on this node
       boost::unordered_map<longint, Particle*> localParticles;
 
+      // real particles that changed their pointer, see getChangedParticles()
+      boost::unordered_set<longint> changedParticles;
+      bool recordChanges, changesKnown;
+
 
       // AdResS atomistic particles (they are not stored in cells!)
       ParticleList AdrATParticles; // local atomistic real adress particles
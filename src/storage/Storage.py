@@ -75,6 +75,26 @@ All derived classes implement at least the following methods:
    
    >>> addParticles([[id, pos, type, ... ], ...], 'id', 'pos', 'type', ...)
 
+* `importParticles(ids, pos, **properties)`:
+
+   Bulk version of addParticles for large systems, done in C++. ids, pos
+   and the properties are arrays of all particles, preferably NumPy
+   arrays (pos, v and f of shape (N, 3)), but sequences work as well.
+   Every CPU keeps the particles in its domain. If an id is given twice
+   or exists already, no particle is added at all. AdResS particles are
+   not supported. Returns the number of particles added.
+
+   >>> importParticles(ids, pos, type=types, mass=masses, v=velocities)
+
+* `importParticlesFromFile(filename, *properties)`:
+
+   Like importParticles, but every CPU reads the particles from a text
+   file with one particle per line, in the columns given by properties
+   (3 columns for pos, v and f). Empty lines and lines starting with #
+   are skipped.
+
+   >>> importParticlesFromFile('conf.txt', 'id', 'type', 'pos')
+
 * `modifyParticle(pid, property, value, decompose='yes')`
     
    This routine allows to modify any properties of an already existing particle.
@@ -349,6 +369,16 @@ class StorageLocal(object):
                     if index_state >= 0:
                         storedParticle.state = particle[index_state]
  
+    def importParticles(self, ids, pos, **properties):
+        if not (pmi._PMIComm and pmi._PMIComm.isActive()) or pmi._MPIcomm.rank in pmi._PMIComm.getMPIcpugroup():
+            return self.cxxclass.importParticles(self, ids, pos, properties)
+
+    def importParticlesFromFile(self, filename, *properties):
+        if not (pmi._PMIComm and pmi._PMIComm.isActive()) or pmi._MPIcomm.rank in pmi._PMIComm.getMPIcpugroup():
+            if len(properties) == 0:
+                properties = ('id', 'pos')
+            return self.cxxclass.importParticlesFromFile(self, filename, [val.lower() for val in properties])
+
     def modifyParticle(self, pid, property, value):
         if not (pmi._PMIComm and pmi._PMIComm.isActive()) or pmi._MPIcomm.rank in pmi._PMIComm.getMPIcpugroup():
           
@@ -409,7 +439,7 @@ if pmi.isController:
     class Storage(object):
         __metaclass__ = pmi.Proxy
         pmiproxydefs = dict(
-            pmicall = [ "decompose", "addParticles", "setFixedTuplesAdress", "removeAllParticles"],
+            pmicall = [ "decompose", "addParticles", "importParticles", "importParticlesFromFile", "setFixedTuplesAdress", "removeAllParticles"],
             pmiproperty = [ "system" ],
             pmiinvoke = ["getRealParticleIDs", "printRealParticles"]
             )
@@ -487,3 +487,117 @@ BOOST_AUTO_TEST_CASE(migrateParticle)
   if (mpiWorld->rank() == lastnode)
     BOOST_CHECK(afterResortCalled);
 }
+
+BOOST_AUTO_TEST_CASE(balanceLoad) 
+{
+  // all particles are in the left half of the box, after balancing
+  // every node should own about the same number of them
+  shared_ptr< DomainDecomposition > domdec;
+  shared_ptr< System > system;
+
+  int nodes = mpiWorld->size();
+  Real3D boxL(nodes*4.0, 1.0, 1.0);
+  Int3D nodeGrid(nodes, 1, 1);
+  Int3D cellGrid(1);
+
+  system = make_shared< System >();
+  system->rng = make_shared< esutil::RNG >();
+  system->bc = make_shared< bc::OrthorhombicBC >(system->rng, boxL);
+  system->setSkin(0.3);
+  system->maxCutoff = 0.0;
+  domdec = make_shared< DomainDecomposition >(system,
+					      nodeGrid,
+					      cellGrid);
+
+  int n = 10*nodes;
+  if (mpiWorld->rank() == 0) {
+    for (int i = 0; i < n; ++i) {
+      Real3D pos((i + 0.5)*2.0/10, 0.5, 0.5);
+      domdec->addParticle(i, pos);
+    }
+  }
+  domdec->decompose();
+
+  BOOST_CHECK_EQUAL(domdec->balanceLoad(), nodes > 1);
+  BOOST_CHECK_EQUAL(domdec->getNRealParticles(), 10);
+  BOOST_CHECK_CLOSE(domdec->getLoadImbalance(), 1.0, 1e-10);
+
+  // the boundaries are final, the particles stay where they are
+  BOOST_CHECK(!domdec->balanceLoad());
+
+  for (int i = 0; i < n; ++i) {
+    Real3D pos((i + 0.5)*2.0/10, 0.5, 0.5);
+    bool mine = (domdec->mapPositionToNodeClipped(pos) == mpiWorld->rank());
+    BOOST_CHECK_EQUAL(domdec->lookupRealParticle(i) != 0, mine);
+  }
+}
+
+// Morton key of a position as DomainDecomposition::sortParticlesInCells computes it
+static boost::uint64_t mortonKeyOf(const CellGrid &grid, const Real3D &pos)
+{
+  boost::uint64_t key = 0;
+  for (int i = 0; i < 3; ++i) {
+    real x = (pos[i] - grid.getMyLeft(i)) * 1024 * grid.getInverseCellSize(i);
+    boost::uint64_t q = (x <= 0) ? 0 : std::min(boost::uint64_t(x), boost::uint64_t(0x1fffff));
+    for (int b = 0; b < 21; ++b) {
+      key |= ((q >> b) & 1) << (3*b + i);
+    }
+  }
+  return key;
+}
+
+BOOST_AUTO_TEST_CASE(mortonOrder) 
+{
+  // sorting the particles within the cells has to keep the index intact
+  shared_ptr< DomainDecomposition > domdec;
+  shared_ptr< System > system;
+
+  Real3D boxL(4.0, 4.0, 4.0);
+  Int3D nodeGrid(mpiWorld->size(), 1, 1);
+  Int3D cellGrid(1, 2, 2);
+
+  system = make_shared< System >();
+  system->rng = make_shared< esutil::RNG >();
+  system->bc = make_shared< bc::OrthorhombicBC >(system->rng, boxL);
+  domdec = make_shared< DomainDecomposition >(system,
+					      nodeGrid,
+					      cellGrid);
+
+  int n = 200;
+  if (mpiWorld->rank() == 0) {
+    for (int i = 0; i < n; ++i) {
+      Real3D pos(4.0*(*system->rng)(), 4.0*(*system->rng)(), 4.0*(*system->rng)());
+      domdec->addParticle(i, pos);
+    }
+  }
+  domdec->decompose();
+  real unorderedDistance = domdec->getOrderDistance();
+
+  domdec->setMortonOrder(true);
+  domdec->decompose();
+
+  longint found = 0;
+  for (int i = 0; i < n; ++i) {
+    Particle *p = domdec->lookupRealParticle(i);
+    if (p) {
+      BOOST_CHECK_EQUAL(p->id(), i);
+      ++found;
+    }
+  }
+  BOOST_CHECK_EQUAL(found, domdec->getNRealParticles());
+
+  // the particles follow the Morton curve within each cell
+  const CellGrid &grid = domdec->getCellGrid();
+  CellList &realCells = domdec->getRealCells();
+  for (CellList::Iterator it(realCells); it.isValid(); ++it) {
+    ParticleList &pl = (*it)->particles;
+    for (size_t p = 1; p < pl.size(); ++p) {
+      BOOST_CHECK(mortonKeyOf(grid, pl[p - 1].position()) <= mortonKeyOf(grid, pl[p].position()));
+    }
+  }
+
+  // and particles close in memory are closer in space than before
+  real orderedDistance = domdec->getOrderDistance();
+  BOOST_CHECK(orderedDistance > 0.0);
+  BOOST_CHECK(orderedDistance <= unorderedDistance);
+}
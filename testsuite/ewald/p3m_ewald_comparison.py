@@ -0,0 +1,101 @@
+'''
+#  This script compares the forces and the energy of the P3M method with the Ewald summation
+#  for the system of 'ini_struct_deserno.dat' (see ewald_eppDeserno_comparison.py).
+#
+#  Both systems use the same Ewald parameter and the same R space part, so the differences come
+#  from the K space part only. With a fine mesh and a high charge assignment order, P3M has to
+#  reproduce the Ewald result, independent of the number of CPUs the mesh is distributed over.
+'''
+
+import sys
+import mpi4py.MPI as MPI
+import espressopp
+
+from espressopp import Real3D
+from espressopp.tools.convert import espresso_old
+
+Lx, Ly, Lz, x, y, z, type, q, vx,vy,vz,fx,fy,fz,bondpairs = espresso_old.read('ini_struct_deserno.dat')
+
+box = (Lx, Ly, Lz)
+num_particles = len(x)
+
+# Ewald parameters, as in ewald_eppDeserno_comparison.py
+alpha          = 1.112583061
+rspacecutoff   = 4.9
+kspacecutoff   = 30
+
+# P3M parameters
+M              = espressopp.Int3D(32, 32, 32)
+P              = 7
+
+skin           = 0.09
+coulomb_prefactor = 1.0
+
+# tolerances for the largest force difference and the relative energy difference
+force_tolerance  = 1e-3
+energy_tolerance = 1e-4
+
+nodeGrid       = espressopp.tools.decomp.nodeGrid(MPI.COMM_WORLD.size)
+cellGrid       = espressopp.tools.decomp.cellGrid(box, nodeGrid, rspacecutoff, skin)
+
+props = ['id', 'pos', 'type', 'q']
+new_particles = []
+for i in range(0, num_particles):
+  part = [ i, Real3D(x[i], y[i], z[i]), type[i], q[i] ]
+  new_particles.append(part)
+
+# creates a system with the R space part of the Coulomb interaction
+def createSystem():
+  system         = espressopp.System()
+  system.rng     = espressopp.esutil.RNG()
+  system.bc      = espressopp.bc.OrthorhombicBC(system.rng, box)
+  system.skin    = skin
+  system.storage = espressopp.storage.DomainDecomposition(system, nodeGrid, cellGrid)
+  system.storage.addParticles(new_particles, *props)
+  system.storage.decompose()
+
+  vl = espressopp.VerletList(system, rspacecutoff+skin)
+  coulombR_pot = espressopp.interaction.CoulombRSpace(coulomb_prefactor, alpha, rspacecutoff)
+  coulombR_int = espressopp.interaction.VerletListCoulombRSpace(vl)
+  coulombR_int.setPotential(type1=0, type2=0, potential = coulombR_pot)
+  system.addInteraction(coulombR_int)
+  return system, coulombR_int
+
+# Ewald system
+systemEwald, coulombR_intEwald = createSystem()
+ewaldK_pot = espressopp.interaction.CoulombKSpaceEwald(systemEwald, coulomb_prefactor, alpha, kspacecutoff)
+ewaldK_int = espressopp.interaction.CellListCoulombKSpaceEwald(systemEwald.storage, ewaldK_pot)
+systemEwald.addInteraction(ewaldK_int)
+
+# P3M system
+systemP3M, coulombR_intP3M = createSystem()
+p3m_pot = espressopp.interaction.CoulombKSpaceP3M(systemP3M, coulomb_prefactor, alpha, M, P, rspacecutoff)
+p3m_int = espressopp.interaction.CellListCoulombKSpaceP3M(systemP3M.storage, p3m_pot)
+systemP3M.addInteraction(p3m_int)
+
+# nothing will be changed in the systems, just the forces are calculated once
+integratorEwald    = espressopp.integrator.VelocityVerlet(systemEwald)
+integratorEwald.dt = 0.0001
+integratorEwald.run(0)
+
+integratorP3M      = espressopp.integrator.VelocityVerlet(systemP3M)
+integratorP3M.dt   = 0.0001
+integratorP3M.run(0)
+
+max_df = 0.0
+for j in range(0, num_particles):
+  fEwald = systemEwald.storage.getParticle(j).f
+  fP3M   = systemP3M.storage.getParticle(j).f
+  max_df = max(max_df, abs(fEwald.x - fP3M.x), abs(fEwald.y - fP3M.y), abs(fEwald.z - fP3M.z))
+
+enEwald = coulombR_intEwald.computeEnergy() + ewaldK_int.computeEnergy()
+enP3M   = coulombR_intP3M.computeEnergy() + p3m_int.computeEnergy()
+rel_de  = abs(enEwald - enP3M) / abs(enEwald)
+
+print 'largest force difference: %g, relative energy difference: %g' % (max_df, rel_de)
+
+if max_df > force_tolerance or rel_de > energy_tolerance:
+  print 'P3M does not agree with the Ewald summation'
+  sys.exit(1)
+
+sys.exit()